@@ -680,6 +680,7 @@ __all__ = [
     'LineSymbolizer',
     'Map',
     'MarkersSymbolizer',
+    'Metatile',
     'Names',
     'Parameter',
     'Parameters',
@@ -692,6 +693,7 @@ __all__ = [
     'Query',
     'RasterSymbolizer',
     'RasterColorizer',
+    'RenderStats',
     'Rule', 'Rules',
     'ShieldSymbolizer',
     'Singleton',
@@ -742,6 +744,7 @@ __all__ = [
     'save_map',
     'save_map_to_string',
     'render',
+    'render_with_stats',
     'render_tile_to_file',
     'render_to_file',
     #   other
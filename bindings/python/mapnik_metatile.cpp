@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+// boost
+#include <boost/python.hpp>
+
+// mapnik
+#include <mapnik/metatile.hpp>
+
+using mapnik::metatile;
+
+namespace {
+void render(metatile & meta, double scale_factor)
+{
+    Py_BEGIN_ALLOW_THREADS
+        try
+        {
+            meta.render(scale_factor);
+        }
+        catch (...)
+        {
+            Py_BLOCK_THREADS
+                throw;
+        }
+    Py_END_ALLOW_THREADS
+}
+
+void render_default(metatile & meta)
+{
+    render(meta, 1.0);
+}
+
+// encoded tile, as bytes.
+PyObject* encode(metatile const& meta, unsigned column, unsigned row, std::string const& format)
+{
+    std::string s = meta.encode(column, row, format);
+    return 
+#if PY_VERSION_HEX >= 0x03000000
+        ::PyBytes_FromStringAndSize
+#else
+        ::PyString_FromStringAndSize
+#endif
+        (s.data(),s.size());
+}
+}
+
+void export_metatile()
+{
+    using namespace boost::python;
+
+    class_<metatile, boost::noncopyable>("Metatile",
+                                         "Image of a map, rendered once and split into tiles.\n"
+                                         "The map's buffer size is rendered around the image, so that labels\n"
+                                         "are not cut at the edges of the tiles.\n"
+                                         "\n"
+                                         "Usage:\n"
+                                         ">>> from mapnik import Map, Metatile, load_map\n"
+                                         ">>> m = Map(1024,1024)\n"
+                                         ">>> load_map(m,'mapfile.xml')\n"
+                                         ">>> m.buffer_size = 128\n"
+                                         ">>> meta = Metatile(m,4,4)\n"
+                                         ">>> meta.render()\n"
+                                         ">>> png = meta.encode(0,0,'png')\n",
+                                         init<mapnik::Map const&, unsigned, unsigned>(
+                                             (arg("map"), arg("columns"), arg("rows")))
+                                         [with_custodian_and_ward<1,2>()])
+        .add_property("columns", &metatile::columns)
+        .add_property("rows", &metatile::rows)
+        .add_property("margin", &metatile::margin,
+                      "Margin around the map in the image, in pixels.")
+        .def("render", &render,
+             (arg("scale_factor")),
+             "Render the map.")
+        .def("render", &render_default)
+        .def("tile", &metatile::tile,
+             with_custodian_and_ward_postcall<0,1>(),
+             (arg("column"), arg("row")),
+             "View of a tile of the rendered image.\n"
+             "Raises IndexError if there is no tile at 'column' and 'row'.")
+        .def("encode", &encode,
+             (arg("column"), arg("row"), arg("format")),
+             "Encode a tile, to 'png' or 'jpeg' for instance.\n"
+             "Raises IndexError if there is no tile at 'column' and 'row'.")
+        ;
+}
@@ -63,6 +63,8 @@ void export_view_transform();
 void export_raster_colorizer();
 void export_glyph_symbolizer();
 void export_inmem_metawriter();
+void export_render_stats();
+void export_metatile();
 
 #include <mapnik/version.hpp>
 #include <mapnik/map.hpp>
@@ -76,6 +78,7 @@ void export_inmem_metawriter();
 #include <mapnik/config_error.hpp>
 #include <mapnik/value_error.hpp>
 #include <mapnik/save_map.hpp>
+#include <mapnik/render_stats.hpp>
 
 #if defined(HAVE_CAIRO) && defined(HAVE_PYCAIRO)
 #include <pycairo.h>
@@ -98,6 +101,25 @@ void render(const mapnik::Map& map,mapnik::image_32& image, double scale_factor
     Py_END_ALLOW_THREADS
         }
 
+mapnik::render_stats render_with_stats(const mapnik::Map& map,mapnik::image_32& image, double scale_factor = 1.0 , unsigned offset_x = 0u , unsigned offset_y = 0u)
+{
+    mapnik::render_stats stats;
+    Py_BEGIN_ALLOW_THREADS
+        try
+        {
+            mapnik::agg_renderer<mapnik::image_32> ren(map,image,scale_factor,offset_x, offset_y);
+            ren.set_render_stats(&stats);
+            ren.apply();
+        }
+        catch (...)
+        {
+            Py_BLOCK_THREADS
+                throw;
+        }
+    Py_END_ALLOW_THREADS
+    return stats;
+}
+
 #if defined(HAVE_CAIRO) && defined(HAVE_PYCAIRO)
 
 void render3(const mapnik::Map& map,PycairoSurface* surface, unsigned offset_x = 0, unsigned offset_y = 0)
@@ -315,6 +337,7 @@ BOOST_PYTHON_FUNCTION_OVERLOADS(load_map_string_overloads, load_map_string, 2, 4
 BOOST_PYTHON_FUNCTION_OVERLOADS(save_map_overloads, save_map, 2, 3);
 BOOST_PYTHON_FUNCTION_OVERLOADS(save_map_to_string_overloads, save_map_to_string, 1, 2);
 BOOST_PYTHON_FUNCTION_OVERLOADS(render_overloads, render, 2, 5);
+BOOST_PYTHON_FUNCTION_OVERLOADS(render_with_stats_overloads, render_with_stats, 2, 5);
 
 BOOST_PYTHON_MODULE(_mapnik2)
 {
@@ -364,6 +387,8 @@ BOOST_PYTHON_MODULE(_mapnik2)
     export_raster_colorizer();
     export_glyph_symbolizer();
     export_inmem_metawriter();
+    export_render_stats();
+    export_metatile();
 
     def("render_to_file",&render_to_file1,
         "\n"
@@ -430,6 +455,21 @@ BOOST_PYTHON_MODULE(_mapnik2)
             ">>> render(m,im,scale_factor,offset[0],offset[1])\n"
             "\n"
             )); 
+
+    def("render_with_stats", &render_with_stats, render_with_stats_overloads(
+            "\n" 
+            "Render Map to an AGG image_32 like render(), and return\n"
+            "the RenderStats of its layers, rules and symbolizers\n"
+            "\n"
+            "Usage:\n"
+            ">>> from mapnik import Map, Image, render_with_stats, load_map\n"
+            ">>> m = Map(256,256)\n"
+            ">>> load_map(m,'mapfile.xml')\n"
+            ">>> im = Image(m.width,m.height)\n"
+            ">>> stats = render_with_stats(m,im)\n"
+            ">>> open('stats.json','w').write(stats.to_json())\n"
+            "\n"
+            )); 
     
 #if defined(HAVE_CAIRO) && defined(HAVE_PYCAIRO)
     def("render",&render3,
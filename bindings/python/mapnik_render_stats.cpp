@@ -0,0 +1,127 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+// boost
+#include <boost/python.hpp>
+
+// mapnik
+#include <mapnik/render_stats.hpp>
+
+using mapnik::render_stats;
+using mapnik::layer_stats;
+using mapnik::rule_stats;
+using mapnik::symbolizer_stats;
+
+namespace {
+boost::python::list layers(render_stats const& stats)
+{
+    boost::python::list result;
+    for (std::size_t i = 0; i < stats.layers.size(); ++i)
+    {
+        result.append(stats.layers[i]);
+    }
+    return result;
+}
+
+boost::python::list rules(layer_stats const& stats)
+{
+    boost::python::list result;
+    for (std::size_t i = 0; i < stats.rules.size(); ++i)
+    {
+        result.append(stats.rules[i]);
+    }
+    return result;
+}
+
+// the symbolizers that were called, by type.
+boost::python::dict symbolizers(render_stats const& stats)
+{
+    boost::python::dict result;
+    for (std::size_t i = 0; i < stats.symbolizers.size(); ++i)
+    {
+        if (stats.symbolizers[i].calls > 0)
+        {
+            result[stats.symbolizers[i].type] = stats.symbolizers[i];
+        }
+    }
+    return result;
+}
+}
+
+void export_render_stats()
+{
+    using namespace boost::python;
+
+    class_<symbolizer_stats>("SymbolizerStats",
+                             "Calls of the symbolizers of a type.",
+                             no_init)
+        .def_readonly("type", &symbolizer_stats::type)
+        .def_readonly("calls", &symbolizer_stats::calls)
+        .def_readonly("time", &symbolizer_stats::time,
+                      "Time spent in the calls, in milliseconds.")
+        .def_readonly("vertices", &symbolizer_stats::vertices)
+        ;
+
+    class_<rule_stats>("RuleStats",
+                       "Rule of a style, as applied to the features of a layer.",
+                       no_init)
+        .def_readonly("style", &rule_stats::style)
+        .def_readonly("name", &rule_stats::name)
+        .def_readonly("features", &rule_stats::features,
+                      "Number of features the rule applied to.")
+        .def_readonly("time", &rule_stats::time,
+                      "Time spent in the rule's symbolizers, in milliseconds.")
+        ;
+
+    class_<layer_stats>("LayerStats",
+                        "Counters and timers of a layer.",
+                        no_init)
+        .def_readonly("name", &layer_stats::name)
+        .def_readonly("time", &layer_stats::time,
+                      "Time spent on the layer, in milliseconds.")
+        .def_readonly("query_time", &layer_stats::query_time,
+                      "Time spent querying the datasource and reading features, in milliseconds.")
+        .def_readonly("features_fetched", &layer_stats::features_fetched)
+        .def_readonly("features_matched", &layer_stats::features_matched)
+        .add_property("rules", &rules)
+        ;
+
+    class_<render_stats>("RenderStats",
+                         "Counters and timers of a render.\n"
+                         "\n"
+                         "Usage:\n"
+                         ">>> from mapnik import Map, Image, render_with_stats, load_map\n"
+                         ">>> m = Map(256,256)\n"
+                         ">>> load_map(m,'mapfile.xml')\n"
+                         ">>> stats = render_with_stats(m,Image(m.width,m.height))\n"
+                         ">>> [(l.name, l.time) for l in stats.layers]\n"
+                         ">>> stats.to_json()\n",
+                         init<>())
+        .def_readonly("time", &render_stats::time,
+                      "Time of the render, in milliseconds.")
+        .add_property("layers", &layers)
+        .add_property("symbolizers", &symbolizers,
+                      "The symbolizers called, by type.")
+        .def("to_json", &render_stats::to_json)
+        ;
+}
@@ -61,7 +61,7 @@ class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T>
 {
      
 public:
-    agg_renderer(Map const& m, T & pixmap, double scale_factor=1.0, unsigned offset_x=0, unsigned offset_y=0);
+    agg_renderer(Map const& m, T & pixmap, double scale_factor=1.0, int offset_x=0, int offset_y=0);
     ~agg_renderer();
     void start_map_processing(Map const& map);
     void end_map_processing(Map const& map);
@@ -0,0 +1,138 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_COMPILED_EXPRESSION_HPP
+#define MAPNIK_COMPILED_EXPRESSION_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/expression_node.hpp>
+#include <mapnik/feature.hpp>
+
+// stl
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mapnik {
+
+/** Attributes read by a set of compiled expressions, each in a slot of
+  * its own. The values of a feature's attributes are looked up once, by
+  * resolve(), and then read by index by all the expressions.
+  */
+class MAPNIK_DECL attribute_slots
+{
+public:
+    /** The slot of an attribute, added if it has none yet. */
+    unsigned slot(std::string const& name);
+
+    std::size_t size() const
+    {
+        return slots_.size();
+    }
+
+    /** Fills 'values' with the feature's value of each attribute, by slot.
+      * Attributes the feature does not have are null.
+      */
+    void resolve(Feature const& feature, std::vector<value_type> & values) const;
+
+private:
+    std::map<std::string,unsigned> slots_;
+};
+
+/** Expression compiled into a flat program, evaluated on a stack instead of
+  * by visiting the expression tree. Attributes are read from the slots of an
+  * attribute_slots, constant subexpressions are evaluated once at compile
+  * time, and the right operands of 'and' and 'or' are jumped over when the
+  * left ones decide the result. Results are those of evaluate<Feature,value_type>.
+  *
+  * Instances own their evaluation stack, and cannot be shared among threads.
+  */
+class MAPNIK_DECL compiled_expression
+{
+public:
+    compiled_expression(expr_node const& node, attribute_slots & slots);
+
+    /** Evaluates the expression, 'values' being the attributes of a
+      * feature as resolved by the slots it was compiled with.
+      */
+    value_type evaluate(std::vector<value_type> const& values) const;
+
+    /** Number of instructions of the program. */
+    std::size_t size() const
+    {
+        return code_.size();
+    }
+
+    /** Whether the expression does not depend on the features. */
+    bool is_constant() const
+    {
+        return code_.size() == 1 && code_[0].op == push_constant;
+    }
+
+    enum opcode
+    {
+        push_constant,
+        push_attribute,
+        plus,
+        minus,
+        mult,
+        div,
+        mod,
+        less,
+        less_equal,
+        greater,
+        greater_equal,
+        equal_to,
+        not_equal_to,
+        logical_not,
+        to_bool,
+        and_jump,  // jumps, leaving false, if the top is false, or pops it
+        or_jump,   // jumps, leaving true, if the top is true, or pops it
+        regex_match,
+        regex_replace
+    };
+
+    struct instruction
+    {
+        instruction(opcode o, unsigned a)
+            : op(o),
+              arg(a) {}
+
+        opcode op;
+        unsigned arg;  // constant, slot, regex or jump target
+    };
+
+private:
+    friend struct expression_compiler;
+
+    std::vector<instruction> code_;
+    std::vector<value_type> constants_;
+    std::vector<regex_match_node> matches_;
+    std::vector<regex_replace_node> replaces_;
+    mutable std::vector<value_type> stack_;
+};
+}
+
+#endif // MAPNIK_COMPILED_EXPRESSION_HPP
@@ -79,7 +79,7 @@ struct MAPNIK_DECL coord_transform2
         return command;
     }
         
-    void rewind (unsigned pos)
+    void rewind (unsigned pos) const
     {
         geom_.rewind(pos);
     }
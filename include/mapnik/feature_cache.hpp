@@ -0,0 +1,94 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_FEATURE_CACHE_HPP
+#define MAPNIK_FEATURE_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/box2d.hpp>
+#include <mapnik/datasource.hpp>
+
+// boost
+#include <boost/utility.hpp>
+
+// stl
+#include <vector>
+
+namespace mapnik {
+
+/** Features of a layer, kept by feature_style_processor for the styles after
+  * the first one when the layer caches its features. The bounding box of the
+  * geometries of a feature is computed once, when it is added, and the boxes
+  * are stored contiguously, apart from the features, so that reading the
+  * cache only scans the boxes and allocates nothing.
+  */
+class MAPNIK_DECL feature_cache : private boost::noncopyable
+{
+public:
+    /** Featureset of the cached features whose bounding boxes intersect a
+      * box, and of those without geometries. It is meant to live on the
+      * stack of its consumer, and the cache must outlive it and not change.
+      */
+    class MAPNIK_DECL reader : public Featureset
+    {
+    public:
+        reader();
+        reader(feature_cache const& cache, box2d<double> const& bbox);
+        feature_ptr next();
+    private:
+        feature_cache const* cache_;
+        box2d<double> bbox_;
+        std::size_t pos_;
+        bool all_;
+    };
+
+    feature_cache();
+
+    /** Adds a feature, and computes its bounding box. */
+    void push(feature_ptr const& feature);
+
+    std::size_t size() const
+    {
+        return features_.size();
+    }
+
+    /** Bounding box of the cached features with geometries. */
+    box2d<double> const& envelope() const
+    {
+        return extent_;
+    }
+
+    void clear();
+
+private:
+    std::vector<box2d<double> > boxes_;
+    std::vector<feature_ptr> features_;
+    box2d<double> extent_;
+    bool has_extent_;
+};
+
+}
+
+#endif // MAPNIK_FEATURE_CACHE_HPP
@@ -32,16 +32,24 @@
 #include <mapnik/map.hpp>
 #include <mapnik/attribute_collector.hpp>
 #include <mapnik/expression_evaluator.hpp>
+#include <mapnik/rule_index.hpp>
 #include <mapnik/utils.hpp>
 #include <mapnik/projection.hpp>
 #include <mapnik/scale_denominator.hpp>
-#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_cache.hpp>
+#include <mapnik/prefetched_featureset.hpp>
+#include <mapnik/render_stats.hpp>
+#include <mapnik/tracer.hpp>
 
 #ifdef MAPNIK_DEBUG
 //#include <mapnik/wall_clock_timer.hpp>
 #endif
 // boost
 #include <boost/foreach.hpp>
+#include <boost/optional.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/make_shared.hpp>
+#endif
 //stl
 #include <vector>
 
@@ -79,7 +87,66 @@ class feature_style_processor
 public:
     explicit feature_style_processor(Map const& m, double scale_factor = 1.0)
         : m_(m),
-          scale_factor_(scale_factor) {}
+          scale_factor_(scale_factor),
+          prefetch_features_(0),
+          prefetch_bytes_(0),
+          stats_(0),
+          tracer_(0) {}
+
+    /** Reads the features of the next layer in a thread of its own while a
+      * layer is processed, so that the latency of the datasources overlaps with
+      * the processing (disabled by default). Layers are still processed in turn,
+      * and their features in the same order. Only vector layers whose datasource
+      * is not the one of the layer being processed are read ahead. Without
+      * MAPNIK_THREADSAFE, features are never read ahead.
+      * \param max_features Most features buffered at a time (0 disables prefetching)
+      * \param max_bytes Approximate memory that the buffered features may take
+      */
+    void set_feature_prefetch(std::size_t max_features, std::size_t max_bytes = 16 * 1024 * 1024)
+    {
+        prefetch_features_ = max_features;
+        prefetch_bytes_ = max_bytes;
+    }
+
+    std::size_t prefetch_features() const
+    {
+        return prefetch_features_;
+    }
+
+    std::size_t prefetch_bytes() const
+    {
+        return prefetch_bytes_;
+    }
+
+    /** Collects counters and timers of the layers, rules and symbolizers
+      * processed into 'stats' (none are collected by default). apply()
+      * clears them first, while apply(layer) adds those of the layer.
+      * \param stats Stats to fill, or a null pointer not to collect any
+      */
+    void set_render_stats(render_stats * stats)
+    {
+        stats_ = stats;
+    }
+
+    render_stats * get_render_stats() const
+    {
+        return stats_;
+    }
+
+    /** Records the phases of the processing into 'tracer' (none are
+      * recorded by default): the map, each layer, and for each style of
+      * a layer the query of its features and their iteration.
+      * \param t Tracer to record into, or a null pointer not to record any
+      */
+    void set_tracer(tracer * t)
+    {
+        tracer_ = t;
+    }
+
+    tracer * get_tracer() const
+    {
+        return tracer_;
+    }
     
     void apply()
     {
@@ -87,6 +154,13 @@ public:
         //mapnik::wall_clock_progress_timer t(std::clog, "map rendering took: ");
 #endif          
         Processor & p = static_cast<Processor&>(*this);
+        trace_scope map_scope(tracer_, "map");
+        double start = 0.0;
+        if (stats_)
+        {
+            stats_->clear();
+            start = stats_clock();
+        }
         p.start_map_processing(m_);
                        
         try
@@ -107,14 +181,29 @@ public:
 #ifdef MAPNIK_DEBUG
             std::clog << "scale denominator = " << scale_denom << "\n";
 #endif
+            std::vector<layer const*> layers;
             BOOST_FOREACH ( layer const& lyr, m_.layers() )
             {
                 if (lyr.isVisible(scale_denom))
                 {
-                    apply_to_layer(lyr, p, proj, scale_denom);
+                    layers.push_back(&lyr);
                 }
             }
 
+            // the features of the next layer are read while the current one is processed.
+            featureset_ptr prefetched;
+            for (std::size_t i = 0; i < layers.size(); ++i)
+            {
+                featureset_ptr next;
+                if (prefetch_features_ > 0 && i + 1 < layers.size() &&
+                    layers[i + 1]->datasource() != layers[i]->datasource())
+                {
+                    next = prefetch_layer(*layers[i + 1], proj, scale_denom);
+                }
+                apply_to_layer(*layers[i], p, proj, scale_denom, prefetched);
+                prefetched = next;
+            }
+
             metaItr = m_.begin_metawriters();
             for (;metaItr!=metaItrEnd; ++metaItr)
             {
@@ -127,10 +216,157 @@ public:
         }
         
         p.end_map_processing(m_);
+        if (stats_)
+        {
+            stats_->time = stats_clock() - start;
+        }
     }   
+
+    /** Renders a single layer of the map, whether it is visible at the
+      * map's scale or not. Unlike apply(), the map processing is neither
+      * started nor ended, and metawriters are not involved: this is meant
+      * for renderers that process the layers of a map independently.
+      * \param lyr Layer to render
+      */
+    void apply(layer const& lyr)
+    {
+        Processor & p = static_cast<Processor&>(*this);
+        try
+        {
+            projection proj(m_.srs()); // map projection
+            double scale_denom = mapnik::scale_denominator(m_,proj.is_geographic());
+            scale_denom *= scale_factor_;
+            apply_to_layer(lyr, p, proj, scale_denom);
+        }
+        catch (proj_init_error& ex)
+        {
+            std::clog << "proj_init_error:" << ex.what() << "\n"; 
+        }
+    }
 private:
+    /** Collects the styles of a layer that are active at the scale, and
+      * builds the query of their features: the part of the map's extent that
+      * the layer covers, and the properties that the styles use.
+      * \return false if the layer is outside of the map's extent
+      */
+    bool layer_query(layer const& lay, datasource const& ds, proj_transform const& prj_trans,
+                     double scale_denom, boost::optional<query> & q,
+                     std::vector<feature_type_style*> & active_styles,
+                     std::vector<std::string> * active_style_names = 0)
+    {
+        box2d<double> ext = m_.get_buffered_extent();
+        box2d<double> layer_ext = lay.envelope();
+               
+        double lx0 = layer_ext.minx();
+        double ly0 = layer_ext.miny();
+        double lz0 = 0.0;
+        double lx1 = layer_ext.maxx();
+        double ly1 = layer_ext.maxy();
+        double lz1 = 0.0;
+        // back project layers extent into main map projection
+        prj_trans.backward(lx0,ly0,lz0);
+        prj_trans.backward(lx1,ly1,lz1);
+               
+        // if no intersection then nothing to do for layer
+        if ( lx0 > ext.maxx() || lx1 < ext.minx() || ly0 > ext.maxy() || ly1 < ext.miny() )
+        {
+            return false;
+        }
+            
+        // clip query bbox
+        lx0 = std::max(ext.minx(),lx0);
+        ly0 = std::max(ext.miny(),ly0);
+        lx1 = std::min(ext.maxx(),lx1);
+        ly1 = std::min(ext.maxy(),ly1);
+            
+        prj_trans.forward(lx0,ly0,lz0);
+        prj_trans.forward(lx1,ly1,lz1);
+        box2d<double> bbox(lx0,ly0,lx1,ly1);
+            
+        query::resolution_type res(m_.width()/m_.get_current_extent().width(),m_.height()/m_.get_current_extent().height());
+        q = query(bbox,res,scale_denom); //BBOX query
+                           
+        std::set<std::string> names;
+        attribute_collector collector(names);
+            
+        std::vector<std::string> const& style_names = lay.styles();
+        // iterate through all named styles collecting active styles and attribute names
+        BOOST_FOREACH(std::string const& style_name, style_names)
+        {
+            boost::optional<feature_type_style const&> style=m_.find_style(style_name);
+            if (!style) 
+            {
+                std::clog << "WARNING: style '" << style_name << "' required for layer '" << lay.name() << "' does not exist.\n";
+                continue;
+            }
+                
+            const std::vector<rule>& rules=(*style).get_rules();
+            bool active_rules=false;
+                
+            BOOST_FOREACH(rule const& r, rules)
+            {
+                if (r.active(scale_denom))
+                {
+                    active_rules = true;
+                    if (ds.type() == datasource::Vector)
+                    {
+                        collector(r);
+                    }
+                    // TODO - in the future rasters should be able to be filtered.
+                }
+            }
+            if (active_rules)
+            {
+                active_styles.push_back(const_cast<feature_type_style*>(&(*style)));
+                if (active_style_names)
+                {
+                    active_style_names->push_back(style_name);
+                }
+            }
+        }
+            
+        // push all property names
+        BOOST_FOREACH(std::string const& name, names)
+        {
+            q->add_property_name(name);
+        }
+        return true;
+    }
+
+    /** Starts reading the features of a layer in a thread of its own.
+      * \return the featureset of the features read ahead, or a null pointer
+      * if they cannot be read ahead (or there is no feature to read)
+      */
+    featureset_ptr prefetch_layer(layer const& lay, projection const& proj0, double scale_denom)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::shared_ptr<datasource> ds = lay.datasource();
+        // rasters are filtered by their symbolizers, while they are processed.
+        if (!ds || ds->type() != datasource::Vector)
+        {
+            return featureset_ptr();
+        }
+        projection proj1(lay.srs());
+        proj_transform prj_trans(proj0,proj1);
+        boost::optional<query> q;
+        std::vector<feature_type_style*> active_styles;
+        if (!layer_query(lay, *ds, prj_trans, scale_denom, q, active_styles) || active_styles.empty())
+        {
+            return featureset_ptr();
+        }
+        return boost::make_shared<prefetched_featureset>(ds, *q, prefetch_features_, prefetch_bytes_);
+#else
+        return featureset_ptr();
+#endif
+    }
+
+    /** Processes the features of a layer with its active styles.
+      * \param prefetched The features of the layer, read ahead by
+      * prefetch_layer(), or a null pointer to query them
+      */
     void apply_to_layer(layer const& lay, Processor & p, 
-                        projection const& proj0, double scale_denom)
+                        projection const& proj0, double scale_denom,
+                        featureset_ptr prefetched = featureset_ptr())
     {
 #ifdef MAPNIK_DEBUG
         //wall_clock_progress_timer timer(clog, "end layer rendering: ");
@@ -142,12 +378,17 @@ private:
             return;
         }
         
+        trace_scope layer_scope(tracer_, "layer", "render", lay.name());
+        double layer_start = 0.0;
+        if (stats_)
+        {
+            stats_->layers.push_back(layer_stats(lay.name()));
+            layer_start = stats_clock();
+        }
         p.start_layer_processing(lay);
         
         if (ds)
         {
-            
-            box2d<double> ext = m_.get_buffered_extent();
             projection proj1(lay.srs());
             proj_transform prj_trans(proj0,proj1);
 
@@ -157,92 +398,33 @@ private:
             {
                 std::clog << "WARNING: Map srs does not match layer srs, skipping raster layer '" << lay.name() << "' as raster re-projection is not currently supported (http://trac.mapnik.org/ticket/663)\n";
                 std::clog << "map srs: '" << m_.srs() << "'\nlayer srs: '" << lay.srs() << "' \n";       
+                finish_layer(p, lay, layer_start);
                 return;
             }
             
-            // 
-            
-            box2d<double> layer_ext = lay.envelope();
-               
-            double lx0 = layer_ext.minx();
-            double ly0 = layer_ext.miny();
-            double lz0 = 0.0;
-            double lx1 = layer_ext.maxx();
-            double ly1 = layer_ext.maxy();
-            double lz1 = 0.0;
-            // back project layers extent into main map projection
-            prj_trans.backward(lx0,ly0,lz0);
-            prj_trans.backward(lx1,ly1,lz1);
-               
-            // if no intersection then nothing to do for layer
-            if ( lx0 > ext.maxx() || lx1 < ext.minx() || ly0 > ext.maxy() || ly1 < ext.miny() )
+            boost::optional<query> layer_q;
+            std::vector<feature_type_style*> active_styles;
+            std::vector<std::string> active_style_names;
+            if (!layer_query(lay, *ds, prj_trans, scale_denom, layer_q, active_styles,
+                             stats_ || tracer_ ? &active_style_names : 0))
             {
+                finish_layer(p, lay, layer_start);
                 return;
             }
-            
-            // clip query bbox
-            lx0 = std::max(ext.minx(),lx0);
-            ly0 = std::max(ext.miny(),ly0);
-            lx1 = std::min(ext.maxx(),lx1);
-            ly1 = std::min(ext.maxy(),ly1);
-            
-            prj_trans.forward(lx0,ly0,lz0);
-            prj_trans.forward(lx1,ly1,lz1);
-            box2d<double> bbox(lx0,ly0,lx1,ly1);
-            
-            query::resolution_type res(m_.width()/m_.get_current_extent().width(),m_.height()/m_.get_current_extent().height());
-            query q(bbox,res,scale_denom); //BBOX query
-                           
-            std::vector<feature_type_style*> active_styles;
-            std::set<std::string> names;
-            attribute_collector collector(names);
+            query & q = *layer_q;
+            std::vector<std::string> const& style_names = lay.styles();
             double filt_factor = 1;
             directive_collector d_collector(&filt_factor);
             
-            std::vector<std::string> const& style_names = lay.styles();
-            // iterate through all named styles collecting active styles and attribute names
-            BOOST_FOREACH(std::string const& style_name, style_names)
-            {
-                boost::optional<feature_type_style const&> style=m_.find_style(style_name);
-                if (!style) 
-                {
-                    std::clog << "WARNING: style '" << style_name << "' required for layer '" << lay.name() << "' does not exist.\n";
-                    continue;
-                }
-                
-                const std::vector<rule>& rules=(*style).get_rules();
-                bool active_rules=false;
-                
-                BOOST_FOREACH(rule const& r, rules)
-                {
-                    if (r.active(scale_denom))
-                    {
-                        active_rules = true;
-                        if (ds->type() == datasource::Vector)
-                        {
-                            collector(r);
-                        }
-                        // TODO - in the future rasters should be able to be filtered.
-                    }
-                }
-                if (active_rules)
-                {
-                    active_styles.push_back(const_cast<feature_type_style*>(&(*style)));
-                }
-            }
-            
-            // push all property names
-            BOOST_FOREACH(std::string const& name, names)
-            {
-                q.add_property_name(name);
-            }
-            
-            memory_datasource cache;
+            feature_cache cache;
             bool cache_features = lay.cache_features() && style_names.size()>1?true:false;
             bool first = true;
             
-            BOOST_FOREACH (feature_type_style * style, active_styles)
+            for (std::size_t s = 0; s < active_styles.size(); ++s)
             {
+                feature_type_style * style = active_styles[s];
+                trace_scope style_scope(tracer_, "style", "render",
+                                        tracer_ ? active_style_names[s] : std::string());
                 std::vector<rule*> if_rules;
                 std::vector<rule*> else_rules;
 
@@ -278,24 +460,75 @@ private:
                     }
                 }
                 
-                // process features
-                featureset_ptr fs;
-                if (first)
+                // compile the filters once, look up the attributes they
+                // read once per feature, and only evaluate the filters of
+                // the rules that can match it.
+                std::vector<expression_ptr> filters;
+                filters.reserve(if_rules.size());
+                BOOST_FOREACH(rule * r, if_rules)
                 {
-                    if (cache_features)
-                        first = false;
-                    fs = ds->features(q);
+                    filters.push_back(r->get_filter());
                 }
-                else
+                rule_index index(filters);
+
+                // stats of the if rules, followed by those of the else rules.
+                layer_stats * lay_stats = 0;
+                rule_stats * rules_stats = 0;
+                if (stats_)
                 {
-                    fs = cache.features(q);
+                    lay_stats = &stats_->layers.back();
+                    std::size_t first_rule = lay_stats->rules.size();
+                    BOOST_FOREACH(rule * r, if_rules)
+                    {
+                        lay_stats->rules.push_back(rule_stats(active_style_names[s], r->get_name()));
+                    }
+                    BOOST_FOREACH(rule * r, else_rules)
+                    {
+                        lay_stats->rules.push_back(rule_stats(active_style_names[s], r->get_name()));
+                    }
+                    rules_stats = lay_stats->rules.empty() ? 0 : &lay_stats->rules[first_rule];
+                }
+                double query_start = lay_stats ? stats_clock() : 0.0;
+
+                // process features
+                featureset_ptr fs;
+                feature_cache::reader cached;
+                Featureset * features = 0;
+                {
+                    trace_scope query_scope(tracer_, "query");
+                    if (first)
+                    {
+                        if (cache_features)
+                            first = false;
+                        if (prefetched)
+                        {
+                            // the features read ahead are only those of the first style
+                            fs.swap(prefetched);
+                        }
+                        else
+                        {
+                            fs = ds->features(q);
+                        }
+                        features = fs.get();
+                    }
+                    else
+                    {
+                        cached = feature_cache::reader(cache, q.get_bbox());
+                        features = &cached;
+                    }
                 }
                 
-                if (fs)
+                if (features)
                 {               
+                    trace_scope features_scope(tracer_, "features");
                     feature_ptr feature;
-                    while ((feature = fs->next()))
+                    while ((feature = features->next()))
                     {                  
+                        if (lay_stats)
+                        {
+                            lay_stats->query_time += stats_clock() - query_start;
+                            ++lay_stats->features_fetched;
+                        }
                         bool do_else=true;
                         
                         if (cache_features)
@@ -303,27 +536,14 @@ private:
                             cache.push(feature);
                         }
                         
-                        BOOST_FOREACH(rule * r, if_rules )
+                        index.resolve(*feature);
+                        BOOST_FOREACH(unsigned i, index.candidates())
                         {
-                            expression_ptr const& expr=r->get_filter();    
-                            value_type result = boost::apply_visitor(evaluate<Feature,value_type>(*feature),*expr);
-                            if (result.to_bool())
+                            rule * r = if_rules[i];
+                            if (index.match(i))
                             {   
                                 do_else=false;
-                                rule::symbolizers const& symbols = r->get_symbolizers();
-
-                                // if the underlying renderer is not able to process the complete set of symbolizers,
-                                // process one by one.
-#ifdef SVG_RENDERER
-                                if(!p.process(symbols,*feature,prj_trans))
-#endif
-                                {
-
-                                    BOOST_FOREACH (symbolizer const& sym, symbols)
-                                    {   
-                                        boost::apply_visitor(symbol_dispatch(p,*feature,prj_trans),sym);
-                                    }
-                                }
+                                process_rule(p, *r, *feature, prj_trans, rules_stats ? rules_stats + i : 0);
                                 if (style->get_filter_mode() == FILTER_FIRST)
                                 {
                                     // Stop iterating over rules and proceed with next feature.
@@ -333,33 +553,98 @@ private:
                         }
                         if (do_else)
                         {
-                            BOOST_FOREACH( rule * r, else_rules )
+                            for (std::size_t i = 0; i < else_rules.size(); ++i)
                             {
-                                rule::symbolizers const& symbols = r->get_symbolizers();
-                                // if the underlying renderer is not able to process the complete set of symbolizers,
-                                // process one by one.
-#ifdef SVG_RENDERER
-                                if(!p.process(symbols,*feature,prj_trans))
-#endif
-                                {
-                                    BOOST_FOREACH (symbolizer const& sym, symbols)
-                                    {
-                                        boost::apply_visitor(symbol_dispatch(p,*feature,prj_trans),sym);
-                                    }
-                                }
+                                process_rule(p, *else_rules[i], *feature, prj_trans,
+                                             rules_stats ? rules_stats + if_rules.size() + i : 0);
                             }
                         }
+                        if (lay_stats)
+                        {
+                            if (!do_else || !else_rules.empty())
+                            {
+                                ++lay_stats->features_matched;
+                            }
+                            query_start = stats_clock();
+                        }
                     }
                 }
+                if (lay_stats)
+                {
+                    lay_stats->query_time += stats_clock() - query_start;
+                }
                 cache_features = false;
             }
         }
         
-        p.end_layer_processing(lay);
+        finish_layer(p, lay, layer_start);
     } 
+
+    /** Processes the symbolizers of a rule that applies to a feature.
+      * \param stats Stats of the rule, or a null pointer
+      */
+    void process_rule(Processor & p, rule const& r, Feature const& feature,
+                      proj_transform const& prj_trans, rule_stats * stats)
+    {
+        double start = stats ? stats_clock() : 0.0;
+        rule::symbolizers const& symbols = r.get_symbolizers();
+
+        // if the underlying renderer is not able to process the complete set of symbolizers,
+        // process one by one.
+#ifdef SVG_RENDERER
+        double group_start = stats ? stats_clock() : 0.0;
+        if (p.process(symbols,feature,prj_trans))
+        {
+            if (stats && !symbols.empty())
+            {
+                // the symbolizers were processed at once: they share the time of the call.
+                double call_time = (stats_clock() - group_start) / symbols.size();
+                BOOST_FOREACH (symbolizer const& sym, symbols)
+                {
+                    stats_->add_symbolizer_call(sym, feature, call_time);
+                }
+            }
+        }
+        else
+#endif
+        {
+            BOOST_FOREACH (symbolizer const& sym, symbols)
+            {   
+                if (stats)
+                {
+                    double sym_start = stats_clock();
+                    boost::apply_visitor(symbol_dispatch(p,feature,prj_trans),sym);
+                    stats_->add_symbolizer_call(sym, feature, stats_clock() - sym_start);
+                }
+                else
+                {
+                    boost::apply_visitor(symbol_dispatch(p,feature,prj_trans),sym);
+                }
+            }
+        }
+        if (stats)
+        {
+            ++stats->features;
+            stats->time += stats_clock() - start;
+        }
+    }
+
+    /** Ends the processing of a layer, and records how long it took. */
+    void finish_layer(Processor & p, layer const& lay, double layer_start)
+    {
+        p.end_layer_processing(lay);
+        if (stats_)
+        {
+            stats_->layers.back().time = stats_clock() - layer_start;
+        }
+    }
     
     Map const& m_;
     double scale_factor_;
+    std::size_t prefetch_features_;
+    std::size_t prefetch_bytes_;
+    render_stats * stats_;
+    tracer * tracer_;
 };
 }
 
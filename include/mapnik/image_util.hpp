@@ -28,6 +28,7 @@
 // mapnik
 #include <mapnik/config.hpp>
 #include <mapnik/graphics.hpp>
+#include <mapnik/tracer.hpp>
 
 // boost
 #include <boost/algorithm/string.hpp>
@@ -212,6 +213,26 @@ inline MAPNIK_DECL std::string save_to_string(image_32 const& image,
 {
     return save_to_string<image_data_32>(image.data(),type);
 }
+
+// encode recording an "encode" phase into a tracer, if not null
+template <typename T>
+inline void save_to_file(T const& image,
+                         std::string const& file,
+                         std::string const& type,
+                         tracer * t)
+{
+    trace_scope scope(t, "encode", "render", type);
+    save_to_file(image,file,type);
+}
+
+template <typename T>
+inline std::string save_to_string(T const& image,
+                                  std::string const& type,
+                                  tracer * t)
+{
+    trace_scope scope(t, "encode", "render", type);
+    return save_to_string(image,type);
+}
    
 #ifdef _MSC_VER
 template MAPNIK_DECL void save_to_file<image_data_32>(image_data_32 const&,
@@ -0,0 +1,109 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_METATILE_HPP
+#define MAPNIK_METATILE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/image_view.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/tracer.hpp>
+
+// boost
+#include <boost/utility.hpp>
+
+// stl
+#include <string>
+
+namespace mapnik {
+
+/** Renders the image of a map with agg_renderer once, and splits it into
+  * 'columns' by 'rows' tiles, so that the layers are queried, and their labels
+  * placed, once for all the tiles. Tiles are as large as the map's image
+  * divided by the number of columns and rows, rounded down; the last column
+  * and row take the remaining pixels.
+  *
+  * The image is rendered with a margin of the map's buffer size around it,
+  * where the symbols and labels of the features around the map are drawn as
+  * they are by the neighbouring metatiles. Labels that cross the seams
+  * between tiles are placed once, and drawn into each of the tiles, which
+  * are views of the image: splitting it copies nothing.
+  */
+class MAPNIK_DECL metatile : private boost::noncopyable
+{
+public:
+    typedef image_view<image_data_32> tile_type;
+
+    metatile(Map const& m, unsigned columns, unsigned rows);
+
+    /** Renders the map, recording its phases into a tracer, if not null. */
+    void render(double scale_factor = 1.0, tracer * t = 0);
+
+    unsigned columns() const
+    {
+        return columns_;
+    }
+
+    unsigned rows() const
+    {
+        return rows_;
+    }
+
+    /** Margin around the map in the image, in pixels. */
+    unsigned margin() const
+    {
+        return margin_;
+    }
+
+    /** The rendered image, margin included. */
+    image_32 const& image() const
+    {
+        return image_;
+    }
+
+    /** View of a tile of the rendered image. Throws std::out_of_range
+      * if there is no tile at 'column' and 'row'.
+      */
+    tile_type tile(unsigned column, unsigned row) const;
+
+    /** Encodes a tile to an image format, like "png" or "jpeg", recording
+      * the encoding into a tracer, if not null. Throws std::out_of_range
+      * as tile() does.
+      */
+    std::string encode(unsigned column, unsigned row, std::string const& type,
+                       tracer * t = 0) const;
+
+private:
+    Map const& map_;
+    unsigned columns_;
+    unsigned rows_;
+    unsigned margin_;
+    image_32 image_;
+};
+
+}
+
+#endif // MAPNIK_METATILE_HPP
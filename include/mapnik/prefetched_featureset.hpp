@@ -0,0 +1,90 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef PREFETCHED_FEATURESET_HPP
+#define PREFETCHED_FEATURESET_HPP
+
+#ifdef MAPNIK_THREADSAFE
+
+// mapnik
+#include <mapnik/datasource.hpp>
+#include <mapnik/query.hpp>
+
+// boost
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+
+// stl
+#include <deque>
+#include <string>
+#include <utility>
+
+namespace mapnik {
+
+/** Featureset that queries a datasource and reads its features in a thread
+  * of its own, ahead of their consumer, so that the latency of the datasource
+  * overlaps with the processing of other features. At most max_features
+  * features, taking about max_bytes bytes, are buffered at a time: the thread
+  * waits for the consumer to take some before reading more. Errors of the
+  * datasource are thrown by next(), as datasource_exception, once the features
+  * read before are taken.
+  */
+class MAPNIK_DECL prefetched_featureset : public Featureset, private boost::noncopyable
+{
+public:
+    prefetched_featureset(datasource_ptr const& ds, query const& q,
+                          std::size_t max_features, std::size_t max_bytes);
+
+    /** Stops reading features, and waits for the thread to finish. */
+    virtual ~prefetched_featureset();
+
+    feature_ptr next();
+
+    /** Approximate memory used by a feature: its geometries and properties. */
+    static std::size_t feature_size(Feature const& feature);
+
+private:
+    void read_features();
+
+    datasource_ptr ds_;
+    query query_;
+    std::size_t max_features_;
+    std::size_t max_bytes_;
+    std::deque<std::pair<feature_ptr, std::size_t> > features_;
+    std::size_t bytes_;
+    bool done_;
+    bool cancelled_;
+    std::string error_;
+    boost::mutex mutex_;
+    boost::condition_variable not_empty_;
+    boost::condition_variable not_full_;
+    boost::thread thread_;
+};
+}
+
+#endif // MAPNIK_THREADSAFE
+
+#endif // PREFETCHED_FEATURESET_HPP
@@ -0,0 +1,125 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_RENDER_STATS_HPP
+#define MAPNIK_RENDER_STATS_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/feature.hpp>
+
+// stl
+#include <string>
+#include <vector>
+
+namespace mapnik {
+
+/** Wall clock time, in milliseconds. */
+MAPNIK_DECL double stats_clock();
+
+/** Symbolizers of a type: how often they were called, for how long, and
+  * on how many vertices.
+  */
+struct symbolizer_stats
+{
+    symbolizer_stats()
+        : type(),
+          calls(0),
+          time(0.0),
+          vertices(0) {}
+
+    std::string type;
+    unsigned calls;
+    double time;
+    std::size_t vertices;
+};
+
+/** Rule of a style, as applied to the features of a layer. */
+struct rule_stats
+{
+    rule_stats(std::string const& style_name, std::string const& rule_name)
+        : style(style_name),
+          name(rule_name),
+          features(0),
+          time(0.0) {}
+
+    std::string style;
+    std::string name;
+    unsigned features; // features the rule applied to
+    double time;       // in its symbolizers
+};
+
+/** Layer of a map: the time spent querying its datasource and reading
+  * features, for each style of the layer, and the features read.
+  */
+struct layer_stats
+{
+    explicit layer_stats(std::string const& layer_name)
+        : name(layer_name),
+          time(0.0),
+          query_time(0.0),
+          features_fetched(0),
+          features_matched(0) {}
+
+    std::string name;
+    double time;
+    double query_time;
+    unsigned features_fetched; // by all the styles
+    unsigned features_matched; // by a rule of a style
+    std::vector<rule_stats> rules;
+};
+
+/** Counters and timers of a render, collected by feature_style_processor
+  * when it is given a render_stats. Times are wall clock milliseconds.
+  */
+class MAPNIK_DECL render_stats
+{
+public:
+    render_stats()
+        : time(0.0) {}
+
+    void clear();
+
+    /** The stats of the symbolizers of the type of 'sym'. */
+    symbolizer_stats & symbolizer_type(symbolizer const& sym);
+
+    /** Adds a call of a symbolizer, of 'time' milliseconds, on 'feature'. */
+    void add_symbolizer_call(symbolizer const& sym, Feature const& feature, double time);
+
+    /** Adds the layers and the symbolizer calls of another render, like
+      * that of a layer rendered on its own. The time is left as it is.
+      */
+    void merge(render_stats const& other);
+
+    /** The stats as a JSON object, with "time", "layers" and "symbolizers" members. */
+    std::string to_json() const;
+
+    double time;
+    std::vector<layer_stats> layers;
+    std::vector<symbolizer_stats> symbolizers; // by type, those never called included
+};
+}
+
+#endif // MAPNIK_RENDER_STATS_HPP
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_RULE_INDEX_HPP
+#define MAPNIK_RULE_INDEX_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/compiled_expression.hpp>
+#include <mapnik/filter_factory.hpp>
+
+// boost
+#include <boost/unordered_map.hpp>
+#include <boost/utility.hpp>
+
+// stl
+#include <string>
+#include <vector>
+
+namespace mapnik {
+
+/** Filters of a style's rules, indexed by the value they require of an
+  * attribute. When several filters are, or are 'and's of, an equality of
+  * the same attribute with a constant, like [highway]='primary', they are
+  * put in a hash table keyed on that constant: the candidates of a feature
+  * are then the filters keyed on its value of the attribute, and those that
+  * are not keyed, and only what remains of their filters is evaluated.
+  *
+  * The filters are compiled with compiled_expression, and the index cannot
+  * be shared among threads.
+  */
+class MAPNIK_DECL rule_index : private boost::noncopyable
+{
+public:
+    explicit rule_index(std::vector<expression_ptr> const& filters);
+
+    /** Looks up the attributes of a feature, and its candidate filters. */
+    void resolve(Feature const& feature);
+
+    /** The candidates of the last resolved feature, by increasing index.
+      * Filters that are not candidates are false for it.
+      */
+    std::vector<unsigned> const& candidates() const
+    {
+        return *candidates_;
+    }
+
+    /** Whether the candidate filter 'index' is true for the last resolved feature. */
+    bool match(unsigned index) const
+    {
+        return residuals_[index].evaluate(values_).to_bool();
+    }
+
+    /** The attribute the filters are indexed by, or an empty string if they are not. */
+    std::string const& key() const
+    {
+        return key_;
+    }
+
+    /** Key under which a value is indexed: values that are equal have the same
+      * key. Returns false for values that are not indexed.
+      */
+    static bool hash_key(value_type const& value, std::string & key);
+
+private:
+    typedef boost::unordered_map<std::string,std::vector<unsigned> > index_type;
+
+    attribute_slots slots_;
+    std::vector<compiled_expression> residuals_;
+    std::vector<value_type> values_;
+    std::string key_;
+    unsigned key_slot_;
+    index_type index_;
+    std::vector<unsigned> unkeyed_;
+    std::vector<unsigned> const* candidates_;
+    std::string hash_;
+};
+}
+
+#endif // MAPNIK_RULE_INDEX_HPP
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_SVG_BASE64_ENCODER_HPP
+#define MAPNIK_SVG_BASE64_ENCODER_HPP
+
+// boost
+#include <boost/utility.hpp>
+
+// stl
+#include <cstddef>
+
+namespace mapnik { namespace svg {
+
+    /*!
+     * @brief Stream that base64-encodes the bytes written to it straight into an
+     * output iterator, as it receives them. It has the write() and flush() methods
+     * that png_io's writers expect, so that images can be embedded in the document
+     * (i.e. as data URIs) without being encoded into a string first. At most two
+     * bytes are held back, until they make a group of three; finish() writes them,
+     * padded, and must be called once the last byte is written.
+     */
+    template <typename OutputIterator>
+    class base64_encoder : private boost::noncopyable
+    {
+    public:
+	explicit base64_encoder(OutputIterator& output_iterator)
+	    : output_iterator_(output_iterator),
+	      pending_(0)
+	{}
+
+	void write(char const* s, std::size_t n)
+	{
+	    for(std::size_t i = 0; i < n; ++i)
+	    {
+		group_[pending_++] = static_cast<unsigned char>(s[i]);
+		if(pending_ == 3)
+		{
+		    encode_group(3);
+		}
+	    }
+	}
+
+	/*!
+	 * @brief Does nothing: the bytes held back cannot be encoded before
+	 * the group they belong to is complete, or before finish().
+	 */
+	void flush() {}
+
+	void finish()
+	{
+	    if(pending_ > 0)
+	    {
+		for(unsigned i = pending_; i < 3; ++i)
+		{
+		    group_[i] = 0;
+		}
+		encode_group(pending_);
+	    }
+	}
+
+    private:
+	/*!
+	 * @brief Write the four characters of the pending group,
+	 * of which only 'size' bytes are significant.
+	 */
+	void encode_group(unsigned size)
+	{
+	    static char const alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	    *output_iterator_++ = alphabet[group_[0] >> 2];
+	    *output_iterator_++ = alphabet[((group_[0] & 0x03) << 4) | (group_[1] >> 4)];
+	    *output_iterator_++ = size > 1 ? alphabet[((group_[1] & 0x0f) << 2) | (group_[2] >> 6)] : '=';
+	    *output_iterator_++ = size > 2 ? alphabet[group_[2] & 0x3f] : '=';
+	    pending_ = 0;
+	}
+
+	OutputIterator& output_iterator_;
+	unsigned char group_[3];
+	unsigned pending_;
+    };
+}}
+
+#endif // MAPNIK_SVG_BASE64_ENCODER_HPP
@@ -25,32 +25,62 @@
 
 // mapnik
 #include <mapnik/ctrans.hpp>
+#include <mapnik/box2d.hpp>
 #include <mapnik/color.hpp>
 #include <mapnik/geometry.hpp>
+#include <mapnik/image_data.hpp>
+#include <mapnik/marker.hpp>
 #include <mapnik/svg/svg_output_grammars.hpp>
 #include <mapnik/svg/svg_output_attributes.hpp>
+#include <mapnik/svg/svg_path_converters.hpp>
+#include <mapnik/svg/svg_path_emitters.hpp>
+
+// agg
+#include "agg_trans_affine.h"
 
 // boost
 #include <boost/utility.hpp>
 
-namespace mapnik { namespace svg {
+// stl
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mapnik {
+
+    struct text_path;
+
+namespace svg {
 
     /*!
      * @brief Performs the actual generation of output calling the underlying library.
      * A method to generate each kind of SVG tag is provided. The information needed
      * needed to generate the attributes of a tag is passed within a *_output_attributes
      * structure.
+     *
+     * @tparam PathEmitter the policy that writes path data: karma_path_emitter
+     * (the default) or fast_path_emitter, which writes the same bytes faster.
      */
-    template <typename OutputIterator>
+    template <typename OutputIterator, typename PathEmitter = karma_path_emitter>
     class svg_generator : private boost::noncopyable
     {
 	typedef coord_transform2<CoordTransform, geometry_type> path_type;
+	typedef coord_transform2<source_transform, geometry_type> source_path_type;
 
 	typedef svg::svg_root_attributes_grammar<OutputIterator> root_attributes_grammar;
 	typedef svg::svg_rect_attributes_grammar<OutputIterator> rect_attributes_grammar;
-        typedef svg::svg_path_data_grammar<OutputIterator, path_type> path_data_grammar;
 	typedef svg::svg_path_attributes_grammar<OutputIterator> path_attributes_grammar;
 	typedef svg::svg_path_dash_array_grammar<OutputIterator> path_dash_array_grammar;
+	typedef svg::svg_text_attributes_grammar<OutputIterator> text_attributes_grammar;
+
+	typedef karma::real_generator<double, coordinate_policy<double> > coordinate_generator;
+
+	typedef std::back_insert_iterator<std::string> fragment_iterator;
+	typedef svg::svg_path_attributes_grammar<fragment_iterator> path_attributes_fragment_grammar;
+	typedef svg::svg_path_dash_array_grammar<fragment_iterator> path_dash_array_fragment_grammar;
+	typedef svg::svg_path_style_grammar<fragment_iterator> path_style_fragment_grammar;
+	typedef svg::svg_path_dash_array_style_grammar<fragment_iterator> path_dash_array_style_fragment_grammar;
 
     public:
 	explicit svg_generator(OutputIterator& output_iterator);
@@ -61,9 +91,236 @@ namespace mapnik { namespace svg {
 	void generate_closing_root();
 	void generate_rect(rect_output_attributes const& rect_attributes);
 	void generate_path(path_type const& path, path_output_attributes const& path_attributes);
+
+	/*!
+	 * @brief Generate a path tag whose attributes have already been serialized.
+	 * @param attributes_fragment the text written after the path data, as returned
+	 * by generate_path_attributes() or a class attribute.
+	 */
+	void generate_path(path_type const& path, std::string const& attributes_fragment);
+
+	/*!
+	 * @brief Append a path to the current batch of paths.
+	 * Consecutive paths with the same attributes are written as the sub-paths of
+	 * a single path tag. The batch is written when a path with other attributes
+	 * is appended, or when flush_paths() is called.
+	 */
+	void append_path(path_type const& path, std::string const& attributes_fragment);
+
+	/*!
+	 * @brief Overloads for paths in source coordinates (in the map's projection).
+	 * These paths are written in a group whose transform attribute, the source matrix,
+	 * maps them to image coordinates. The group is opened by the first of them, and
+	 * closed by flush_paths(). The clip box and the simplification tolerance must then
+	 * be in source units too.
+	 */
+	void generate_path(source_path_type const& path, std::string const& attributes_fragment);
+	void append_path(source_path_type const& path, std::string const& attributes_fragment);
+	void set_source_matrix(agg::trans_affine const& matrix);
+	agg::trans_affine const& source_matrix() const;
+
+	/*!
+	 * @brief Generate the path tag for the current batch of paths, if any,
+	 * and close the group of paths in source coordinates, if one is open.
+	 */
+	void flush_paths();
+
+	/*!
+	 * @brief Serialize the presentation attributes of a path tag, so that they
+	 * can be cached and written by generate_path() for many paths.
+	 */
+	std::string generate_path_attributes(path_output_attributes const& path_attributes);
+
+	/*!
+	 * @brief Serialize the presentation attributes of a path as CSS declarations.
+	 * Attributes that produce the same declarations can share a class.
+	 */
+	std::string generate_path_style(path_output_attributes const& path_attributes);
+
+	/*!
+	 * @brief Generate a style sheet with one class per (name, declarations) pair.
+	 */
+	void generate_style_sheet(std::vector<std::pair<std::string, std::string> > const& style_classes);
+
+	/*!
+	 * @brief Number of fractional digits written for path coordinates.
+	 * Coordinates are snapped to this precision before being written, and
+	 * vertices that collapse onto the previous one are dropped. A precision
+	 * of 0 snaps paths to integral pixel coordinates.
+	 */
+	void set_coordinate_precision(unsigned precision);
+	unsigned coordinate_precision() const;
+
+	/*!
+	 * @brief Rectangle, in image coordinates, to which paths are clipped when clipping is enabled.
+	 * Clipped line strings are split into the pieces inside the rectangle, clipped polygon
+	 * rings stay closed, and paths that are entirely outside of it are not generated.
+	 */
+	void set_clip_box(box2d<double> const& clip_box);
+	box2d<double> const& clip_box() const;
+	void set_clipping(bool clipping);
+	bool clipping() const;
+
+	/*!
+	 * @brief Tolerance, in pixels, used to simplify paths (0 by default, no simplification).
+	 * Vertices closer than the tolerance to the previous one are dropped and, if
+	 * Douglas-Peucker simplification is enabled, so are vertices closer than the
+	 * tolerance to the simplified line.
+	 */
+	void set_simplify_tolerance(double tolerance);
+	double simplify_tolerance() const;
+	void set_douglas_peucker(bool douglas_peucker);
+	bool douglas_peucker() const;
+
+	/*!
+	 * @brief Kind of commands written in path data (ABSOLUTE_PATH_COMMANDS by default).
+	 * Relative commands write each vertex as a delta from the previous one, which
+	 * is usually shorter for dense paths; the shortest mode decides per vertex.
+	 */
+	void set_path_commands(path_commands_e commands);
+	path_commands_e path_commands() const;
+
+	/*!
+	 * @brief Generate the opening of a symbol tag (within a defs tag), whose
+	 * content can then be drawn many times by use tags referring to its id.
+	 * Symbols are drawn around the origin of the use tag and are not clipped.
+	 */
+	void generate_opening_symbol(std::string const& id);
+	void generate_closing_symbol();
+
+	/*!
+	 * @brief Generate the opening of a pattern tag (within a defs tag), that tiles the
+	 * plane from the origin with 'width' by 'height' cells. The content of the cells is
+	 * centered on the origin, as the content of symbols is (see generate_marker), and
+	 * the tiling is transformed by 'matrix'.
+	 */
+	void generate_opening_pattern(std::string const& id, double width, double height, agg::trans_affine const& matrix);
+	void generate_closing_pattern();
+
+	/*!
+	 * @brief Generate the opening of a group tag with the given id, which must be a
+	 * valid XML id, and name, which is escaped. Its presentation attributes (serialized
+	 * as by generate_path_attributes()) are inherited by its content. The paths written
+	 * so far are flushed first.
+	 */
+	void generate_opening_group(std::string const& id, std::string const& name, std::string const& attributes_fragment);
+	void generate_closing_group();
+
+	/*!
+	 * @brief Generate the content of a marker's symbol, centered on the origin.
+	 * Vector markers are written as paths, bitmap markers as an image that embeds
+	 * the bitmap as a PNG data URI (or as a black rectangle for the default marker,
+	 * with no 'filename').
+	 */
+	void generate_marker(marker& m, std::string const& filename);
+
+	/*!
+	 * @brief Generate the content of the built-in markers of markers symbolizers.
+	 */
+	void generate_ellipse_marker(double rx, double ry, path_output_attributes const& attributes);
+	void generate_arrow_marker(path_output_attributes const& attributes);
+
+	/*!
+	 * @brief Generate a use tag that draws a symbol with the given transformation.
+	 * Translations are written as the x and y attributes of the tag, any other
+	 * transformation as a matrix.
+	 */
+	void generate_use(std::string const& id, agg::trans_affine const& matrix, double opacity);
+
+	/*!
+	 * @brief Generate an image tag that embeds 'image' as a PNG data URI, with its top
+	 * left corner at (x, y). The PNG is base64-encoded into the output as it is written.
+	 */
+	void generate_image(double x, double y, image_data_32 const& image, double opacity);
+
+	/*!
+	 * @brief Generate a text tag for a label laid out by placement_finder, whose
+	 * characters start at (x, y). Each character is written with its own position
+	 * and rotation, so that the label follows its placement exactly. A text tag
+	 * stroked with the halo color is generated under it if the halo radius is set.
+	 */
+	void generate_text(text_path const& path, double x, double y, text_output_attributes const& attributes);
 	
     private:
+	/*!
+	 * @brief Generate the opening of a path tag, up to its 'd' attribute, written by PathEmitter.
+	 * @return false, writing nothing, if no part of the path is left after clipping.
+	 */
+	template <typename PathType>
+	bool generate_path_data(PathType const& path);
+
+	/*!
+	 * @brief Append the data of a path (the value of its 'd' attribute) to a string.
+	 * @return false, appending nothing, if no part of the path is left after clipping.
+	 */
+	template <typename PathType>
+	bool generate_path_data(PathType const& path, std::string& path_data);
+
+	/*!
+	 * @brief Shared implementation of the append_path() overloads.
+	 */
+	template <typename PathType>
+	void append_path_data(PathType const& path, std::string const& attributes_fragment);
+
+	/*!
+	 * @brief Generate the end of a path tag: its attributes, if any, and the closing bracket.
+	 */
+	void generate_path_end(std::string const& attributes_fragment);
+
+	/*!
+	 * @brief Open the group of the paths in source coordinates, unless it is open.
+	 */
+	void generate_opening_source_group();
+
+	/*!
+	 * @brief Generate the path tag for the current batch of paths, if any.
+	 */
+	void generate_batch_path();
+
+	/*!
+	 * @brief Generate the value of an href attribute that embeds 'image' as a PNG
+	 * data URI, base64-encoded into the output as it is written.
+	 */
+	void generate_png_data_uri(image_data_32 const& image);
+
+	/*!
+	 * @brief Generate the data of a marker path (closing polygons with 'Z').
+	 */
+	template <typename VertexSource>
+	void generate_marker_path_data(VertexSource& path, unsigned path_id);
+
+	/*!
+	 * @brief Generate a text tag, with the extra attributes of a halo if 'halo' is set.
+	 */
+	void generate_text_element(text_path const& path, double x, double y,
+				   text_output_attributes const& attributes, bool halo);
+
+	/*!
+	 * @brief Generate a transform attribute, with a leading space. The linear
+	 * part of the matrix is written with 'factor_precision' fractional digits,
+	 * the translation with the coordinate precision.
+	 */
+	void generate_transform(agg::trans_affine const& matrix, unsigned factor_precision = 6);
+
+	/*!
+	 * @brief Generate the value of a transform attribute: a matrix.
+	 */
+	void generate_matrix(agg::trans_affine const& matrix, unsigned factor_precision);
+
+	template <typename PathType>
+	static bool is_polygon(PathType const& path);
+
 	OutputIterator& output_iterator_;
+	unsigned coordinate_precision_;
+	path_commands_e path_commands_;
+	box2d<double> clip_box_;
+	bool clipping_;
+	double simplify_tolerance_;
+	bool douglas_peucker_;
+	std::string batch_path_data_;
+	std::string batch_attributes_fragment_;
+	agg::trans_affine source_matrix_;
+	bool source_group_open_;
     };
 }}
 
@@ -70,6 +70,17 @@ namespace mapnik { namespace svg {
 	void set_stroke_dasharray(const dash_array stroke_dasharray);
 	void set_stroke_dashoffset(const double stroke_dashoffset);
 
+	/*!
+	 * @brief Paint the fill or the stroke with the pattern of the given id.
+	 */
+	void set_fill_pattern(std::string const& pattern_id);
+	void set_stroke_pattern(std::string const& pattern_id);
+
+	/*!
+	 * @brief Set all the stroke attributes from a line symbolizer's stroke.
+	 */
+	void set_stroke(stroke const& path_stroke);
+
 	const std::string fill_color() const;
 	const double fill_opacity() const;
 	const std::string stroke_color() const;
@@ -176,11 +187,13 @@ namespace mapnik { namespace svg {
 	void set_height(const unsigned height);
 	void set_svg_version(const double svg_version);
 	void set_svg_namespace_url(std::string const& svg_namespace_url);
+	void set_xlink_namespace_url(std::string const& xlink_namespace_url);
 
 	const unsigned width() const;
 	const unsigned height() const;
 	const double svg_version() const;
 	const std::string svg_namespace_url() const;
+	const std::string xlink_namespace_url() const;
 
 	/*!
 	 * @brief Set members back to their default values.
@@ -191,12 +204,91 @@ namespace mapnik { namespace svg {
 	static const double SVG_VERSION;
 	// SVG XML namespace url.
 	static const std::string SVG_NAMESPACE_URL;
+	// XLink namespace url, used to refer to symbols and images.
+	static const std::string XLINK_NAMESPACE_URL;
 
     //private:
 	unsigned width_;
 	unsigned height_;
 	double svg_version_;
 	std::string svg_namespace_url_;
+	std::string xlink_namespace_url_;
+    };
+
+    /*!
+     * @brief SVG text tag attributes.
+     * This structure encapsulates the values needed to
+     * generate a text tag. It is meant to be filled with
+     * the values stored in text_ and shield_ symbolizers,
+     * and with the names of the font that lays out the text.
+     *
+     * The values are stored using the variable types that
+     * are required for output generation, but the interface
+     * is written with the original types. "set" methods
+     * perform the necessary conversions (i.e. from color to
+     * hex string).
+     */
+    struct text_output_attributes
+    {
+	text_output_attributes()
+	    : font_family_(),
+	      font_size_(10.0),
+	      font_weight_("normal"),
+	      font_style_("normal"),
+	      fill_color_("#000000"),
+	      fill_opacity_(1.0),
+	      halo_color_(255, 255, 255),
+	      halo_radius_(0.0)
+	{}
+
+	/*!
+	 * @brief Set the font family; characters that are special
+	 * in a quoted XML attribute are escaped.
+	 */
+	void set_font_family(std::string const& font_family);
+	void set_font_size(const double font_size);
+
+	/*!
+	 * @brief Set the font weight and style from the style name of
+	 * a font face (i.e. "Bold Oblique").
+	 */
+	void set_font_style_name(std::string const& style_name);
+
+	void set_fill_color(color const& fill_color);
+	void set_fill_opacity(const double fill_opacity);
+
+	/*!
+	 * @brief The halo is drawn as a stroke, twice as wide as
+	 * its radius, under the text (none if the radius is 0).
+	 * It is written by the generator itself, so its color is
+	 * kept as is.
+	 */
+	void set_halo_color(color const& halo_color);
+	void set_halo_radius(const double halo_radius);
+
+	const std::string font_family() const;
+	const double font_size() const;
+	const std::string font_weight() const;
+	const std::string font_style() const;
+	const std::string fill_color() const;
+	const double fill_opacity() const;
+	const color halo_color() const;
+	const double halo_radius() const;
+
+	/*!
+	 * @brief Set members back to their default values.
+	 */
+	void reset();
+
+    //private:
+	std::string font_family_;
+	double font_size_;
+	std::string font_weight_;
+	std::string font_style_;
+	std::string fill_color_;
+	double fill_opacity_;
+	color halo_color_;
+	double halo_radius_;
     };
 }}
 
@@ -0,0 +1,224 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_SVG_OUTPUT_BUFFER_HPP
+#define MAPNIK_SVG_OUTPUT_BUFFER_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+// stl
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// zlib
+struct z_stream_s;
+
+namespace mapnik { namespace svg {
+
+    /*!
+     * @brief Contiguous, growable byte buffer that receives the generated output.
+     * Characters are appended with an inline, non-virtual put(), so writing
+     * a character costs a compare and a store. Only when the buffer is full
+     * the (virtual) overflow() method is called, which in this class doubles
+     * the capacity. Subclasses override it to drain the buffer to some other
+     * destination in large chunks instead (see fd_output_buffer).
+     */
+    class MAPNIK_DECL output_buffer : private boost::noncopyable
+    {
+    public:
+	static const std::size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+	explicit output_buffer(std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+	virtual ~output_buffer();
+
+	inline void put(char c)
+	{
+	    if(pos_ == end_)
+	    {
+		overflow();
+	    }
+	    *pos_++ = c;
+	}
+
+	void write(char const* s, std::size_t n);
+
+	/*!
+	 * @brief Hand the pending bytes to the destination.
+	 * For the in-memory buffer this does nothing, the bytes stay in place.
+	 */
+	virtual void flush();
+
+	char const* data() const;
+	std::size_t size() const;
+	std::size_t capacity() const;
+	std::string str() const;
+
+	/*!
+	 * @brief Discard the pending bytes, keeping the allocated storage.
+	 */
+	void clear();
+
+    protected:
+	/*!
+	 * @brief Make room for at least one more character.
+	 */
+	virtual void overflow();
+
+	std::vector<char> buffer_;
+	char* pos_;
+	char* end_;
+    };
+
+    /*!
+     * @brief Output buffer that writes its content to a file descriptor.
+     * The buffer never grows: every time it fills up, its content is written
+     * to the descriptor with a single system call. The remaining bytes are
+     * written on flush() and on destruction. The descriptor is not closed.
+     */
+    class MAPNIK_DECL fd_output_buffer : public output_buffer
+    {
+    public:
+	explicit fd_output_buffer(int fd, std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+	~fd_output_buffer();
+
+	void flush();
+
+	/*!
+	 * @brief Number of bytes written to the descriptor so far.
+	 */
+	std::size_t bytes_written() const;
+
+    protected:
+	void overflow();
+
+    private:
+	int fd_;
+	std::size_t bytes_written_;
+    };
+
+    /*!
+     * @brief Output buffer that gzip-compresses its content into another buffer (svgz output).
+     * Every time the buffer fills up, its content is deflated into the destination
+     * buffer, so the uncompressed document is never held in memory as a whole; with
+     * an fd_output_buffer as destination, the memory used stays bounded. The gzip
+     * stream is completed by finish(), which is also called on destruction.
+     */
+    class MAPNIK_DECL gzip_output_buffer : public output_buffer
+    {
+    public:
+	static const int DEFAULT_COMPRESSION = -1;
+
+	/*!
+	 * @param destination the buffer that receives the compressed bytes.
+	 * @param level the zlib compression level, from 0 (none) to 9 (best),
+	 * or DEFAULT_COMPRESSION.
+	 */
+	explicit gzip_output_buffer(output_buffer& destination,
+				    int level = DEFAULT_COMPRESSION,
+				    std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+	~gzip_output_buffer();
+
+	/*!
+	 * @brief Compress the pending bytes so that they can be decompressed
+	 * on their own, and flush the destination. Flushing often degrades
+	 * the compression ratio.
+	 */
+	void flush();
+
+	/*!
+	 * @brief Compress the pending bytes and write the end of the gzip stream.
+	 * Nothing can be written to the buffer afterwards.
+	 */
+	void finish();
+
+	/*!
+	 * @brief Number of (uncompressed) bytes compressed so far.
+	 */
+	std::size_t bytes_in() const;
+
+    protected:
+	void overflow();
+
+    private:
+	void deflate_buffer(int flush);
+
+	output_buffer& destination_;
+	boost::scoped_ptr<z_stream_s> stream_;
+	std::vector<char> compressed_;
+	std::size_t bytes_in_;
+	bool finished_;
+    };
+
+    /*!
+     * @brief Output iterator over an output_buffer.
+     * It is the type svg_renderer and svg_generator are parameterized with
+     * when generating into a buffer. Copies of the iterator share the buffer.
+     */
+    class output_buffer_iterator
+	: public std::iterator<std::output_iterator_tag, void, void, void, void>
+    {
+    public:
+	explicit output_buffer_iterator(output_buffer& buffer)
+	    : buffer_(&buffer)
+	{}
+
+	inline output_buffer_iterator& operator=(char c)
+	{
+	    buffer_->put(c);
+	    return *this;
+	}
+
+	inline output_buffer_iterator& operator*()
+	{
+	    return *this;
+	}
+
+	inline output_buffer_iterator& operator++()
+	{
+	    return *this;
+	}
+
+	inline output_buffer_iterator& operator++(int)
+	{
+	    return *this;
+	}
+
+	inline output_buffer& buffer() const
+	{
+	    return *buffer_;
+	}
+
+    private:
+	output_buffer* buffer_;
+    };
+}}
+
+#endif // MAPNIK_SVG_OUTPUT_BUFFER_HPP
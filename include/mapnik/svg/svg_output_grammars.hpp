@@ -28,6 +28,7 @@
 #include <mapnik/ctrans.hpp>
 #include <mapnik/geometry.hpp>
 #include <mapnik/svg/svg_path_iterator.hpp>
+#include <mapnik/svg/svg_path_converters.hpp>
 #include <mapnik/svg/svg_output_attributes.hpp>
 
 // boost
@@ -85,6 +86,22 @@ BOOST_FUSION_ADAPT_STRUCT(
     (unsigned, height_)
     (double, svg_version_)
     (std::string, svg_namespace_url_)
+    (std::string, xlink_namespace_url_)
+)
+
+/*!
+ * mapnik::svg::text_output_attributes is adapted as a fusion sequence
+ * in order to be used directly by the svg_text_attributes_grammar (below).
+ * The halo attributes are written by the generator itself.
+ */
+BOOST_FUSION_ADAPT_STRUCT(
+    mapnik::svg::text_output_attributes,
+    (std::string, font_family_)
+    (double, font_size_)
+    (std::string, font_weight_)
+    (std::string, font_style_)
+    (std::string, fill_color_)
+    (double, fill_opacity_)
 )
 
 /*!
@@ -126,6 +143,89 @@ namespace boost { namespace spirit { namespace traits {
 	    return mapnik::svg::path_iterator_type(path);
 	}
     };
+
+    /*!
+     * mapnik::svg::coordinate_snapper wraps a path in the same
+     * way, so it is adapted as a container too. The wrapped path
+     * is rewound before iterating over it.
+     */
+    template <typename PathType>
+    struct is_container<mapnik::svg::coordinate_snapper<PathType> const>
+	: mpl::true_
+    {};
+
+    template <typename PathType>
+    struct container_iterator<mapnik::svg::coordinate_snapper<PathType> const>
+    {
+	typedef mapnik::svg::path_iterator<mapnik::svg::path_iterator_type::value_type,
+					   mapnik::svg::coordinate_snapper<PathType> > type;
+    };
+
+    template <typename PathType>
+    struct begin_container<mapnik::svg::coordinate_snapper<PathType> const>
+    {
+	typedef typename container_iterator<mapnik::svg::coordinate_snapper<PathType> const>::type iterator_type;
+
+	static iterator_type
+	call(mapnik::svg::coordinate_snapper<PathType> const& path)
+	{
+	    path.rewind(0);
+	    return iterator_type(0, path);
+	}
+    };
+
+    template <typename PathType>
+    struct end_container<mapnik::svg::coordinate_snapper<PathType> const>
+    {
+	typedef typename container_iterator<mapnik::svg::coordinate_snapper<PathType> const>::type iterator_type;
+
+	static iterator_type
+	call(mapnik::svg::coordinate_snapper<PathType> const& path)
+	{
+	    return iterator_type(path);
+	}
+    };
+
+    /*!
+     * mapnik::svg::path_command_encoder is adapted in the same way,
+     * its vertices carry the command character instead of the agg command.
+     */
+    template <typename PathType>
+    struct is_container<mapnik::svg::path_command_encoder<PathType> const>
+	: mpl::true_
+    {};
+
+    template <typename PathType>
+    struct container_iterator<mapnik::svg::path_command_encoder<PathType> const>
+    {
+	typedef mapnik::svg::path_iterator<mapnik::svg::path_iterator_type::value_type,
+					   mapnik::svg::path_command_encoder<PathType> > type;
+    };
+
+    template <typename PathType>
+    struct begin_container<mapnik::svg::path_command_encoder<PathType> const>
+    {
+	typedef typename container_iterator<mapnik::svg::path_command_encoder<PathType> const>::type iterator_type;
+
+	static iterator_type
+	call(mapnik::svg::path_command_encoder<PathType> const& path)
+	{
+	    path.rewind(0);
+	    return iterator_type(0, path);
+	}
+    };
+
+    template <typename PathType>
+    struct end_container<mapnik::svg::path_command_encoder<PathType> const>
+    {
+	typedef typename container_iterator<mapnik::svg::path_command_encoder<PathType> const>::type iterator_type;
+
+	static iterator_type
+	call(mapnik::svg::path_command_encoder<PathType> const& path)
+	{
+	    return iterator_type(path);
+	}
+    };
  }}}
 
 namespace mapnik { namespace svg {
@@ -133,38 +233,136 @@ namespace mapnik { namespace svg {
     using namespace boost::spirit;
     using namespace boost::phoenix;
 
+    /*!
+     * @brief Karma real number policy used to write path coordinates.
+     * Coordinates are always written in fixed notation (never with an exponent)
+     * with at most 'precision' fractional digits. Trailing zeros are omitted,
+     * and so is the decimal point when there is no fractional part left, which
+     * makes a precision of 0 write integral pixel coordinates.
+     */
+    template <typename T>
+    struct coordinate_policy : karma::real_policies<T>
+    {
+	typedef karma::real_policies<T> base_policy_type;
+
+	explicit coordinate_policy(unsigned precision = 3)
+	    : precision_(precision)
+	{}
+
+	static int floatfield(T n)
+	{
+	    return base_policy_type::fmtflags::fixed;
+	}
+
+	unsigned precision(T n) const
+	{
+	    return precision_;
+	}
+
+	template <typename OutputIterator>
+	static bool dot(OutputIterator& sink, T n, unsigned precision)
+	{
+	    if(n == 0)
+		return true;
+	    return base_policy_type::dot(sink, n, precision);
+	}
+
+	template <typename OutputIterator>
+	static bool fraction_part(OutputIterator& sink, T n, unsigned adjprec, unsigned precision)
+	{
+	    if(n == 0)
+		return true;
+	    return base_policy_type::fraction_part(sink, n, adjprec, precision);
+	}
+
+	unsigned precision_;
+    };
+
     template <typename OutputIterator, typename PathType>
     struct svg_path_data_grammar : karma::grammar<OutputIterator, PathType&()>
     {
         typedef path_iterator_type::value_type vertex_type;
 
-	explicit svg_path_data_grammar(PathType const& path_type)
+	typedef karma::real_generator<double, coordinate_policy<double> > coordinate_generator;
+
+	explicit svg_path_data_grammar(PathType const& path_type, unsigned precision = 3)
 	    : svg_path_data_grammar::base_type(svg_path),
-	      path_type_(path_type)
+	      path_type_(path_type),
+	      coordinate(coordinate_policy<double>(precision))
 	{
 	    using karma::int_;
-	    using karma::double_;
 	    using repository::confix;
 
 	    svg_path = 
 		lit("d=") 
 		<< confix('"', '"')[
-		    -(path_vertex % lit(' '))];
+		    path_data];
+
+	    path_data = -(path_vertex % lit(' '));
 
 	    path_vertex = 
 		path_vertex_command
-	        << double_
+		<< coordinate
 		<< lit(' ')
-	        << double_;
+		<< coordinate;
 
 	    path_vertex_command = &int_(1) << lit('M') | lit('L');
 	}
 
 	karma::rule<OutputIterator, PathType&()> svg_path;
+	karma::rule<OutputIterator, PathType&()> path_data;
 	karma::rule<OutputIterator, vertex_type()> path_vertex;
 	karma::rule<OutputIterator, int()> path_vertex_command;
 
 	PathType const& path_type_;
+	coordinate_generator coordinate;
+    };
+
+    /*!
+     * @brief Path data grammar for paths encoded by path_command_encoder.
+     * Each vertex is written right after the command character chosen by the
+     * encoder, with no separator: a relative or absolute command character
+     * separates it from the previous vertex, and an implied command (' ')
+     * becomes the separator itself. For example "M10 20 5 5l1 -1 2 0".
+     */
+    template <typename OutputIterator, typename PathType>
+    struct svg_path_commands_data_grammar : karma::grammar<OutputIterator, PathType&()>
+    {
+	typedef path_iterator_type::value_type vertex_type;
+
+	typedef karma::real_generator<double, coordinate_policy<double> > coordinate_generator;
+
+	explicit svg_path_commands_data_grammar(PathType const& path_type, unsigned precision = 3)
+	    : svg_path_commands_data_grammar::base_type(svg_path),
+	      path_type_(path_type),
+	      coordinate(coordinate_policy<double>(precision))
+	{
+	    using karma::char_;
+	    using repository::confix;
+
+	    svg_path = 
+		lit("d=") 
+		<< confix('"', '"')[
+		    path_data];
+
+	    path_data = *path_vertex;
+
+	    path_vertex = 
+		path_vertex_command
+		<< coordinate
+		<< lit(' ')
+		<< coordinate;
+
+	    path_vertex_command = char_;
+	}
+
+	karma::rule<OutputIterator, PathType&()> svg_path;
+	karma::rule<OutputIterator, PathType&()> path_data;
+	karma::rule<OutputIterator, vertex_type()> path_vertex;
+	karma::rule<OutputIterator, unsigned()> path_vertex_command;
+
+	PathType const& path_type_;
+	coordinate_generator coordinate;
     };
 
     template <typename OutputIterator>
@@ -191,6 +389,49 @@ namespace mapnik { namespace svg {
 	karma::rule<OutputIterator, mapnik::svg::path_output_attributes()> svg_path_attributes;
     };
 
+    /*!
+     * @brief Writes the path attributes as CSS declarations,
+     * to be used as the body of a class in a style sheet.
+     */
+    template <typename OutputIterator>
+    struct svg_path_style_grammar : karma::grammar<OutputIterator, mapnik::svg::path_output_attributes()>
+    {
+	explicit svg_path_style_grammar()
+	    : svg_path_style_grammar::base_type(svg_path_style)
+	{
+	    using karma::double_;
+	    using karma::string;
+
+	    svg_path_style = 
+		lit("fill:") << string
+		<< lit(";fill-opacity:") << double_
+		<< lit(";stroke:") << string
+		<< lit(";stroke-opacity:") << double_
+		<< lit(";stroke-width:") << double_ << lit("px")
+		<< lit(";stroke-linecap:") << string
+		<< lit(";stroke-linejoin:") << string
+		<< lit(";stroke-dashoffset:") << double_ << lit("px");
+	}
+
+	karma::rule<OutputIterator, mapnik::svg::path_output_attributes()> svg_path_style;
+    };
+
+    template <typename OutputIterator>
+    struct svg_path_dash_array_style_grammar : karma::grammar<OutputIterator, mapnik::dash_array()>
+    {
+	explicit svg_path_dash_array_style_grammar()
+	    : svg_path_dash_array_style_grammar::base_type(svg_path_dash_array_style)
+	{
+	    using karma::double_;
+
+	    svg_path_dash_array_style = 
+		lit(";stroke-dasharray:") 
+		<< ((double_ << lit(',') << double_) % lit(','));
+	}
+
+	karma::rule<OutputIterator, mapnik::dash_array()> svg_path_dash_array_style;
+    };
+
     template <typename OutputIterator>
     struct svg_path_dash_array_grammar : karma::grammar<OutputIterator, mapnik::dash_array()>
     {
@@ -209,6 +450,28 @@ namespace mapnik { namespace svg {
 	karma::rule<OutputIterator, mapnik::dash_array()> svg_path_dash_array;
     };
 
+    template <typename OutputIterator>
+    struct svg_text_attributes_grammar : karma::grammar<OutputIterator, mapnik::svg::text_output_attributes()>
+    {
+	explicit svg_text_attributes_grammar()
+	    : svg_text_attributes_grammar::base_type(svg_text_attributes)
+	{
+	    using karma::double_;
+	    using karma::string;
+	    using repository::confix;
+
+	    svg_text_attributes =
+		lit("font-family=") << confix('"', '"')[string]
+		<< lit(" font-size=") << confix('"', '"')[double_]
+		<< lit(" font-weight=") << confix('"', '"')[string]
+		<< lit(" font-style=") << confix('"', '"')[string]
+		<< lit(" fill=") << confix('"', '"')[string]
+		<< lit(" fill-opacity=") << confix('"', '"')[double_];
+	}
+
+	karma::rule<OutputIterator, mapnik::svg::text_output_attributes()> svg_text_attributes;
+    };
+
     template <typename OutputIterator>
     struct svg_rect_attributes_grammar : karma::grammar<OutputIterator, mapnik::svg::rect_output_attributes()>
     {
@@ -245,7 +508,8 @@ namespace mapnik { namespace svg {
 		lit("width=") << confix('"', '"')[int_ << lit("px")]
 		<< lit(" height=") << confix('"', '"')[int_ << lit("px")]
 		<< " version=" << confix('"', '"')[double_]
-		<< " xmlns=" << confix('"', '"')[string];
+		<< " xmlns=" << confix('"', '"')[string]
+		<< " xmlns:xlink=" << confix('"', '"')[string];
 	}
 
 	karma::rule<OutputIterator, mapnik::svg::root_output_attributes()> svg_root_attributes;
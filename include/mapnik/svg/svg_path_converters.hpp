@@ -0,0 +1,611 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_SVG_PATH_CONVERTERS_HPP
+#define MAPNIK_SVG_PATH_CONVERTERS_HPP
+
+// mapnik
+#include <mapnik/vertex.hpp>
+#include <mapnik/box2d.hpp>
+
+// agg
+#include "agg_basics.h"
+#include "agg_conv_clip_polyline.h"
+#include "agg_conv_clip_polygon.h"
+
+// stl
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace mapnik { namespace svg {
+
+    /*!
+     * @brief Kinds of commands written in path data.
+     * ABSOLUTE_PATH_COMMANDS writes every vertex with an absolute 'M' or 'L'
+     * command. RELATIVE_PATH_COMMANDS writes every vertex but the first one
+     * as a delta from the previous vertex ('m' and 'l'), and omits commands
+     * that are implied by the previous one. SHORTEST_PATH_COMMANDS chooses,
+     * for each vertex, whichever of the two is written with fewer characters.
+     */
+    enum path_commands_e
+    {
+	ABSOLUTE_PATH_COMMANDS,
+	RELATIVE_PATH_COMMANDS,
+	SHORTEST_PATH_COMMANDS
+    };
+
+    /*!
+     * @brief Rounds a coordinate to the given number of fractional digits.
+     * Halves are rounded away from zero, the same way Karma's real
+     * generators round the values they write.
+     */
+    inline double round_coordinate(double value, double scale)
+    {
+	if(value < 0.0)
+	{
+	    return -std::floor(-value * scale + 0.5) / scale;
+	}
+	return std::floor(value * scale + 0.5) / scale;
+    }
+
+    /*!
+     * @brief Number of characters needed to write a coordinate that has been
+     * rounded to 'precision' fractional digits, as coordinate_policy writes it:
+     * sign, integer digits and, if any, the dot and significant fractional digits.
+     */
+    inline unsigned coordinate_length(double value, double scale, unsigned precision)
+    {
+	double scaled = std::floor(std::fabs(value) * scale + 0.5);
+	unsigned length = (value < 0.0 && scaled != 0.0) ? 1 : 0;
+
+	double integer_part = std::floor(scaled / scale);
+	double fraction_part = scaled - integer_part * scale;
+	do
+	{
+	    ++length;
+	    integer_part = std::floor(integer_part / 10.0);
+	}
+	while(integer_part >= 1.0);
+
+	if(fraction_part >= 1.0)
+	{
+	    unsigned digits = precision;
+	    while(std::fmod(fraction_part, 10.0) == 0.0)
+	    {
+		fraction_part /= 10.0;
+		--digits;
+	    }
+	    length += digits + 1;
+	}
+	return length;
+    }
+
+    /*!
+     * @brief Transformation of paths written in source coordinates, for coord_transform2.
+     * The vertices are left in the map's projection: they are only transformed to image
+     * coordinates by the transform attribute of the group that contains the paths.
+     */
+    struct source_transform
+    {
+	inline void forward(double* x, double* y) const {}
+    };
+
+    /*!
+     * @brief Vertex converter that clips paths to a rectangle (i.e. the buffered map extent).
+     * Line strings are clipped with agg::conv_clip_polyline, which keeps the pieces that
+     * are inside the rectangle as separate sub-paths. Polygon rings are clipped with
+     * agg::conv_clip_polygon, which keeps them closed by running along the edges of
+     * the rectangle; the closing vertex of each clipped ring is returned explicitly.
+     * When clipping is disabled, the vertices of the wrapped path pass through.
+     *
+     * @tparam PathType the vertex source to clip, i.e. coord_transform2.
+     */
+    template <typename PathType>
+    class path_clipper
+    {
+    public:
+	typedef typename PathType::size_type size_type;
+	typedef typename PathType::value_type value_type;
+
+	path_clipper(PathType const& path, box2d<double> const& clip_box, bool clipping, bool polygon)
+	    : path_(path),
+	      polyline_clipper_(path),
+	      polygon_clipper_(path),
+	      clipping_(clipping),
+	      polygon_(polygon),
+	      start_x_(0.0),
+	      start_y_(0.0),
+	      last_x_(0.0),
+	      last_y_(0.0)
+	{
+	    polyline_clipper_.clip_box(clip_box.minx(), clip_box.miny(), clip_box.maxx(), clip_box.maxy());
+	    polygon_clipper_.clip_box(clip_box.minx(), clip_box.miny(), clip_box.maxx(), clip_box.maxy());
+	}
+
+	unsigned vertex(double* x, double* y) const
+	{
+	    if(!clipping_)
+	    {
+		return path_.vertex(x, y);
+	    }
+
+	    if(!polygon_)
+	    {
+		return polyline_clipper_.vertex(x, y);
+	    }
+
+	    unsigned command;
+	    while(!agg::is_stop(command = polygon_clipper_.vertex(x, y)))
+	    {
+		if(agg::is_end_poly(command))
+		{
+		    if(last_x_ != start_x_ || last_y_ != start_y_)
+		    {
+			*x = last_x_ = start_x_;
+			*y = last_y_ = start_y_;
+			return SEG_LINETO;
+		    }
+		    continue;
+		}
+
+		if(command == SEG_MOVETO)
+		{
+		    start_x_ = *x;
+		    start_y_ = *y;
+		}
+		last_x_ = *x;
+		last_y_ = *y;
+		return command;
+	    }
+	    return SEG_END;
+	}
+
+	void rewind(unsigned pos) const
+	{
+	    start_x_ = start_y_ = last_x_ = last_y_ = 0.0;
+	    if(!clipping_)
+	    {
+		path_.rewind(pos);
+	    }
+	    else if(!polygon_)
+	    {
+		polyline_clipper_.rewind(pos);
+	    }
+	    else
+	    {
+		polygon_clipper_.rewind(pos);
+	    }
+	}
+
+	/*!
+	 * @brief Whether no part of the path is left after clipping.
+	 */
+	bool empty() const
+	{
+	    double x, y;
+	    rewind(0);
+	    return vertex(&x, &y) == SEG_END;
+	}
+
+    private:
+	PathType const& path_;
+	mutable agg::conv_clip_polyline<PathType const> polyline_clipper_;
+	mutable agg::conv_clip_polygon<PathType const> polygon_clipper_;
+	bool clipping_;
+	bool polygon_;
+	mutable double start_x_;
+	mutable double start_y_;
+	mutable double last_x_;
+	mutable double last_y_;
+    };
+
+    /*!
+     * @brief Vertex converter that simplifies paths in image coordinates.
+     * Each sub-path is read as a whole and decimated: vertices closer than
+     * 'tolerance' pixels to the last kept vertex are dropped. Optionally, the
+     * remaining vertices are further simplified with the Douglas-Peucker
+     * algorithm, which drops the vertices that are closer than 'tolerance'
+     * to the line through the kept ones. The first and last vertices of each
+     * sub-path are always kept, so closed rings stay closed. A tolerance of 0
+     * disables the simplification.
+     *
+     * @tparam PathType the vertex source to simplify, i.e. path_clipper.
+     */
+    template <typename PathType>
+    class path_simplifier
+    {
+    public:
+	typedef typename PathType::size_type size_type;
+	typedef typename PathType::value_type value_type;
+
+	path_simplifier(PathType const& path, double tolerance, bool douglas_peucker)
+	    : path_(path),
+	      tolerance_(tolerance),
+	      douglas_peucker_(douglas_peucker),
+	      pos_(0),
+	      next_move_to_()
+	{}
+
+	unsigned vertex(double* x, double* y) const
+	{
+	    if(tolerance_ <= 0.0)
+	    {
+		return path_.vertex(x, y);
+	    }
+
+	    while(pos_ == vertices_.size())
+	    {
+		if(!read_sub_path())
+		{
+		    return SEG_END;
+		}
+	    }
+
+	    vertex2d const& v = vertices_[pos_++];
+	    *x = v.x;
+	    *y = v.y;
+	    return v.cmd;
+	}
+
+	void rewind(unsigned pos) const
+	{
+	    vertices_.clear();
+	    pos_ = 0;
+	    next_move_to_.cmd = SEG_END;
+	    path_.rewind(pos);
+	}
+
+    private:
+	/*!
+	 * @brief Read the next sub-path of the wrapped path and simplify it.
+	 * @return false if there are no sub-paths left.
+	 */
+	bool read_sub_path() const
+	{
+	    vertices_.clear();
+	    pos_ = 0;
+
+	    vertex2d v;
+	    if(next_move_to_.cmd != SEG_END)
+	    {
+		vertices_.push_back(next_move_to_);
+		next_move_to_.cmd = SEG_END;
+	    }
+	    while((v.cmd = path_.vertex(&v.x, &v.y)) != SEG_END)
+	    {
+		if(v.cmd == SEG_MOVETO && !vertices_.empty())
+		{
+		    next_move_to_ = v;
+		    break;
+		}
+		vertices_.push_back(v);
+	    }
+
+	    if(vertices_.empty())
+	    {
+		return false;
+	    }
+
+	    decimate();
+	    if(douglas_peucker_)
+	    {
+		simplify();
+	    }
+	    return true;
+	}
+
+	/*!
+	 * @brief Drop the vertices that are too close to the last kept vertex.
+	 */
+	void decimate() const
+	{
+	    std::size_t last = vertices_.size() - 1;
+	    std::size_t kept = 0;
+	    double tolerance2 = tolerance_ * tolerance_;
+
+	    for(std::size_t i = 1; i < last; ++i)
+	    {
+		if(distance2(vertices_[i], vertices_[kept]) >= tolerance2)
+		{
+		    vertices_[++kept] = vertices_[i];
+		}
+	    }
+	    if(last > 0)
+	    {
+		vertices_[++kept] = vertices_[last];
+	    }
+	    vertices_.resize(kept + 1);
+	}
+
+	/*!
+	 * @brief Drop the vertices that are too close to the simplified line (Douglas-Peucker).
+	 */
+	void simplify() const
+	{
+	    std::size_t size = vertices_.size();
+	    if(size < 3)
+	    {
+		return;
+	    }
+
+	    double tolerance2 = tolerance_ * tolerance_;
+	    keep_.assign(size, false);
+	    keep_[0] = keep_[size - 1] = true;
+
+	    // ranges of vertices that remain to be simplified.
+	    ranges_.clear();
+	    ranges_.push_back(std::make_pair(std::size_t(0), size - 1));
+	    while(!ranges_.empty())
+	    {
+		std::size_t first = ranges_.back().first;
+		std::size_t last = ranges_.back().second;
+		ranges_.pop_back();
+
+		double max_distance2 = 0.0;
+		std::size_t farthest = first;
+		for(std::size_t i = first + 1; i < last; ++i)
+		{
+		    double d2 = segment_distance2(vertices_[i], vertices_[first], vertices_[last]);
+		    if(d2 > max_distance2)
+		    {
+			max_distance2 = d2;
+			farthest = i;
+		    }
+		}
+
+		if(max_distance2 >= tolerance2)
+		{
+		    keep_[farthest] = true;
+		    ranges_.push_back(std::make_pair(first, farthest));
+		    ranges_.push_back(std::make_pair(farthest, last));
+		}
+	    }
+
+	    std::size_t kept = 0;
+	    for(std::size_t i = 1; i < size; ++i)
+	    {
+		if(keep_[i])
+		{
+		    vertices_[++kept] = vertices_[i];
+		}
+	    }
+	    vertices_.resize(kept + 1);
+	}
+
+	static double distance2(vertex2d const& a, vertex2d const& b)
+	{
+	    double dx = a.x - b.x;
+	    double dy = a.y - b.y;
+	    return dx * dx + dy * dy;
+	}
+
+	/*!
+	 * @brief Square of the distance from 'p' to the segment from 'a' to 'b'.
+	 */
+	static double segment_distance2(vertex2d const& p, vertex2d const& a, vertex2d const& b)
+	{
+	    double dx = b.x - a.x;
+	    double dy = b.y - a.y;
+	    double length2 = dx * dx + dy * dy;
+	    if(length2 == 0.0)
+	    {
+		return distance2(p, a);
+	    }
+
+	    double t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / length2;
+	    if(t <= 0.0)
+	    {
+		return distance2(p, a);
+	    }
+	    if(t >= 1.0)
+	    {
+		return distance2(p, b);
+	    }
+	    return distance2(p, vertex2d(a.x + t * dx, a.y + t * dy, SEG_LINETO));
+	}
+
+	PathType const& path_;
+	double tolerance_;
+	bool douglas_peucker_;
+	mutable std::vector<vertex2d> vertices_;
+	mutable std::size_t pos_;
+	mutable vertex2d next_move_to_;
+	mutable std::vector<bool> keep_;
+	mutable std::vector<std::pair<std::size_t, std::size_t> > ranges_;
+    };
+
+    /*!
+     * @brief Vertex converter that snaps coordinates to the output precision.
+     * Each coordinate of the wrapped path is rounded to 'precision' fractional
+     * digits (a precision of 0 snaps to integral pixels). Line-to vertices that
+     * end up at the same position as the previous vertex are skipped, as they
+     * would be written out as exact duplicates.
+     *
+     * Like coord_transform2, it is a read-only view of the wrapped path: vertex()
+     * and rewind() are const and the iteration state is kept in mutable members.
+     *
+     * @tparam PathType the vertex source to snap, i.e. path_simplifier.
+     */
+    template <typename PathType>
+    class coordinate_snapper
+    {
+    public:
+	typedef typename PathType::size_type size_type;
+	typedef typename PathType::value_type value_type;
+
+	coordinate_snapper(PathType const& path, unsigned precision)
+	    : path_(path),
+	      scale_(std::pow(10.0, static_cast<int>(precision))),
+	      last_x_(0.0),
+	      last_y_(0.0)
+	{}
+
+	unsigned vertex(double* x, double* y) const
+	{
+	    unsigned command;
+	    while((command = path_.vertex(x, y)) != SEG_END)
+	    {
+		*x = round_coordinate(*x, scale_);
+		*y = round_coordinate(*y, scale_);
+
+		if(command == SEG_LINETO && *x == last_x_ && *y == last_y_)
+		{
+		    continue;
+		}
+
+		last_x_ = *x;
+		last_y_ = *y;
+		return command;
+	    }
+	    return command;
+	}
+
+	void rewind(unsigned pos) const
+	{
+	    last_x_ = 0.0;
+	    last_y_ = 0.0;
+	    path_.rewind(pos);
+	}
+
+    private:
+	PathType const& path_;
+	double scale_;
+	mutable double last_x_;
+	mutable double last_y_;
+    };
+
+    /*!
+     * @brief Vertex converter that chooses the command written before each vertex.
+     * Instead of an agg command, vertex() returns the character to write in front
+     * of the vertex coordinates: 'M' or 'L' for absolute coordinates, 'm' or 'l'
+     * for coordinates relative to the previous vertex, which are then returned as
+     * deltas, and ' ' when the command is implied by the previous one (a command
+     * repeats itself, except that a move-to is followed by implicit line-tos).
+     *
+     * The wrapped path must already be snapped to 'precision' (see coordinate_snapper)
+     * so that the written deltas add up exactly to the absolute coordinates.
+     *
+     * @tparam PathType the vertex source to encode, i.e. coordinate_snapper.
+     */
+    template <typename PathType>
+    class path_command_encoder
+    {
+    public:
+	typedef typename PathType::size_type size_type;
+	typedef typename PathType::value_type value_type;
+
+	path_command_encoder(PathType const& path, path_commands_e commands, unsigned precision)
+	    : path_(path),
+	      commands_(commands),
+	      precision_(precision),
+	      scale_(std::pow(10.0, static_cast<int>(precision))),
+	      last_x_(0.0),
+	      last_y_(0.0),
+	      implied_command_(0)
+	{}
+
+	unsigned vertex(double* x, double* y) const
+	{
+	    unsigned command = path_.vertex(x, y);
+	    if(command == SEG_END)
+	    {
+		return SEG_END;
+	    }
+
+	    double dx = *x - last_x_;
+	    double dy = *y - last_y_;
+	    bool relative = false;
+
+	    // the first vertex of the path has no previous vertex to be relative to.
+	    if(implied_command_ != 0 && commands_ != ABSOLUTE_PATH_COMMANDS)
+	    {
+		relative = true;
+		if(commands_ == SHORTEST_PATH_COMMANDS)
+		{
+		    unsigned absolute_length = coordinate_length(*x, scale_, precision_)
+			+ coordinate_length(*y, scale_, precision_);
+		    unsigned relative_length = coordinate_length(dx, scale_, precision_)
+			+ coordinate_length(dy, scale_, precision_);
+
+		    // on ties, keep the kind of command that may be implied.
+		    relative = relative_length < absolute_length
+			|| (relative_length == absolute_length && implied_command_ == 'l');
+		}
+	    }
+
+	    char vertex_command;
+	    if(command == SEG_MOVETO)
+	    {
+		vertex_command = relative ? 'm' : 'M';
+	    }
+	    else
+	    {
+		vertex_command = relative ? 'l' : 'L';
+	    }
+
+	    last_x_ = *x;
+	    last_y_ = *y;
+	    if(relative)
+	    {
+		*x = dx;
+		*y = dy;
+	    }
+
+	    char written_command = (vertex_command == implied_command_) ? ' ' : vertex_command;
+	    if(vertex_command == 'M')
+	    {
+		implied_command_ = 'L';
+	    }
+	    else if(vertex_command == 'm')
+	    {
+		implied_command_ = 'l';
+	    }
+	    else
+	    {
+		implied_command_ = vertex_command;
+	    }
+	    return written_command;
+	}
+
+	void rewind(unsigned pos) const
+	{
+	    last_x_ = 0.0;
+	    last_y_ = 0.0;
+	    implied_command_ = 0;
+	    path_.rewind(pos);
+	}
+
+    private:
+	PathType const& path_;
+	path_commands_e commands_;
+	unsigned precision_;
+	double scale_;
+	mutable double last_x_;
+	mutable double last_y_;
+	mutable char implied_command_;
+    };
+}}
+
+#endif // MAPNIK_SVG_PATH_CONVERTERS_HPP
@@ -0,0 +1,239 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_SVG_PATH_EMITTERS_HPP
+#define MAPNIK_SVG_PATH_EMITTERS_HPP
+
+// mapnik
+#include <mapnik/vertex.hpp>
+#include <mapnik/svg/svg_output_grammars.hpp>
+
+// boost
+#include <boost/cstdint.hpp>
+#include <boost/spirit/include/karma.hpp>
+
+// stl
+#include <cmath>
+
+namespace mapnik { namespace svg {
+
+    /*!
+     * @brief Path emitter policy of svg_generator that writes path data with the
+     * Karma grammars of svg_output_grammars.hpp (the default).
+     *
+     * A path emitter writes the value of the 'd' attribute of a path: either a
+     * coordinate_snapper, whose vertices are written with absolute 'M' and 'L'
+     * commands, or a path_command_encoder, whose vertices carry the command
+     * character to write.
+     */
+    struct karma_path_emitter
+    {
+	template <typename OutputIterator, typename PathType>
+	static void generate_path_data(OutputIterator& output_iterator, PathType const& path, unsigned precision)
+	{
+	    svg_path_data_grammar<OutputIterator, PathType> data_grammar(path, precision);
+	    karma::generate(output_iterator, data_grammar.path_data, path);
+	}
+
+	template <typename OutputIterator, typename PathType>
+	static void generate_path_commands_data(OutputIterator& output_iterator, PathType const& path, unsigned precision)
+	{
+	    svg_path_commands_data_grammar<OutputIterator, PathType> data_grammar(path, precision);
+	    karma::generate(output_iterator, data_grammar.path_data, path);
+	}
+    };
+
+    /*!
+     * @brief Path emitter policy of svg_generator that writes path data by hand.
+     * No grammar is built per path: vertices are read straight from the path and
+     * each coordinate is formatted into a buffer on the stack. The output is byte
+     * for byte the one of karma_path_emitter.
+     */
+    struct fast_path_emitter
+    {
+	/*!
+	 * @brief Longest coordinate written by format_coordinate(): a sign,
+	 * 16 integral digits, a dot and 15 fractional digits.
+	 */
+	static const unsigned max_coordinate_length = 33;
+
+	template <typename OutputIterator, typename PathType>
+	static void generate_path_data(OutputIterator& output_iterator, PathType const& path, unsigned precision)
+	{
+	    double x;
+	    double y;
+	    unsigned command;
+	    bool first = true;
+
+	    path.rewind(0);
+	    while((command = path.vertex(&x, &y)) != SEG_END)
+	    {
+		if(!first)
+		{
+		    *output_iterator++ = ' ';
+		}
+		first = false;
+		*output_iterator++ = (command == SEG_MOVETO) ? 'M' : 'L';
+		generate_vertex(output_iterator, x, y, precision);
+	    }
+	}
+
+	template <typename OutputIterator, typename PathType>
+	static void generate_path_commands_data(OutputIterator& output_iterator, PathType const& path, unsigned precision)
+	{
+	    double x;
+	    double y;
+	    unsigned command;
+
+	    path.rewind(0);
+	    while((command = path.vertex(&x, &y)) != SEG_END)
+	    {
+		*output_iterator++ = static_cast<char>(command);
+		generate_vertex(output_iterator, x, y, precision);
+	    }
+	}
+
+	/*!
+	 * @brief Write a coordinate as coordinate_policy does.
+	 * Coordinates that format_coordinate() cannot write are written by Karma.
+	 */
+	template <typename OutputIterator>
+	static void generate_coordinate(OutputIterator& output_iterator, double value, unsigned precision)
+	{
+	    char buffer[max_coordinate_length];
+	    char* end = format_coordinate(buffer, value, precision);
+	    if(end)
+	    {
+		for(char const* c = buffer; c != end; ++c)
+		{
+		    *output_iterator++ = *c;
+		}
+	    }
+	    else
+	    {
+		coordinate_policy<double> policy(precision);
+		karma::real_generator<double, coordinate_policy<double> > coordinate(policy);
+		karma::generate(output_iterator, coordinate, value);
+	    }
+	}
+
+	/*!
+	 * @brief Format a coordinate into 'buffer', which must hold at least
+	 * max_coordinate_length characters, rounding it exactly as Karma's real
+	 * generators do: halves away from zero, in double arithmetic.
+	 * @return the end of the written characters, or a null pointer, writing
+	 * nothing, for a precision above 15 or a value that is not finite or whose
+	 * magnitude is 2^53 or more.
+	 */
+	static char* format_coordinate(char* buffer, double value, unsigned precision)
+	{
+	    static const double scales[] =
+	    {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+		1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+	    };
+	    static const double max_value = 9007199254740992.0;
+
+	    if(precision > 15 || !(value > -max_value && value < max_value))
+	    {
+		return 0;
+	    }
+
+	    bool negative = value < 0.0;
+	    double scale = scales[precision];
+	    double integer_part;
+	    double fraction_part = std::floor(std::modf(negative ? -value : value, &integer_part) * scale + 0.5);
+	    if(fraction_part >= scale)
+	    {
+		fraction_part = std::floor(fraction_part - scale);
+		integer_part += 1.0;
+	    }
+
+	    boost::uint64_t integer_digits = static_cast<boost::uint64_t>(integer_part);
+	    boost::uint64_t fraction_digits = static_cast<boost::uint64_t>(fraction_part);
+	    unsigned digits = 0;
+	    if(fraction_digits != 0)
+	    {
+		// trailing zeros are omitted.
+		digits = precision;
+		while(fraction_digits % 10 == 0)
+		{
+		    fraction_digits /= 10;
+		    --digits;
+		}
+	    }
+
+	    char* end = buffer;
+	    // zero is written without a sign.
+	    if(negative && (integer_digits != 0 || fraction_digits != 0))
+	    {
+		*end++ = '-';
+	    }
+	    end = format_digits(end, integer_digits, 1);
+	    if(fraction_digits != 0)
+	    {
+		*end++ = '.';
+		end = format_digits(end, fraction_digits, digits);
+	    }
+	    return end;
+	}
+
+    private:
+	template <typename OutputIterator>
+	static void generate_vertex(OutputIterator& output_iterator, double x, double y, unsigned precision)
+	{
+	    generate_coordinate(output_iterator, x, precision);
+	    *output_iterator++ = ' ';
+	    generate_coordinate(output_iterator, y, precision);
+	}
+
+	/*!
+	 * @brief Write the decimal digits of 'value', left-padded
+	 * with zeros to 'width' digits.
+	 */
+	static char* format_digits(char* buffer, boost::uint64_t value, unsigned width)
+	{
+	    char digits[20];
+	    unsigned length = 0;
+	    do
+	    {
+		digits[length++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	    }
+	    while(value != 0);
+
+	    for(; width > length; --width)
+	    {
+		*buffer++ = '0';
+	    }
+	    while(length != 0)
+	    {
+		*buffer++ = digits[--length];
+	    }
+	    return buffer;
+	}
+    };
+}}
+
+#endif // MAPNIK_SVG_PATH_EMITTERS_HPP
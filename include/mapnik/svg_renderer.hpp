@@ -27,25 +27,46 @@
 
 // mapnik
 #include <mapnik/feature_style_processor.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/label_collision_detector.hpp>
 #include <mapnik/svg/svg_generator.hpp>
 #include <mapnik/svg/svg_output_attributes.hpp>
+#include <mapnik/svg/svg_output_buffer.hpp>
 
 // stl
+#include <map>
 #include <string>
+#include <vector>
 
 namespace mapnik 
 {
     // parameterized with the type of output iterator it will use for output.
     // output iterators add more flexibility than streams, because iterators
-    // can target many other output destinations besides streams.
-    template <typename OutputIterator>
-    class MAPNIK_DECL svg_renderer : public feature_style_processor<svg_renderer<OutputIterator> >, 
+    // can target many other output destinations besides streams. path data is
+    // written by PathEmitter: svg::karma_path_emitter (the default), or
+    // svg::fast_path_emitter, which writes the same bytes faster.
+    template <typename OutputIterator, typename PathEmitter = svg::karma_path_emitter>
+    class MAPNIK_DECL svg_renderer : public feature_style_processor<svg_renderer<OutputIterator, PathEmitter> >, 
 				     private boost::noncopyable
     {
     public:
-	svg_renderer(Map const& m, OutputIterator& output_iterator, unsigned offset_x=0, unsigned offset_y=0);
+	/*!
+	 * @brief Renderer of a window of the map's image (e.g. a tile): the document is
+	 * 'width' by 'height' pixels, and shows the part of the image whose top left
+	 * corner is at ('offset_x', 'offset_y'). Paths are clipped to the window,
+	 * enlarged by the map's buffer size. A width or height of 0 stands for the
+	 * map's, so that by default the whole image is rendered.
+	 */
+	svg_renderer(Map const& m, OutputIterator& output_iterator, unsigned offset_x=0, unsigned offset_y=0,
+		     unsigned width=0, unsigned height=0);
 	~svg_renderer();
 
+	/*!
+	 * @brief Render the map, rendering its layers in parallel if
+	 * more than one layer thread is set (see set_layer_threads).
+	 */
+	void apply();
+
 	void start_map_processing(Map const& map);
 	void end_map_processing(Map const& map);
 	void start_layer_processing(layer const& lay);
@@ -106,13 +127,385 @@ namespace mapnik
 	    return output_iterator_;
 	}
 
+	/*!
+	 * @brief Number of fractional digits written for path coordinates (3 by default).
+	 * A precision of 0 snaps the generated paths to integral pixel coordinates.
+	 */
+	inline void set_coordinate_precision(unsigned precision)
+	{
+	    generator_.set_coordinate_precision(precision);
+	}
+
+	inline unsigned coordinate_precision() const
+	{
+	    return generator_.coordinate_precision();
+	}
+
+	/*!
+	 * @brief Whether paths are clipped to the map extent, enlarged by the map's
+	 * buffer size (enabled by default). Off-screen parts of geometries are then
+	 * not written at all.
+	 */
+	inline void set_clipping(bool clipping)
+	{
+	    generator_.set_clipping(clipping);
+	}
+
+	inline bool clipping() const
+	{
+	    return generator_.clipping();
+	}
+
+	/*!
+	 * @brief Tolerance, in pixels, used to simplify the paths of symbolizers that
+	 * do not set their own. It defaults to the map's "simplify-tolerance" parameter,
+	 * or 0 (no simplification). Douglas-Peucker simplification is optional and
+	 * applies after the distance-based decimation.
+	 */
+	inline void set_simplify_tolerance(double tolerance)
+	{
+	    simplify_tolerance_ = tolerance;
+	}
+
+	inline double simplify_tolerance() const
+	{
+	    return simplify_tolerance_;
+	}
+
+	inline void set_douglas_peucker(bool douglas_peucker)
+	{
+	    generator_.set_douglas_peucker(douglas_peucker);
+	}
+
+	inline bool douglas_peucker() const
+	{
+	    return generator_.douglas_peucker();
+	}
+
+	/*!
+	 * @brief Kind of commands written in path data: absolute (the default),
+	 * relative, or whichever is shorter for each vertex.
+	 */
+	inline void set_path_commands(svg::path_commands_e commands)
+	{
+	    generator_.set_path_commands(commands);
+	}
+
+	inline svg::path_commands_e path_commands() const
+	{
+	    return generator_.path_commands();
+	}
+
+	/*!
+	 * @brief Whether path styles are written once, as classes of a style sheet.
+	 * When enabled, the distinct path attributes of the map's rules are written
+	 * as CSS classes at the top of the document and each path only refers to its
+	 * class, instead of repeating the whole set of attributes (disabled by default).
+	 */
+	inline void set_style_classes(bool style_classes)
+	{
+	    style_classes_ = style_classes;
+	}
+
+	inline bool style_classes() const
+	{
+	    return style_classes_;
+	}
+
+	/*!
+	 * @brief Whether each layer is written in its own group (disabled by default), so
+	 * that clients can show and hide layers. The group's id is "layer-", the layer's
+	 * index in the map, "-" and its name reduced to the characters allowed in an XML
+	 * id; its data-name attribute is the layer's name. The path
+	 * attributes shared by all the rules of a layer's styles are then written once,
+	 * on the group, and omitted from its paths. They are only hoisted in layers whose
+	 * rules draw nothing but lines and polygons, and not when style classes are used.
+	 */
+	inline void set_layer_groups(bool layer_groups)
+	{
+	    layer_groups_ = layer_groups;
+	}
+
+	inline bool layer_groups() const
+	{
+	    return layer_groups_;
+	}
+
+	/*!
+	 * @brief Whether consecutive paths with the same attributes are merged (disabled by default).
+	 * Within a layer, the geometries of consecutive features that are drawn with the
+	 * same attributes are written as the sub-paths of a single path element. Since
+	 * the merged geometries are painted at once, overlapping translucent parts are
+	 * blended only once, and the fill of a polygon may cover the stroke of the
+	 * previous one.
+	 */
+	inline void set_path_batching(bool path_batching)
+	{
+	    path_batching_ = path_batching;
+	}
+
+	inline bool path_batching() const
+	{
+	    return path_batching_;
+	}
+
+	/*!
+	 * @brief Whether paths are written in source coordinates (disabled by default).
+	 * The vertices of the paths of each layer are then written in the map's projection,
+	 * inside a group whose transform attribute maps them to the image, instead of being
+	 * transformed to image coordinates one by one. The coordinate precision then applies
+	 * to map units, while clipping and simplification tolerances stay in pixels. Strokes
+	 * are written with vector-effect="non-scaling-stroke", so that their width stays the
+	 * same when the document is scaled. Markers are still placed in image coordinates.
+	 */
+	void set_source_coordinates(bool source_coordinates);
+
+	inline bool source_coordinates() const
+	{
+	    return source_coordinates_;
+	}
+
+	/*!
+	 * @brief Number of threads that render the layers (1 by default, the layers are
+	 * rendered in turn). With more threads, each visible layer is rendered into its
+	 * own buffer by a pool of threads, and the buffers are written in layer order.
+	 * Markers and labels then only avoid those of their own layer, and the layers'
+	 * datasources are queried concurrently. The render stats of the layers are
+	 * merged in layer order. An error in a layer thread is thrown by apply(), as a
+	 * std::runtime_error, once the threads are done. Without MAPNIK_THREADSAFE,
+	 * layers are always rendered in turn.
+	 */
+	inline void set_layer_threads(unsigned threads)
+	{
+	    layer_threads_ = threads;
+	}
+
+	inline unsigned layer_threads() const
+	{
+	    return layer_threads_;
+	}
+
     private:
+	template <typename, typename> friend class svg_renderer;
+
+	Map const& map_;
 	OutputIterator& output_iterator_;
 	const int width_;
 	const int height_;
 	CoordTransform t_;
-	svg::svg_generator<OutputIterator> generator_;
+	svg::svg_generator<OutputIterator, PathEmitter> generator_;
 	svg::path_output_attributes path_attributes_;
+	bool style_classes_;
+	bool layer_groups_;
+	bool path_batching_;
+	bool source_coordinates_;
+	double simplify_tolerance_;
+	freetype_engine font_engine_;
+	face_manager<freetype_engine> font_manager_;
+	label_collision_detector4 detector_;
+	unsigned layer_threads_;
+
+	/*!
+	 * @brief Ids of the symbols generated so far, by marker (file name, or
+	 * description of a built-in marker). Each distinct marker is written once,
+	 * as a symbol, and every placement of the marker refers to it.
+	 */
+	std::map<std::string, std::string> symbol_ids_;
+	std::string symbol_id_prefix_;
+
+	/*!
+	 * @brief Serialized path attributes (or class reference) of each rule.
+	 * Symbolizer attributes do not depend on the feature, so they are
+	 * serialized once per rule instead of once per path.
+	 */
+	std::map<rule::symbolizers const*, std::string> path_attributes_fragments_;
+
+	/*!
+	 * @brief Rules of the current layer whose serialized path attributes
+	 * omit those written on the layer's group.
+	 */
+	std::vector<rule::symbolizers const*> hoisted_rules_;
+
+	/*!
+	 * @brief Write the distinct path styles of the map's rules as a style sheet.
+	 */
+	void generate_style_classes(Map const& map);
+
+	/*!
+	 * @brief Serialize the path attributes shared by all the rules of a layer's
+	 * styles, for its group, and cache the remaining ones of each rule.
+	 * @return an empty string if no attribute can be hoisted onto the group.
+	 */
+	std::string hoist_path_attributes(layer const& lay);
+
+	/*!
+	 * @brief Id of a layer's group, unique in the document and distinct from
+	 * the ids of symbols, even if layers share a name.
+	 */
+	std::string layer_group_id(layer const& lay) const;
+
+	/*!
+	 * @brief Split serialized path attributes into name="value" pairs.
+	 */
+	static std::vector<std::string> split_path_attributes(std::string const& fragment);
+
+	/*!
+	 * @brief Finish the serialized attributes of a path tag (or its class reference).
+	 */
+	std::string path_attributes_fragment(std::string const& fragment) const;
+
+	/*!
+	 * @brief Write the paths of the geometries of 'feature' with the path attributes
+	 * collected from the path symbolizers of a rule, and reset the attributes.
+	 */
+	void generate_feature_paths(rule::symbolizers const& syms, Feature const& feature,
+				    proj_transform const& prj_trans, double simplify_tolerance, bool patterns);
+
+	/*!
+	 * @brief Look up the id of the symbol generated for a marker.
+	 * @return false if there is none yet; 'id' is then set to a new id,
+	 * under which the caller must generate the marker's symbol.
+	 */
+	bool find_symbol(std::string const& marker_key, std::string& id);
+
+	/*!
+	 * @brief Attributes of the text tags of a text or shield symbolizer's labels, laid
+	 * out with 'faces' at 'text_size' pixels. The font family and style are those of
+	 * the face of the label's first character.
+	 */
+	svg::text_output_attributes text_attributes(text_symbolizer const& sym, face_set_ptr const& faces,
+						    string_info const& info, double text_size) const;
+
+	/*!
+	 * @brief Generate the use tag of a shield's marker centered on (x, y), and the
+	 * marker's symbol if 'symbol_id' is empty (setting it to the symbol's id).
+	 */
+	void generate_shield(std::string& symbol_id, std::string const& filename, marker& m,
+			     agg::trans_affine const& tr, double x, double y, double opacity);
+
+	/*!
+	 * @brief Id of the pattern that tiles a marker (read from 'filename'),
+	 * generating the pattern the first time it is used.
+	 */
+	std::string find_pattern(std::string const& filename, marker& m);
+
+	/*!
+	 * @brief The visible layers to render in parallel, and their output buffers.
+	 */
+	struct layer_jobs;
+
+	/*!
+	 * @brief Render the visible layers with layer_threads() threads. Only
+	 * called by apply() with MAPNIK_THREADSAFE.
+	 */
+	void apply_to_layers_in_parallel();
+
+	/*!
+	 * @brief Render the next layers of 'jobs' until there are none left (a layer thread).
+	 */
+	void render_layers(layer_jobs& jobs);
+
+	/*!
+	 * @brief Give a renderer writing part of this renderer's document (the start
+	 * of the map, or a layer) the same transform and output settings.
+	 */
+	void configure_part_renderer(svg_renderer<svg::output_buffer_iterator, PathEmitter>& renderer) const;
+
+	/*!
+	 * @brief Visitor that returns the simplification tolerance set on a symbolizer.
+	 */
+	struct simplify_tolerance_dispatch : public boost::static_visitor<double>
+	{
+	    template <typename Symbolizer>
+	    double operator()(Symbolizer const& sym) const
+	    {
+		return sym.simplify_tolerance();
+	    }
+	};
+
+	/*!
+	 * @brief Visitor that tells whether a symbolizer draws the geometries as paths.
+	 */
+	struct path_symbolizer_dispatch : public boost::static_visitor<bool>
+	{
+	    bool operator()(line_symbolizer const& sym) const
+	    {
+		return true;
+	    }
+
+	    bool operator()(polygon_symbolizer const& sym) const
+	    {
+		return true;
+	    }
+
+	    bool operator()(line_pattern_symbolizer const& sym) const
+	    {
+		return true;
+	    }
+
+	    bool operator()(polygon_pattern_symbolizer const& sym) const
+	    {
+		return true;
+	    }
+
+	    template <typename Symbolizer>
+	    bool operator()(Symbolizer const& sym) const
+	    {
+		return false;
+	    }
+	};
+
+	/*!
+	 * @brief Visitor that tells whether a symbolizer paints paths with a pattern.
+	 * The pattern's file name may depend on the feature, so the attributes of
+	 * their paths are not cached by rule.
+	 */
+	struct pattern_symbolizer_dispatch : public boost::static_visitor<bool>
+	{
+	    bool operator()(line_pattern_symbolizer const& sym) const
+	    {
+		return true;
+	    }
+
+	    bool operator()(polygon_pattern_symbolizer const& sym) const
+	    {
+		return true;
+	    }
+
+	    template <typename Symbolizer>
+	    bool operator()(Symbolizer const& sym) const
+	    {
+		return false;
+	    }
+	};
+
+	/*!
+	 * @brief Visitor that collects the path attributes of a symbolizer, without a feature.
+	 * It is used to find out the path styles of a rule before any feature is rendered.
+	 */
+	struct path_attributes_dispatch : public boost::static_visitor<>
+	{
+	    explicit path_attributes_dispatch(svg::path_output_attributes& path_attributes)
+		: path_attributes_(path_attributes)
+	    {}
+
+	    void operator()(line_symbolizer const& sym) const
+	    {
+		path_attributes_.set_stroke(sym.get_stroke());
+	    }
+
+	    void operator()(polygon_symbolizer const& sym) const
+	    {
+		path_attributes_.set_fill_color(sym.get_fill());
+		path_attributes_.set_fill_opacity(sym.get_opacity());
+	    }
+
+	    template <typename Symbolizer>
+	    void operator()(Symbolizer const& sym) const
+	    {}
+
+	    svg::path_output_attributes& path_attributes_;
+	};
 
 	/*!
 	 * @brief Visitor that makes the calls to process each symbolizer when stored in a boost::variant.
@@ -122,7 +515,7 @@ namespace mapnik
 	 */
 	struct symbol_dispatch : public boost::static_visitor<>
 	{
-	    symbol_dispatch(svg_renderer<OutputIterator>& processor,
+	    symbol_dispatch(svg_renderer<OutputIterator, PathEmitter>& processor,
 			    Feature const& feature, 
 			    proj_transform const& prj_trans)
 		: processor_(processor),
@@ -136,7 +529,7 @@ namespace mapnik
 		processor_.process(sym, feature_, prj_trans_);
 	    }
 
-	    svg_renderer<OutputIterator>& processor_;
+	    svg_renderer<OutputIterator, PathEmitter>& processor_;
 	    Feature const& feature_;
 	    proj_transform const& prj_trans_;
 	};
@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef SVG_TILE_RENDERER_HPP
+#define SVG_TILE_RENDERER_HPP
+
+// mapnik
+#include <mapnik/feature_style_processor.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+// stl
+#include <vector>
+
+namespace mapnik 
+{
+    /*!
+     * @brief Renders the map's image (a metatile) as a grid of SVG documents, in one pass.
+     * The features of each layer are queried once, for the whole map, and each of them
+     * is rendered by the tiles it intersects (enlarged by the map's buffer size). Each
+     * tile is an svg_renderer of a window of the image, which clips its paths to the
+     * tile and writes its document to its own output iterator.
+     */
+    template <typename OutputIterator>
+    class MAPNIK_DECL svg_tile_renderer : public feature_style_processor<svg_tile_renderer<OutputIterator> >,
+					  private boost::noncopyable
+    {
+    public:
+	typedef svg_renderer<OutputIterator> tile_renderer_type;
+
+	/*!
+	 * @brief Split the map's image into 'columns' by 'rows' tiles.
+	 * @param output_iterators the output iterators of the tiles' documents, row
+	 * by row: there must be columns * rows of them. Tiles are as large as the
+	 * image divided by the number of columns and rows, rounded down; the last
+	 * column and row take the remaining pixels.
+	 */
+	svg_tile_renderer(Map const& m, unsigned columns, unsigned rows, std::vector<OutputIterator>& output_iterators);
+	~svg_tile_renderer();
+
+	void start_map_processing(Map const& map);
+	void end_map_processing(Map const& map);
+	void start_layer_processing(layer const& lay);
+	void end_layer_processing(layer const& lay);
+
+	/*!
+	 * @brief Render a symbolizer with the tiles that the feature intersects.
+	 */
+	template <typename Symbolizer>
+	void process(Symbolizer const& sym,
+		     Feature const& feature,
+		     proj_transform const& prj_trans)
+	{
+	    box2d<double> extent = feature_extent(feature, prj_trans);
+	    for(unsigned i = 0; i < tiles_.size(); ++i)
+	    {
+		if(windows_[i].intersects(extent))
+		{
+		    tiles_[i]->process(sym, feature, prj_trans);
+		}
+	    }
+	}
+
+	/*!
+	 * @brief Render the whole set of symbolizers of a rule with the tiles that the feature intersects.
+	 * @return true, meaning that this renderer can process multiple symbolizers.
+	 */
+	bool process(rule::symbolizers const& syms,
+		     Feature const& feature,
+		     proj_transform const& prj_trans);
+
+	inline unsigned columns() const
+	{
+	    return columns_;
+	}
+
+	inline unsigned rows() const
+	{
+	    return rows_;
+	}
+
+	/*!
+	 * @brief The renderer of a tile, to set its options (precision, batching...) before rendering.
+	 */
+	inline tile_renderer_type& tile(unsigned column, unsigned row)
+	{
+	    return *tiles_[row * columns_ + column];
+	}
+
+    private:
+	/*!
+	 * @brief Extent of a feature in the map's image: that of its raster if it has one,
+	 * else that of its geometries. Features with neither cover the whole image.
+	 */
+	box2d<double> feature_extent(Feature const& feature, proj_transform const& prj_trans) const;
+
+	unsigned columns_;
+	unsigned rows_;
+	CoordTransform t_;
+	std::vector<boost::shared_ptr<tile_renderer_type> > tiles_;
+
+	/*!
+	 * @brief Extent of each tile in the map's image, enlarged by the map's buffer size.
+	 */
+	std::vector<box2d<double> > windows_;
+    };
+}
+
+#endif //SVG_TILE_RENDERER_HPP
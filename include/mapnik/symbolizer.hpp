@@ -43,7 +43,8 @@ class MAPNIK_DECL symbolizer_base {
             properties_(),
             properties_complete_(),
             writer_name_(),
-            writer_ptr_() {}
+            writer_ptr_(),
+            simplify_tolerance_(0.0) {}
             
         /** Add a metawriter to this symbolizer.
           *
@@ -73,11 +74,19 @@ class MAPNIK_DECL symbolizer_base {
         metawriter_properties const& get_metawriter_properties_overrides() const {return properties_;}
         /** Get metawriter name. */
         std::string const& get_metawriter_name() const {return writer_name_;}
+        /** Set the tolerance, in pixels, used by renderers that simplify the
+          * geometries drawn by this symbolizer. 0 (the default) means that the
+          * renderer's own tolerance applies.
+          */
+        void set_simplify_tolerance(double tolerance) {simplify_tolerance_ = tolerance;}
+        /** Get the simplification tolerance in pixels. */
+        double simplify_tolerance() const {return simplify_tolerance_;}
     private:
         metawriter_properties properties_;
         metawriter_properties properties_complete_;
         std::string writer_name_;
         metawriter_ptr writer_ptr_;
+        double simplify_tolerance_;
 
 };
 
@@ -0,0 +1,141 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_TRACER_HPP
+#define MAPNIK_TRACER_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
+// stl
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace mapnik {
+
+/** Records when the phases of a render begin and end, in each thread, and
+  * writes them as Chrome trace events (chrome://tracing, or any viewer of
+  * the trace event format). Renderers record into a tracer when they are
+  * given one, with set_tracer(): the map, each layer, the query of its
+  * features and their iteration for each style, and label placement.
+  *
+  * Phases are named by strings that must outlive the tracer, like literals.
+  * Without a tracer, trace_scope does nothing, and allocates nothing.
+  */
+class MAPNIK_DECL tracer : private boost::noncopyable
+{
+public:
+    tracer();
+
+    /** Records the beginning of a phase in the calling thread.
+      * \param detail Shown as the "name" argument of the event, if not empty
+      */
+    void begin(char const* name, char const* category, std::string const& detail = std::string());
+
+    /** Records the end of the last phase begun in the calling thread. */
+    void end(char const* name, char const* category);
+
+    /** Number of events recorded. */
+    std::size_t size() const;
+
+    void clear();
+
+    /** Writes the events as a JSON trace, whose timestamps are microseconds
+      * since the tracer was created or cleared.
+      */
+    void write_json(std::ostream & out) const;
+
+    std::string to_json() const;
+
+private:
+    struct event
+    {
+        char const* name;
+        char const* category;
+        char phase;
+        double timestamp;
+        unsigned thread;
+        std::string detail;
+    };
+
+    void add(char const* name, char const* category, char phase, std::string const& detail);
+
+    std::vector<event> events_;
+    double start_;
+#ifdef MAPNIK_THREADSAFE
+    std::vector<boost::thread::id> threads_;
+    mutable boost::mutex mutex_;
+#endif
+};
+
+/** Phase that lasts as long as the scope, recorded if the tracer is not null. */
+class trace_scope : private boost::noncopyable
+{
+public:
+    trace_scope(tracer * t, char const* name, char const* category = "render")
+        : tracer_(t),
+          name_(name),
+          category_(category)
+    {
+        if (tracer_)
+        {
+            tracer_->begin(name_, category_);
+        }
+    }
+
+    trace_scope(tracer * t, char const* name, char const* category, std::string const& detail)
+        : tracer_(t),
+          name_(name),
+          category_(category)
+    {
+        if (tracer_)
+        {
+            tracer_->begin(name_, category_, detail);
+        }
+    }
+
+    ~trace_scope()
+    {
+        if (tracer_)
+        {
+            tracer_->end(name_, category_);
+        }
+    }
+
+private:
+    tracer * tracer_;
+    char const* name_;
+    char const* category_;
+};
+}
+
+#endif // MAPNIK_TRACER_HPP
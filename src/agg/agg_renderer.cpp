@@ -112,7 +112,7 @@ private:
 
 
 template <typename T>
-agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, unsigned offset_x, unsigned offset_y)
+agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, int offset_x, int offset_y)
     : feature_style_processor<agg_renderer>(m, scale_factor),
       pixmap_(pixmap),
       width_(pixmap_.width()),
@@ -121,7 +121,9 @@ agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, uns
       t_(m.width(),m.height(),m.get_current_extent(),offset_x,offset_y),
       font_engine_(),
       font_manager_(font_engine_),
-      detector_(box2d<double>(-m.buffer_size(), -m.buffer_size(), m.width() + m.buffer_size() ,m.height() + m.buffer_size())),
+      // the map's image, enlarged by its buffer size, in the coordinates of the pixmap
+      detector_(box2d<double>(-m.buffer_size() - offset_x, -m.buffer_size() - offset_y,
+                              m.width() + m.buffer_size() - offset_x, m.height() + m.buffer_size() - offset_y)),
       ras_ptr(new rasterizer)
 {
     boost::optional<color> const& bg = m.background();
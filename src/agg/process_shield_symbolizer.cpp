@@ -157,12 +157,15 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
                             label_x += boost::get<0>(shield_pos);
                             label_y += boost::get<1>(shield_pos);
 
-                            finder.find_point_placement( text_placement,label_x,label_y,0.0,
-                                                         sym.get_vertical_alignment(),
-                                                         sym.get_line_spacing(),
-                                                         sym.get_character_spacing(),
-                                                         sym.get_horizontal_alignment(),
-                                                         sym.get_justify_alignment() );
+                            {
+                                trace_scope placement_scope(this->get_tracer(), "label placement", "labels");
+                                finder.find_point_placement( text_placement,label_x,label_y,0.0,
+                                                             sym.get_vertical_alignment(),
+                                                             sym.get_line_spacing(),
+                                                             sym.get_character_spacing(),
+                                                             sym.get_horizontal_alignment(),
+                                                             sym.get_justify_alignment() );
+                            }
 
                             // check to see if image overlaps anything too, there is only ever 1 placement found for points and verticies
                             if( text_placement.placements.size() > 0)
@@ -212,7 +215,10 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
                         placement text_placement(info, sym, placement_options, scale_factor_, w, h, true);
 
                         text_placement.avoid_edges = sym.get_avoid_edges();
-                        finder.find_point_placements<path_type>(text_placement,path);
+                        {
+                            trace_scope placement_scope(this->get_tracer(), "label placement", "labels");
+                            finder.find_point_placements<path_type>(text_placement,path);
+                        }
 
                         position const&  pos = sym.get_displacement();
                         for (unsigned int ii = 0; ii < text_placement.placements.size(); ++ ii)
@@ -117,6 +117,7 @@ void agg_renderer<T>::process(text_symbolizer const& sym,
                         angle = result.to_double();
                     }
 
+                    trace_scope placement_scope(this->get_tracer(), "label placement", "labels");
                     finder.find_point_placement(text_placement,label_x,label_y,
                                                 angle, sym.get_vertical_alignment(),sym.get_line_spacing(),
                                                 sym.get_character_spacing(),sym.get_horizontal_alignment(),
@@ -127,6 +128,7 @@ void agg_renderer<T>::process(text_symbolizer const& sym,
                 else if ( geom.num_points() > 1 && sym.get_label_placement() == LINE_PLACEMENT)
                 {
                     path_type path(t_,geom,prj_trans);
+                    trace_scope placement_scope(this->get_tracer(), "label placement", "labels");
                     finder.find_line_placements<path_type>(text_placement,path);
                 }
 
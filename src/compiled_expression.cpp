@@ -0,0 +1,340 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/compiled_expression.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/expression_evaluator.hpp>
+
+// boost
+#include <boost/variant.hpp>
+
+// stl
+#include <functional>
+
+namespace mapnik {
+
+unsigned attribute_slots::slot(std::string const& name)
+{
+    std::map<std::string,unsigned>::const_iterator itr = slots_.find(name);
+    if (itr != slots_.end())
+    {
+        return itr->second;
+    }
+    unsigned index = slots_.size();
+    slots_.insert(std::make_pair(name, index));
+    return index;
+}
+
+void attribute_slots::resolve(Feature const& feature, std::vector<value_type> & values) const
+{
+    values.resize(slots_.size());
+    std::map<std::string,value> const& props = feature.props();
+    std::map<std::string,unsigned>::const_iterator itr = slots_.begin();
+    std::map<std::string,unsigned>::const_iterator end = slots_.end();
+    for (; itr != end; ++itr)
+    {
+        std::map<std::string,value>::const_iterator prop = props.find(itr->first);
+        values[itr->second] = prop != props.end() ? prop->second : value_type();
+    }
+}
+
+namespace {
+
+template <typename Tag> struct opcode_of;
+template <> struct opcode_of<tags::plus> { static const compiled_expression::opcode value = compiled_expression::plus; };
+template <> struct opcode_of<tags::minus> { static const compiled_expression::opcode value = compiled_expression::minus; };
+template <> struct opcode_of<tags::mult> { static const compiled_expression::opcode value = compiled_expression::mult; };
+template <> struct opcode_of<tags::div> { static const compiled_expression::opcode value = compiled_expression::div; };
+template <> struct opcode_of<tags::mod> { static const compiled_expression::opcode value = compiled_expression::mod; };
+template <> struct opcode_of<tags::less> { static const compiled_expression::opcode value = compiled_expression::less; };
+template <> struct opcode_of<tags::less_equal> { static const compiled_expression::opcode value = compiled_expression::less_equal; };
+template <> struct opcode_of<tags::greater> { static const compiled_expression::opcode value = compiled_expression::greater; };
+template <> struct opcode_of<tags::greater_equal> { static const compiled_expression::opcode value = compiled_expression::greater_equal; };
+template <> struct opcode_of<tags::equal_to> { static const compiled_expression::opcode value = compiled_expression::equal_to; };
+template <> struct opcode_of<tags::not_equal_to> { static const compiled_expression::opcode value = compiled_expression::not_equal_to; };
+template <> struct opcode_of<tags::logical_not> { static const compiled_expression::opcode value = compiled_expression::logical_not; };
+
+// whether an expression reads no attribute.
+struct is_constant : boost::static_visitor<bool>
+{
+    bool operator() (value_type const&) const
+    {
+        return true;
+    }
+
+    bool operator() (attribute const&) const
+    {
+        return false;
+    }
+
+    template <typename Tag>
+    bool operator() (binary_node<Tag> const& x) const
+    {
+        return boost::apply_visitor(is_constant(),x.left) && boost::apply_visitor(is_constant(),x.right);
+    }
+
+    template <typename Tag>
+    bool operator() (unary_node<Tag> const& x) const
+    {
+        return boost::apply_visitor(is_constant(),x.expr);
+    }
+
+    bool operator() (regex_match_node const& x) const
+    {
+        return boost::apply_visitor(is_constant(),x.expr);
+    }
+
+    bool operator() (regex_replace_node const& x) const
+    {
+        return boost::apply_visitor(is_constant(),x.expr);
+    }
+};
+
+value_type evaluate_constant(expr_node const& node)
+{
+    Feature feature(0);
+    return boost::apply_visitor(evaluate<Feature,value_type>(feature),node);
+}
+
+template <typename Op>
+inline void apply_binary(std::vector<value_type> & stack)
+{
+    value_type right = stack.back();
+    stack.pop_back();
+    stack.back() = value_type(Op()(stack.back(),right));
+}
+
+}
+
+struct expression_compiler : boost::static_visitor<void>
+{
+    typedef compiled_expression::instruction instruction;
+
+    expression_compiler(compiled_expression & expr, attribute_slots & slots)
+        : expr_(expr),
+          slots_(slots) {}
+
+    void compile(expr_node const& node) const
+    {
+        if (boost::apply_visitor(is_constant(),node))
+        {
+            (*this)(evaluate_constant(node));
+        }
+        else
+        {
+            boost::apply_visitor(*this,node);
+        }
+    }
+
+    void operator() (value_type const& x) const
+    {
+        emit(compiled_expression::push_constant,expr_.constants_.size());
+        expr_.constants_.push_back(x);
+    }
+
+    void operator() (attribute const& attr) const
+    {
+        emit(compiled_expression::push_attribute,slots_.slot(attr.name()));
+    }
+
+    void operator() (binary_node<tags::logical_and> const& x) const
+    {
+        compile_logical(x.left,x.right,compiled_expression::and_jump,false);
+    }
+
+    void operator() (binary_node<tags::logical_or> const& x) const
+    {
+        compile_logical(x.left,x.right,compiled_expression::or_jump,true);
+    }
+
+    template <typename Tag>
+    void operator() (binary_node<Tag> const& x) const
+    {
+        compile(x.left);
+        compile(x.right);
+        emit(opcode_of<Tag>::value);
+    }
+
+    template <typename Tag>
+    void operator() (unary_node<Tag> const& x) const
+    {
+        compile(x.expr);
+        emit(opcode_of<Tag>::value);
+    }
+
+    void operator() (regex_match_node const& x) const
+    {
+        compile(x.expr);
+        emit(compiled_expression::regex_match,expr_.matches_.size());
+        expr_.matches_.push_back(x);
+    }
+
+    void operator() (regex_replace_node const& x) const
+    {
+        compile(x.expr);
+        emit(compiled_expression::regex_replace,expr_.replaces_.size());
+        expr_.replaces_.push_back(x);
+    }
+
+private:
+    // 'and' and 'or', whose result is 'shortcut' when their left
+    // operand is, and the boolean value of their right operand otherwise.
+    void compile_logical(expr_node const& left, expr_node const& right,
+                         compiled_expression::opcode jump, bool shortcut) const
+    {
+        if (boost::apply_visitor(is_constant(),left))
+        {
+            if (evaluate_constant(left).to_bool() == shortcut)
+            {
+                (*this)(value_type(shortcut));
+                return;
+            }
+            compile(right);
+            emit(compiled_expression::to_bool);
+            return;
+        }
+        compile(left);
+        std::size_t jump_index = expr_.code_.size();
+        emit(jump);
+        compile(right);
+        emit(compiled_expression::to_bool);
+        expr_.code_[jump_index].arg = expr_.code_.size();
+    }
+
+    void emit(compiled_expression::opcode op, unsigned arg = 0) const
+    {
+        expr_.code_.push_back(instruction(op,arg));
+    }
+
+    compiled_expression & expr_;
+    attribute_slots & slots_;
+};
+
+compiled_expression::compiled_expression(expr_node const& node, attribute_slots & slots)
+{
+    expression_compiler(*this,slots).compile(node);
+}
+
+value_type compiled_expression::evaluate(std::vector<value_type> const& values) const
+{
+    stack_.clear();
+    std::size_t pc = 0;
+    while (pc < code_.size())
+    {
+        instruction const& ins = code_[pc++];
+        switch (ins.op)
+        {
+        case push_constant:
+            stack_.push_back(constants_[ins.arg]);
+            break;
+        case push_attribute:
+            stack_.push_back(values[ins.arg]);
+            break;
+        case plus:
+            apply_binary<std::plus<value_type> >(stack_);
+            break;
+        case minus:
+            apply_binary<std::minus<value_type> >(stack_);
+            break;
+        case mult:
+            apply_binary<std::multiplies<value_type> >(stack_);
+            break;
+        case div:
+            apply_binary<std::divides<value_type> >(stack_);
+            break;
+        case mod:
+            apply_binary<std::modulus<value_type> >(stack_);
+            break;
+        case less:
+            apply_binary<std::less<value_type> >(stack_);
+            break;
+        case less_equal:
+            apply_binary<std::less_equal<value_type> >(stack_);
+            break;
+        case greater:
+            apply_binary<std::greater<value_type> >(stack_);
+            break;
+        case greater_equal:
+            apply_binary<std::greater_equal<value_type> >(stack_);
+            break;
+        case equal_to:
+            apply_binary<std::equal_to<value_type> >(stack_);
+            break;
+        case not_equal_to:
+            apply_binary<std::not_equal_to<value_type> >(stack_);
+            break;
+        case logical_not:
+            stack_.back() = value_type(!stack_.back().to_bool());
+            break;
+        case to_bool:
+            stack_.back() = value_type(stack_.back().to_bool());
+            break;
+        case and_jump:
+            if (!stack_.back().to_bool())
+            {
+                stack_.back() = value_type(false);
+                pc = ins.arg;
+            }
+            else
+            {
+                stack_.pop_back();
+            }
+            break;
+        case or_jump:
+            if (stack_.back().to_bool())
+            {
+                stack_.back() = value_type(true);
+                pc = ins.arg;
+            }
+            else
+            {
+                stack_.pop_back();
+            }
+            break;
+        case regex_match:
+#if defined(BOOST_REGEX_HAS_ICU)
+            stack_.back() = value_type(boost::u32regex_match(stack_.back().to_unicode(),matches_[ins.arg].pattern));
+#else
+            stack_.back() = value_type(boost::regex_match(stack_.back().to_string(),matches_[ins.arg].pattern));
+#endif
+            break;
+        case regex_replace:
+        {
+            regex_replace_node const& node = replaces_[ins.arg];
+#if defined(BOOST_REGEX_HAS_ICU)
+            stack_.back() = value_type(boost::u32regex_replace(stack_.back().to_unicode(),node.pattern,node.format));
+#else
+            std::string repl = boost::regex_replace(stack_.back().to_string(),node.pattern,node.format);
+            mapnik::transcoder tr_("utf8");
+            stack_.back() = value_type(tr_.transcode(repl.c_str()));
+#endif
+            break;
+        }
+        }
+    }
+    return stack_.back();
+}
+
+}
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/feature_cache.hpp>
+
+// stl
+#include <limits>
+
+namespace mapnik {
+
+feature_cache::reader::reader()
+    : cache_(0),
+      pos_(0),
+      all_(true) {}
+
+feature_cache::reader::reader(feature_cache const& cache, box2d<double> const& bbox)
+    : cache_(&cache),
+      bbox_(bbox),
+      pos_(0),
+      all_(!cache.has_extent_ || bbox.contains(cache.extent_)) {}
+
+feature_ptr feature_cache::reader::next()
+{
+    if (!cache_)
+    {
+        return feature_ptr();
+    }
+    std::size_t size = cache_->features_.size();
+    if (all_)
+    {
+        if (pos_ < size)
+        {
+            return cache_->features_[pos_++];
+        }
+        return feature_ptr();
+    }
+    while (pos_ < size)
+    {
+        std::size_t index = pos_++;
+        if (bbox_.intersects(cache_->boxes_[index]))
+        {
+            return cache_->features_[index];
+        }
+    }
+    return feature_ptr();
+}
+
+feature_cache::feature_cache()
+    : has_extent_(false) {}
+
+void feature_cache::push(feature_ptr const& feature)
+{
+    unsigned num_geometries = feature->num_geometries();
+    box2d<double> box;
+    for (unsigned i = 0; i < num_geometries; ++i)
+    {
+        box2d<double> envelope = feature->get_geometry(i).envelope();
+        if (i == 0)
+        {
+            box = envelope;
+        }
+        else
+        {
+            box.expand_to_include(envelope);
+        }
+    }
+    if (num_geometries > 0)
+    {
+        if (has_extent_)
+        {
+            extent_.expand_to_include(box);
+        }
+        else
+        {
+            extent_ = box;
+            has_extent_ = true;
+        }
+    }
+    else
+    {
+        // features without geometries, like rasters, are always read
+        double max = std::numeric_limits<double>::max();
+        box.init(-max, -max, max, max);
+    }
+    boxes_.push_back(box);
+    features_.push_back(feature);
+}
+
+void feature_cache::clear()
+{
+    boxes_.clear();
+    features_.clear();
+    extent_ = box2d<double>();
+    has_extent_ = false;
+}
+
+}
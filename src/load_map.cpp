@@ -180,7 +180,8 @@ void map_parser::parse_map( Map & map, ptree const & pt )
           << "buffer-size,"
           << "paths-from-xml,"
           << "minimum-version,"
-          << "font-directory";
+          << "font-directory,"
+          << "simplify-tolerance";
         ensure_attrs(map_node, "Map", s.str());
         
         try
@@ -222,6 +223,12 @@ void map_parser::parse_map( Map & map, ptree const & pt )
                 freetype_engine::register_fonts( ensure_relative_to_xml(font_directory), false);
             }
 
+            optional<double> simplify_tolerance = get_opt_attr<double>(map_node, "simplify-tolerance");
+            if (simplify_tolerance)
+            {
+                extra_attr["simplify-tolerance"] = *simplify_tolerance;
+            }
+
             optional<std::string> min_version_string = get_opt_attr<std::string>(map_node, "minimum-version");
                 
             if (min_version_string)
@@ -1715,7 +1722,8 @@ void map_parser::parse_line_symbolizer( rule & rule, ptree const & sym )
     std::stringstream s;
     s << "meta-writer,meta-output,"
       << "stroke,stroke-width,stroke-opacity,stroke-linejoin,"
-      << "stroke-linecap,stroke-gamma,stroke-dashoffet,stroke-dasharray";
+      << "stroke-linecap,stroke-gamma,stroke-dashoffet,stroke-dasharray,"
+      << "simplify-tolerance";
     ensure_attrs(sym, "LineSymbolizer", s.str());
     try
     {
@@ -1723,6 +1731,10 @@ void map_parser::parse_line_symbolizer( rule & rule, ptree const & sym )
         parse_stroke(strk,sym);
         line_symbolizer symbol = line_symbolizer(strk);
 
+        // simplify-tolerance
+        optional<double> simplify_tolerance = get_opt_attr<double>(sym, "simplify-tolerance");
+        if (simplify_tolerance) symbol.set_simplify_tolerance(*simplify_tolerance);
+
         parse_metawriter_in_symbolizer(symbol, sym);
         rule.append(symbol);
     }
@@ -1736,7 +1748,7 @@ void map_parser::parse_line_symbolizer( rule & rule, ptree const & sym )
     
 void map_parser::parse_polygon_symbolizer( rule & rule, ptree const & sym )
 {
-    ensure_attrs(sym, "PolygonSymbolizer", "fill,fill-opacity,gamma,meta-writer,meta-output");
+    ensure_attrs(sym, "PolygonSymbolizer", "fill,fill-opacity,gamma,simplify-tolerance,meta-writer,meta-output");
     try
     {
         polygon_symbolizer poly_sym;
@@ -1749,6 +1761,9 @@ void map_parser::parse_polygon_symbolizer( rule & rule, ptree const & sym )
         // gamma
         optional<double> gamma = get_opt_attr<double>(sym, "gamma");
         if (gamma)  poly_sym.set_gamma(*gamma);
+        // simplify-tolerance
+        optional<double> simplify_tolerance = get_opt_attr<double>(sym, "simplify-tolerance");
+        if (simplify_tolerance) poly_sym.set_simplify_tolerance(*simplify_tolerance);
 
         parse_metawriter_in_symbolizer(poly_sym, sym);
         rule.append(poly_sym);
@@ -0,0 +1,82 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/metatile.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image_util.hpp>
+
+// boost
+#include <boost/lexical_cast.hpp>
+
+// stl
+#include <algorithm>
+#include <stdexcept>
+
+namespace mapnik {
+
+metatile::metatile(Map const& m, unsigned columns, unsigned rows)
+    : map_(m),
+      columns_(std::max(columns, 1u)),
+      rows_(std::max(rows, 1u)),
+      margin_(std::max(m.buffer_size(), 0)),
+      image_(m.width() + 2 * margin_, m.height() + 2 * margin_) {}
+
+void metatile::render(double scale_factor, tracer * t)
+{
+    image_.set_background(color(0, 0, 0, 0));
+    agg_renderer<image_32> ren(map_, image_, scale_factor, -int(margin_), -int(margin_));
+    ren.set_tracer(t);
+    ren.apply();
+}
+
+metatile::tile_type metatile::tile(unsigned column, unsigned row) const
+{
+    if (column >= columns_ || row >= rows_)
+    {
+        throw std::out_of_range("metatile: no tile at column " + boost::lexical_cast<std::string>(column) +
+                                ", row " + boost::lexical_cast<std::string>(row));
+    }
+    unsigned width = map_.width() / columns_;
+    unsigned height = map_.height() / rows_;
+    unsigned x = column * width;
+    unsigned y = row * height;
+    if (column + 1 == columns_)
+    {
+        width = map_.width() - x;
+    }
+    if (row + 1 == rows_)
+    {
+        height = map_.height() - y;
+    }
+    return tile_type(margin_ + x, margin_ + y, width, height, image_.data());
+}
+
+std::string metatile::encode(unsigned column, unsigned row, std::string const& type,
+                             tracer * t) const
+{
+    return save_to_string(tile(column, row), type, t);
+}
+
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifdef MAPNIK_THREADSAFE
+
+#include <mapnik/prefetched_featureset.hpp>
+
+// boost
+#include <boost/bind.hpp>
+
+namespace mapnik {
+
+prefetched_featureset::prefetched_featureset(datasource_ptr const& ds, query const& q,
+                                             std::size_t max_features, std::size_t max_bytes)
+    : ds_(ds),
+      query_(q),
+      max_features_(max_features),
+      max_bytes_(max_bytes),
+      bytes_(0),
+      done_(false),
+      cancelled_(false)
+{
+    // the thread starts last: it uses all the other members.
+    thread_ = boost::thread(boost::bind(&prefetched_featureset::read_features, this));
+}
+
+prefetched_featureset::~prefetched_featureset()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        cancelled_ = true;
+    }
+    not_full_.notify_one();
+    thread_.join();
+}
+
+feature_ptr prefetched_featureset::next()
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    while (features_.empty() && !done_)
+    {
+        not_empty_.wait(lock);
+    }
+    if (features_.empty())
+    {
+        if (!error_.empty())
+        {
+            throw datasource_exception(error_);
+        }
+        return feature_ptr();
+    }
+
+    feature_ptr feature = features_.front().first;
+    bytes_ -= features_.front().second;
+    features_.pop_front();
+    not_full_.notify_one();
+    return feature;
+}
+
+std::size_t prefetched_featureset::feature_size(Feature const& feature)
+{
+    // vertices are stored as two coordinates and a command.
+    std::size_t size = sizeof(Feature);
+    for (unsigned i = 0; i < feature.num_geometries(); ++i)
+    {
+        size += sizeof(geometry_type) + feature.get_geometry(i).num_points() * (2 * sizeof(double) + 1);
+    }
+    std::map<std::string,value>::const_iterator itr = feature.props().begin();
+    std::map<std::string,value>::const_iterator end = feature.props().end();
+    for (; itr != end; ++itr)
+    {
+        size += sizeof(*itr) + itr->first.size();
+    }
+    return size;
+}
+
+void prefetched_featureset::read_features()
+{
+    std::string error;
+    try
+    {
+        featureset_ptr fs = ds_->features(query_);
+        feature_ptr feature;
+        while (fs && (feature = fs->next()))
+        {
+            std::size_t size = feature_size(*feature);
+            boost::mutex::scoped_lock lock(mutex_);
+            // a single feature is buffered whatever its size.
+            while (!cancelled_ && !features_.empty() &&
+                   (features_.size() >= max_features_ || bytes_ + size > max_bytes_))
+            {
+                not_full_.wait(lock);
+            }
+            if (cancelled_)
+            {
+                break;
+            }
+            features_.push_back(std::make_pair(feature, size));
+            bytes_ += size;
+            not_empty_.notify_one();
+        }
+    }
+    catch (std::exception const& ex)
+    {
+        error = ex.what();
+    }
+    catch (...)
+    {
+        error = "unknown error while reading features";
+    }
+
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        error_ = error;
+        done_ = true;
+    }
+    not_empty_.notify_one();
+}
+}
+
+#endif // MAPNIK_THREADSAFE
@@ -0,0 +1,161 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/render_stats.hpp>
+#include "stats_util.hpp"
+
+// boost
+#include <boost/variant.hpp>
+
+// stl
+#include <iomanip>
+#include <sstream>
+
+namespace mapnik {
+
+namespace {
+
+struct symbolizer_type_name : boost::static_visitor<char const*>
+{
+    char const* operator() (point_symbolizer const&) const { return "point"; }
+    char const* operator() (line_symbolizer const&) const { return "line"; }
+    char const* operator() (line_pattern_symbolizer const&) const { return "line_pattern"; }
+    char const* operator() (polygon_symbolizer const&) const { return "polygon"; }
+    char const* operator() (polygon_pattern_symbolizer const&) const { return "polygon_pattern"; }
+    char const* operator() (raster_symbolizer const&) const { return "raster"; }
+    char const* operator() (shield_symbolizer const&) const { return "shield"; }
+    char const* operator() (text_symbolizer const&) const { return "text"; }
+    char const* operator() (building_symbolizer const&) const { return "building"; }
+    char const* operator() (markers_symbolizer const&) const { return "markers"; }
+    char const* operator() (glyph_symbolizer const&) const { return "glyph"; }
+};
+}
+
+double stats_clock()
+{
+    return wall_clock_us() / 1000.0;
+}
+
+void render_stats::clear()
+{
+    time = 0.0;
+    layers.clear();
+    symbolizers.clear();
+}
+
+symbolizer_stats & render_stats::symbolizer_type(symbolizer const& sym)
+{
+    unsigned index = sym.which();
+    if (index >= symbolizers.size())
+    {
+        symbolizers.resize(index + 1);
+    }
+    symbolizer_stats & stats = symbolizers[index];
+    if (stats.type.empty())
+    {
+        stats.type = boost::apply_visitor(symbolizer_type_name(), sym);
+    }
+    return stats;
+}
+
+void render_stats::add_symbolizer_call(symbolizer const& sym, Feature const& feature, double call_time)
+{
+    symbolizer_stats & stats = symbolizer_type(sym);
+    ++stats.calls;
+    stats.time += call_time;
+    for (unsigned i = 0; i < feature.num_geometries(); ++i)
+    {
+        stats.vertices += feature.get_geometry(i).num_points();
+    }
+}
+
+void render_stats::merge(render_stats const& other)
+{
+    layers.insert(layers.end(), other.layers.begin(), other.layers.end());
+    if (other.symbolizers.size() > symbolizers.size())
+    {
+        symbolizers.resize(other.symbolizers.size());
+    }
+    for (std::size_t i = 0; i < other.symbolizers.size(); ++i)
+    {
+        symbolizer_stats const& from = other.symbolizers[i];
+        symbolizer_stats & to = symbolizers[i];
+        if (to.type.empty())
+        {
+            to.type = from.type;
+        }
+        to.calls += from.calls;
+        to.time += from.time;
+        to.vertices += from.vertices;
+    }
+}
+
+std::string render_stats::to_json() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"time\":" << time << ",\"layers\":[";
+    for (std::size_t i = 0; i < layers.size(); ++i)
+    {
+        layer_stats const& layer = layers[i];
+        out << (i ? "," : "") << "{\"name\":";
+        write_json_string(out, layer.name);
+        out << ",\"time\":" << layer.time
+            << ",\"query_time\":" << layer.query_time
+            << ",\"features_fetched\":" << layer.features_fetched
+            << ",\"features_matched\":" << layer.features_matched
+            << ",\"rules\":[";
+        for (std::size_t j = 0; j < layer.rules.size(); ++j)
+        {
+            rule_stats const& r = layer.rules[j];
+            out << (j ? "," : "") << "{\"style\":";
+            write_json_string(out, r.style);
+            out << ",\"name\":";
+            write_json_string(out, r.name);
+            out << ",\"features\":" << r.features
+                << ",\"time\":" << r.time << "}";
+        }
+        out << "]}";
+    }
+    out << "],\"symbolizers\":{";
+    bool first = true;
+    for (std::size_t i = 0; i < symbolizers.size(); ++i)
+    {
+        symbolizer_stats const& sym = symbolizers[i];
+        if (sym.calls == 0)
+        {
+            continue;
+        }
+        out << (first ? "" : ",");
+        first = false;
+        write_json_string(out, sym.type);
+        out << ":{\"calls\":" << sym.calls
+            << ",\"time\":" << sym.time
+            << ",\"vertices\":" << sym.vertices << "}";
+    }
+    out << "}}";
+    return out.str();
+}
+}
@@ -0,0 +1,243 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/rule_index.hpp>
+
+// boost
+#include <boost/variant.hpp>
+
+// stl
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace mapnik {
+
+namespace {
+
+struct hash_key_visitor : boost::static_visitor<bool>
+{
+    explicit hash_key_visitor(std::string & key)
+        : key_(key) {}
+
+    bool operator() (value_null const&) const
+    {
+        return false;
+    }
+
+    bool operator() (bool val) const
+    {
+        key_.assign(1, 'b');
+        key_ += val ? '1' : '0';
+        return true;
+    }
+
+    // ints and doubles that are equal have the same key.
+    bool operator() (int val) const
+    {
+        return number(val);
+    }
+
+    bool operator() (double val) const
+    {
+        return number(val);
+    }
+
+    bool operator() (UnicodeString const& val) const
+    {
+        key_.assign(1, 's');
+        key_.append(reinterpret_cast<char const*>(val.getBuffer()), val.length() * sizeof(UChar));
+        return true;
+    }
+
+private:
+    bool number(double val) const
+    {
+        if (val != val)
+        {
+            return false;
+        }
+        val += 0.0; // -0 is 0
+        key_.assign(1, 'n');
+        key_.append(reinterpret_cast<char const*>(&val), sizeof(val));
+        return true;
+    }
+
+    std::string & key_;
+};
+
+// the operands of the 'and's of an expression.
+void split_conjunction(expr_node const& node, std::vector<expr_node const*> & conjuncts)
+{
+    binary_node<tags::logical_and> const* x = boost::get<binary_node<tags::logical_and> >(&node);
+    if (x)
+    {
+        split_conjunction(x->left, conjuncts);
+        split_conjunction(x->right, conjuncts);
+    }
+    else
+    {
+        conjuncts.push_back(&node);
+    }
+}
+
+// the attribute an expression tests the equality of with a constant, and the key of the constant.
+attribute const* keyed_equality(expr_node const& node, std::string & key)
+{
+    binary_node<tags::equal_to> const* x = boost::get<binary_node<tags::equal_to> >(&node);
+    if (!x)
+    {
+        return 0;
+    }
+    attribute const* attr = boost::get<attribute>(&x->left);
+    value_type const* val = boost::get<value_type>(&x->right);
+    if (!attr || !val)
+    {
+        attr = boost::get<attribute>(&x->right);
+        val = boost::get<value_type>(&x->left);
+    }
+    if (!attr || !val || !rule_index::hash_key(*val, key))
+    {
+        return 0;
+    }
+    return attr;
+}
+}
+
+rule_index::rule_index(std::vector<expression_ptr> const& filters)
+    : key_slot_(0),
+      candidates_(&unkeyed_)
+{
+    std::vector<std::vector<expr_node const*> > conjunctions(filters.size());
+    std::string key;
+
+    // index by the attribute most filters test the equality of.
+    std::map<std::string,unsigned> keyed_filters;
+    for (unsigned i = 0; i < filters.size(); ++i)
+    {
+        split_conjunction(*filters[i], conjunctions[i]);
+        std::vector<std::string> names;
+        for (unsigned j = 0; j < conjunctions[i].size(); ++j)
+        {
+            attribute const* attr = keyed_equality(*conjunctions[i][j], key);
+            if (attr && std::find(names.begin(), names.end(), attr->name()) == names.end())
+            {
+                names.push_back(attr->name());
+                ++keyed_filters[attr->name()];
+            }
+        }
+    }
+    unsigned most = 1;
+    std::map<std::string,unsigned>::const_iterator itr = keyed_filters.begin();
+    for (; itr != keyed_filters.end(); ++itr)
+    {
+        if (itr->second > most)
+        {
+            key_ = itr->first;
+            most = itr->second;
+        }
+    }
+
+    residuals_.reserve(filters.size());
+    for (unsigned i = 0; i < filters.size(); ++i)
+    {
+        std::vector<expr_node const*> const& conjuncts = conjunctions[i];
+        std::vector<expr_node const*>::const_iterator keyed = conjuncts.end();
+        if (!key_.empty())
+        {
+            for (keyed = conjuncts.begin(); keyed != conjuncts.end(); ++keyed)
+            {
+                attribute const* attr = keyed_equality(**keyed, key);
+                if (attr && attr->name() == key_)
+                {
+                    break;
+                }
+            }
+        }
+        if (keyed == conjuncts.end())
+        {
+            unkeyed_.push_back(i);
+            residuals_.push_back(compiled_expression(*filters[i], slots_));
+            continue;
+        }
+
+        // the filter without its equality, which holds for its candidates.
+        index_[key].push_back(i);
+        expr_node residual = value_type(true);
+        bool first = true;
+        for (std::vector<expr_node const*>::const_iterator conjunct = conjuncts.begin();
+             conjunct != conjuncts.end(); ++conjunct)
+        {
+            if (conjunct == keyed)
+            {
+                continue;
+            }
+            if (first)
+            {
+                residual = **conjunct;
+                first = false;
+            }
+            else
+            {
+                residual = binary_node<tags::logical_and>(residual, **conjunct);
+            }
+        }
+        residuals_.push_back(compiled_expression(residual, slots_));
+    }
+
+    // filters that are not keyed are candidates of every feature.
+    if (!key_.empty())
+    {
+        key_slot_ = slots_.slot(key_);
+        for (index_type::iterator entry = index_.begin(); entry != index_.end(); ++entry)
+        {
+            std::vector<unsigned> candidates;
+            candidates.reserve(entry->second.size() + unkeyed_.size());
+            std::merge(entry->second.begin(), entry->second.end(),
+                       unkeyed_.begin(), unkeyed_.end(), std::back_inserter(candidates));
+            entry->second.swap(candidates);
+        }
+    }
+}
+
+void rule_index::resolve(Feature const& feature)
+{
+    slots_.resolve(feature, values_);
+    candidates_ = &unkeyed_;
+    if (!key_.empty() && hash_key(values_[key_slot_], hash_))
+    {
+        index_type::const_iterator itr = index_.find(hash_);
+        if (itr != index_.end())
+        {
+            candidates_ = &itr->second;
+        }
+    }
+}
+
+bool rule_index::hash_key(value_type const& value, std::string & key)
+{
+    return boost::apply_visitor(hash_key_visitor(key), value.base());
+}
+}
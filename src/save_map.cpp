@@ -81,6 +81,7 @@ public:
 
         const stroke & strk =  sym.get_stroke();
         add_stroke_attributes(sym_node, strk);
+        add_simplify_attributes(sym_node, sym);
         add_metawriter_attributes(sym_node, sym);
     }
         
@@ -112,6 +113,7 @@ public:
         {
             set_attr( sym_node, "gamma", sym.get_gamma() );
         }
+        add_simplify_attributes(sym_node, sym);
         add_metawriter_attributes(sym_node, sym);
     }
 
@@ -583,6 +585,13 @@ private:
         }
                 
     }
+    void add_simplify_attributes(ptree &node, symbolizer_base const& sym)
+    {
+        if (sym.simplify_tolerance() != 0.0 || explicit_defaults_) {
+            set_attr(node, "simplify-tolerance", sym.simplify_tolerance());
+        }
+    }
+
     void add_metawriter_attributes(ptree &node, symbolizer_base const& sym)
     {
         if (!sym.get_metawriter_name().empty() || explicit_defaults_) {
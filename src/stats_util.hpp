@@ -0,0 +1,77 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_STATS_UTIL_HPP
+#define MAPNIK_STATS_UTIL_HPP
+
+// Helpers shared by render_stats.cpp and tracer.cpp; not installed.
+
+// stl
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <sys/time.h>
+
+namespace mapnik {
+
+// wall clock time, in microseconds.
+inline double wall_clock_us()
+{
+    timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec * 1000000.0 + now.tv_usec;
+}
+
+// write 'str' as a JSON string, quoted and escaped.
+inline void write_json_string(std::ostream & out, std::string const& str)
+{
+    out << '"';
+    for (std::string::const_iterator itr = str.begin(); itr != str.end(); ++itr)
+    {
+        unsigned char c = *itr;
+        switch (c)
+        {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (c < 0x20)
+            {
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << unsigned(c)
+                    << std::dec << std::setfill(' ');
+            }
+            else
+            {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+
+}
+
+#endif // MAPNIK_STATS_UTIL_HPP
@@ -26,8 +26,8 @@
 
 namespace mapnik
 {
-    template <typename T>
-    void svg_renderer<T>::process(building_symbolizer const& sym,
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(building_symbolizer const& sym,
 				  Feature const& feature,
 				  proj_transform const& prj_trans)
     {
@@ -37,4 +37,12 @@ namespace mapnik
     template void svg_renderer<std::ostream_iterator<char> >::process(building_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(building_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(building_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
@@ -23,18 +23,47 @@
 
 // mapnik
 #include <mapnik/svg_renderer.hpp>
+#include <mapnik/marker_cache.hpp>
 
 namespace mapnik
 {
-    template <typename T>
-    void svg_renderer<T>::process(line_pattern_symbolizer const& sym,
+    /*!
+     * @brief Collect presentation attributes found in line pattern symbolizer,
+     * writing its pattern the first time it is used.
+     */
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(line_pattern_symbolizer const& sym,
 			       Feature const& feature,
 			       proj_transform const& prj_trans)
     {
-	// nothing yet.
+	std::string filename = path_processor_type::evaluate(*sym.get_filename(), feature);
+	if(filename.empty())
+	{
+	    return;
+	}
+
+	boost::optional<marker_ptr> marker = marker_cache::instance()->find(filename, true);
+	if(!marker)
+	{
+	    return;
+	}
+
+	// SVG patterns cannot follow the direction of the line: the line is
+	// stroked as wide as the pattern, which is aligned on the image instead.
+	path_attributes_.set_stroke_pattern(find_pattern(filename, **marker));
+	path_attributes_.set_stroke_opacity(sym.get_opacity());
+	path_attributes_.set_stroke_width((*marker)->height());
     }
 
     template void svg_renderer<std::ostream_iterator<char> >::process(line_pattern_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(line_pattern_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(line_pattern_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
@@ -23,18 +23,167 @@
 
 // mapnik
 #include <mapnik/svg_renderer.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/markers_placement.hpp>
+#include <mapnik/arrow.hpp>
+
+// agg
+#include "agg_trans_affine.h"
+
+// boost
+#include <boost/lexical_cast.hpp>
+
+// stl
+#include <string>
 
 namespace mapnik
 {
-    template <typename T>
-    void svg_renderer<T>::process(markers_symbolizer const& sym,
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(markers_symbolizer const& sym,
 				  Feature const& feature,
 				  proj_transform const& prj_trans)
     {
-	// nothing yet.
+	typedef coord_transform2<CoordTransform, geometry_type> path_type;
+
+	agg::trans_affine tr;
+	boost::array<double,6> const& m = sym.get_transform();
+	tr.load_from(&m[0]);
+
+	std::string filename = path_processor_type::evaluate(*sym.get_filename(), feature);
+	boost::optional<marker_ptr> mark;
+	svg::path_output_attributes marker_attributes;
+	std::string style;
+	box2d<double> extent;
+
+	if(!filename.empty())
+	{
+	    mark = marker_cache::instance()->find(filename, true);
+	    if(!mark || !*mark || !(*mark)->is_vector())
+	    {
+		return;
+	    }
+	    box2d<double> const& bbox = (*(*mark)->get_vector_data())->bounding_box();
+	    extent.init(-0.5 * bbox.width(), -0.5 * bbox.height(), 0.5 * bbox.width(), 0.5 * bbox.height());
+	}
+	else
+	{
+	    color const& fill = sym.get_fill();
+	    marker_attributes.set_fill_color(fill);
+	    marker_attributes.set_fill_opacity(fill.alpha() / 255.0);
+	    if(sym.get_stroke().get_width() > 0.0)
+	    {
+		marker_attributes.set_stroke(sym.get_stroke());
+	    }
+	    // built-in markers are identified by their style, so that
+	    // symbolizers that draw the same marker share its symbol.
+	    style = generator_.generate_path_style(marker_attributes);
+
+	    if(sym.get_marker_type() == ARROW)
+	    {
+		extent = arrow().extent();
+	    }
+	    else
+	    {
+		double dx = sym.get_width() + 2 * sym.get_stroke().get_width();
+		double dy = sym.get_height() + 2 * sym.get_stroke().get_width();
+		extent.init(-dx, -dy, dx, dy);
+	    }
+	}
+
+	double x1 = extent.minx();
+	double y1 = extent.miny();
+	double x2 = extent.maxx();
+	double y2 = extent.maxy();
+	tr.transform(&x1, &y1);
+	tr.transform(&x2, &y2);
+	extent.init(x1, y1, x2, y2);
+
+	for(unsigned i = 0; i < feature.num_geometries(); ++i)
+	{
+	    geometry_type const& geom = feature.get_geometry(i);
+
+	    // built-in markers are always ellipses when placed on points.
+	    bool point_placement = sym.get_marker_placement() == MARKER_POINT_PLACEMENT || geom.num_points() <= 1;
+	    std::string marker_key = filename;
+	    bool arrow_marker = false;
+	    if(filename.empty())
+	    {
+		arrow_marker = !point_placement && sym.get_marker_type() == ARROW;
+		marker_key = arrow_marker
+		    ? "<arrow>" + style
+		    : "<ellipse " + boost::lexical_cast<std::string>(sym.get_width())
+		    + " " + boost::lexical_cast<std::string>(sym.get_height()) + ">" + style;
+	    }
+
+	    std::string symbol_id;
+	    if(point_placement)
+	    {
+		double x;
+		double y;
+		double z = 0;
+		geom.label_position(&x, &y);
+		prj_trans.backward(x, y, z);
+		t_.forward(&x, &y);
+
+		box2d<double> label_ext(x + extent.minx(), y + extent.miny(), x + extent.maxx(), y + extent.maxy());
+		if(sym.get_allow_overlap() || detector_.has_placement(label_ext))
+		{
+		    if(!find_symbol(marker_key, symbol_id))
+		    {
+			generator_.generate_opening_symbol(symbol_id);
+			if(mark)
+			    generator_.generate_marker(**mark, filename);
+			else
+			    generator_.generate_ellipse_marker(sym.get_width(), sym.get_height(), marker_attributes);
+			generator_.generate_closing_symbol();
+		    }
+		    // as in the agg renderer, the symbolizer's transformation
+		    // applies to vector markers and arrows, not to ellipses.
+		    agg::trans_affine matrix = mark ? tr : agg::trans_affine();
+		    matrix *= agg::trans_affine_translation(x, y);
+		    generator_.generate_use(symbol_id, matrix, sym.get_opacity());
+		    detector_.insert(label_ext);
+		}
+	    }
+	    else
+	    {
+		path_type path(t_, geom, prj_trans);
+		markers_placement<path_type, label_collision_detector4> placement(path, extent, detector_,
+										 sym.get_spacing(),
+										 sym.get_max_error(),
+										 sym.get_allow_overlap());
+		double x, y, angle;
+		while(placement.get_point(&x, &y, &angle))
+		{
+		    if(symbol_id.empty() && !find_symbol(marker_key, symbol_id))
+		    {
+			generator_.generate_opening_symbol(symbol_id);
+			if(mark)
+			    generator_.generate_marker(**mark, filename);
+			else if(arrow_marker)
+			    generator_.generate_arrow_marker(marker_attributes);
+			else
+			    generator_.generate_ellipse_marker(sym.get_width(), sym.get_height(), marker_attributes);
+			generator_.generate_closing_symbol();
+		    }
+		    agg::trans_affine matrix = mark || arrow_marker ? tr : agg::trans_affine();
+		    matrix *= agg::trans_affine_rotation(angle);
+		    matrix *= agg::trans_affine_translation(x, y);
+		    generator_.generate_use(symbol_id, matrix, sym.get_opacity());
+		}
+	    }
+	}
     }
 
     template void svg_renderer<std::ostream_iterator<char> >::process(markers_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(markers_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(markers_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
@@ -23,18 +23,90 @@
 
 // mapnik
 #include <mapnik/svg_renderer.hpp>
+#include <mapnik/marker_cache.hpp>
+
+// agg
+#include "agg_trans_affine.h"
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <string>
 
 namespace mapnik
 {
-    template <typename T>
-    void svg_renderer<T>::process(point_symbolizer const& sym,
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(point_symbolizer const& sym,
 			       Feature const& feature,
 			       proj_transform const& prj_trans)
     {
-	// nothing yet.
+	std::string filename = path_processor_type::evaluate(*sym.get_filename(), feature);
+
+	boost::optional<marker_ptr> marker;
+	if(!filename.empty())
+	{
+	    marker = marker_cache::instance()->find(filename, true);
+	}
+	else
+	{
+	    marker.reset(boost::make_shared<mapnik::marker>());
+	}
+
+	if(!marker)
+	{
+	    return;
+	}
+
+	agg::trans_affine tr;
+	boost::array<double,6> const& m = sym.get_transform();
+	tr.load_from(&m[0]);
+
+	// the marker is written as a symbol the first time it is placed,
+	// each placement is a use tag that refers to the symbol.
+	std::string symbol_id;
+	for(unsigned i = 0; i < feature.num_geometries(); ++i)
+	{
+	    geometry_type const& geom = feature.get_geometry(i);
+	    double x;
+	    double y;
+	    double z = 0;
+	    if(sym.get_point_placement() == CENTROID_POINT_PLACEMENT)
+		geom.label_position(&x, &y);
+	    else
+		geom.label_interior_position(&x, &y);
+
+	    prj_trans.backward(x, y, z);
+	    t_.forward(&x, &y);
+
+	    double w = (*marker)->width();
+	    double h = (*marker)->height();
+	    box2d<double> label_ext(x - 0.5 * w, y - 0.5 * h, x + 0.5 * w, y + 0.5 * h);
+	    if(sym.get_allow_overlap() || detector_.has_placement(label_ext))
+	    {
+		if(symbol_id.empty() && !find_symbol(filename, symbol_id))
+		{
+		    generator_.generate_opening_symbol(symbol_id);
+		    generator_.generate_marker(**marker, filename);
+		    generator_.generate_closing_symbol();
+		}
+		generator_.generate_use(symbol_id, tr * agg::trans_affine_translation(x, y), sym.get_opacity());
+
+		if(!sym.get_ignore_placement())
+		    detector_.insert(label_ext);
+	    }
+	}
     }
 
     template void svg_renderer<std::ostream_iterator<char> >::process(point_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(point_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(point_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
@@ -23,18 +23,45 @@
 
 // mapnik
 #include <mapnik/svg_renderer.hpp>
+#include <mapnik/marker_cache.hpp>
 
 namespace mapnik
 {
-    template <typename T>
-    void svg_renderer<T>::process(polygon_pattern_symbolizer const& sym,
+    /*!
+     * @brief Collect presentation attributes found in polygon pattern symbolizer,
+     * writing its pattern the first time it is used.
+     */
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(polygon_pattern_symbolizer const& sym,
 			       Feature const& feature,
 			       proj_transform const& prj_trans)
     {
-	// nothing yet.
+	std::string filename = path_processor_type::evaluate(*sym.get_filename(), feature);
+	if(filename.empty())
+	{
+	    return;
+	}
+
+	boost::optional<marker_ptr> marker = marker_cache::instance()->find(filename, true);
+	if(!marker)
+	{
+	    return;
+	}
+
+	// the pattern is aligned on the image, whatever the symbolizer's alignment.
+	path_attributes_.set_fill_pattern(find_pattern(filename, **marker));
+	path_attributes_.set_fill_opacity(sym.get_opacity());
     }
 
     template void svg_renderer<std::ostream_iterator<char> >::process(polygon_pattern_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(polygon_pattern_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(polygon_pattern_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
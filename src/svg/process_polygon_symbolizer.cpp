@@ -29,8 +29,8 @@ namespace mapnik
     /*!
      * @brief Collect presentation attributes found in polygon symbolizer.
      */
-    template <typename T>
-    void svg_renderer<T>::process(polygon_symbolizer const& sym,
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(polygon_symbolizer const& sym,
 				  Feature const& feature,
 				  proj_transform const& prj_trans)
     {
@@ -41,4 +41,12 @@ namespace mapnik
     template void svg_renderer<std::ostream_iterator<char> >::process(polygon_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(polygon_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(polygon_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
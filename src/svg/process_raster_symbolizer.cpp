@@ -23,18 +23,106 @@
 
 // mapnik
 #include <mapnik/svg_renderer.hpp>
+#include <mapnik/image_util.hpp>
+
+// stl
+#include <algorithm>
+#include <cmath>
 
 namespace mapnik 
 {
-    template <typename T>
-    void svg_renderer<T>::process(raster_symbolizer const& sym,
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(raster_symbolizer const& sym,
 			       Feature const& feature,
 			       proj_transform const& prj_trans)
     {
-	// nothing yet.
+	raster_ptr const& raster = feature.get_raster();
+	if(!raster)
+	{
+	    return;
+	}
+
+	// if there's a colorizer defined, use it to color the raster in-place.
+	raster_colorizer_ptr colorizer = sym.get_colorizer();
+	if(colorizer)
+	{
+	    colorizer->colorize(raster, feature.props());
+	}
+
+	box2d<double> raster_ext = t_.forward(raster->ext_);
+	image_data_32 const& data = raster->data_;
+
+	// only the part of the raster in the window, enlarged by the buffer, is
+	// scaled and embedded: a tile must not carry the rest of a larger raster.
+	// a few more of its pixels are kept around that part for the filters.
+	double buffer_size = map_.buffer_size();
+	box2d<double> window(-buffer_size, -buffer_size, width_ + buffer_size, height_ + buffer_size);
+	if(!raster_ext.intersects(window) || data.width() == 0 || data.height() == 0)
+	{
+	    return;
+	}
+	box2d<double> visible = raster_ext.intersect(window);
+	double pixels_x = data.width() / raster_ext.width();
+	double pixels_y = data.height() / raster_ext.height();
+	int margin = static_cast<int>(std::ceil(sym.calculate_filter_factor())) + 1;
+	int crop_x0 = std::max(0, static_cast<int>(std::floor((visible.minx() - raster_ext.minx()) * pixels_x)) - margin);
+	int crop_y0 = std::max(0, static_cast<int>(std::floor((visible.miny() - raster_ext.miny()) * pixels_y)) - margin);
+	int crop_x1 = std::min<int>(data.width(), static_cast<int>(std::ceil((visible.maxx() - raster_ext.minx()) * pixels_x)) + margin);
+	int crop_y1 = std::min<int>(data.height(), static_cast<int>(std::ceil((visible.maxy() - raster_ext.miny()) * pixels_y)) + margin);
+	if(crop_x1 <= crop_x0 || crop_y1 <= crop_y0)
+	{
+	    return;
+	}
+
+	image_data_32 cropped(crop_x1 - crop_x0, crop_y1 - crop_y0);
+	for(int y = crop_y0; y < crop_y1; ++y)
+	{
+	    cropped.setRow(y - crop_y0, data.getRow(y) + crop_x0, cropped.width());
+	}
+	box2d<double> ext(raster_ext.minx() + crop_x0 / pixels_x, raster_ext.miny() + crop_y0 / pixels_y,
+			  raster_ext.minx() + crop_x1 / pixels_x, raster_ext.miny() + crop_y1 / pixels_y);
+
+	int start_x = static_cast<int>(ext.minx());
+	int start_y = static_cast<int>(ext.miny());
+	int end_x = static_cast<int>(std::ceil(ext.maxx()));
+	int end_y = static_cast<int>(std::ceil(ext.maxy()));
+	int raster_width = end_x - start_x;
+	int raster_height = end_y - start_y;
+	double err_offs_x = ext.minx() - start_x;
+	double err_offs_y = ext.miny() - start_y;
+
+	if(raster_width > 0 && raster_height > 0)
+	{
+	    // the raster is scaled to the image's resolution as the agg renderer does
+	    // it, then embedded as a PNG image. SVG 1.1 has no compositing operators,
+	    // so the raster is drawn in normal mode whatever the symbolizer's mode.
+	    double scale_factor = ext.width() / cropped.width();
+	    image_data_32 target(raster_width, raster_height);
+
+	    if(sym.get_scaling() == "bilinear8")
+	    {
+		scale_image_bilinear8<image_data_32>(target, cropped, err_offs_x, err_offs_y);
+	    }
+	    else
+	    {
+		scaling_method_e scaling_method = get_scaling_method_by_name(sym.get_scaling());
+		scale_image_agg<image_data_32>(target, cropped, scaling_method, scale_factor,
+					       err_offs_x, err_offs_y, sym.calculate_filter_factor());
+	    }
+
+	    generator_.generate_image(start_x, start_y, target, sym.get_opacity());
+	}
     }
 
     template void svg_renderer<std::ostream_iterator<char> >::process(raster_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(raster_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(raster_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
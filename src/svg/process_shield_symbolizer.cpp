@@ -23,18 +23,232 @@
 
 // mapnik
 #include <mapnik/svg_renderer.hpp>
+#include <mapnik/placement_finder.hpp>
+#include <mapnik/marker_cache.hpp>
+
+// agg
+#include "agg_trans_affine.h"
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <cmath>
+#include <string>
 
 namespace mapnik
 {
-    template <typename T>
-    void svg_renderer<T>::process(shield_symbolizer const& sym,
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(shield_symbolizer const& sym,
                                Feature const& feature,
                                proj_transform const& prj_trans)
     {
-	// nothing yet.
+	typedef coord_transform2<CoordTransform, geometry_type> path_type;
+
+	text_placement_info_ptr placement_options = sym.get_placement_options()->get_placement_info();
+	placement_options->next();
+	placement_options->next_position_only();
+
+	UnicodeString text;
+	if(sym.get_no_text())
+	{
+	    text = UnicodeString(" ");
+	}
+	else
+	{
+	    expression_ptr name_expr = sym.get_name();
+	    if(!name_expr) return;
+	    value_type result = boost::apply_visitor(evaluate<Feature, value_type>(feature), *name_expr);
+	    text = result.to_unicode();
+	}
+
+	if(sym.get_text_transform() == UPPERCASE)
+	{
+	    text = text.toUpper();
+	}
+	else if(sym.get_text_transform() == LOWERCASE)
+	{
+	    text = text.toLower();
+	}
+	else if(sym.get_text_transform() == CAPITALIZE)
+	{
+	    text = text.toTitle(NULL);
+	}
+
+	agg::trans_affine tr;
+	boost::array<double,6> const& m = sym.get_transform();
+	tr.load_from(&m[0]);
+
+	std::string filename = path_processor_type::evaluate(*sym.get_filename(), feature);
+	boost::optional<marker_ptr> marker;
+	if(!filename.empty())
+	{
+	    marker = marker_cache::instance()->find(filename, true);
+	}
+	else
+	{
+	    marker.reset(boost::make_shared<mapnik::marker>());
+	}
+
+	if(text.length() <= 0 || !marker)
+	{
+	    return;
+	}
+
+	face_set_ptr faces;
+	if(sym.get_fontset().size() > 0)
+	{
+	    faces = font_manager_.get_face_set(sym.get_fontset());
+	}
+	else
+	{
+	    faces = font_manager_.get_face_set(sym.get_face_name());
+	}
+
+	if(!(faces->size() > 0))
+	{
+	    return;
+	}
+	faces->set_pixel_sizes(sym.get_text_size());
+
+	placement_finder<label_collision_detector4> finder(detector_);
+
+	string_info info(text);
+	faces->get_string_info(info);
+	svg::text_output_attributes attributes = text_attributes(sym, faces, info, sym.get_text_size());
+
+	int w = (*marker)->width();
+	int h = (*marker)->height();
+
+	// each shield is a use tag that refers to the marker's symbol, under the text.
+	std::string symbol_id;
+	for(unsigned i = 0; i < feature.num_geometries(); ++i)
+	{
+	    geometry_type const& geom = feature.get_geometry(i);
+	    if(geom.num_points() == 0) continue;
+
+	    path_type path(t_, geom, prj_trans);
+
+	    label_placement_enum how_placed = sym.get_label_placement();
+	    placement text_placement(info, sym, placement_options, 1.0, w, h, how_placed == LINE_PLACEMENT);
+	    text_placement.avoid_edges = sym.get_avoid_edges();
+	    if(how_placed == POINT_PLACEMENT || how_placed == VERTEX_PLACEMENT || how_placed == INTERIOR_PLACEMENT)
+	    {
+		// for every vertex, try and place a shield/text
+		geom.rewind(0);
+		text_placement.allow_overlap = sym.get_allow_overlap();
+		position const& pos = sym.get_displacement();
+		position const& shield_pos = sym.get_shield_displacement();
+		for(unsigned jj = 0; jj < geom.num_points(); ++jj)
+		{
+		    double label_x;
+		    double label_y;
+		    double z = 0.0;
+
+		    if(how_placed == VERTEX_PLACEMENT)
+			geom.vertex(&label_x, &label_y);  // by vertex
+		    else if(how_placed == INTERIOR_PLACEMENT)
+			geom.label_interior_position(&label_x, &label_y);
+		    else
+			geom.label_position(&label_x, &label_y);  // by middle of line or by point
+		    prj_trans.backward(label_x, label_y, z);
+		    t_.forward(&label_x, &label_y);
+
+		    label_x += boost::get<0>(shield_pos);
+		    label_y += boost::get<1>(shield_pos);
+
+		    {
+			trace_scope placement_scope(this->get_tracer(), "label placement", "labels");
+			finder.find_point_placement(text_placement, label_x, label_y, 0.0,
+						    sym.get_vertical_alignment(),
+						    sym.get_line_spacing(),
+						    sym.get_character_spacing(),
+						    sym.get_horizontal_alignment(),
+						    sym.get_justify_alignment());
+		    }
+
+		    // check to see if image overlaps anything too, there is only ever 1 placement found for points and verticies
+		    if(text_placement.placements.size() > 0)
+		    {
+			double x = std::floor(text_placement.placements[0].starting_x);
+			double y = std::floor(text_placement.placements[0].starting_y);
+			double cx;
+			double cy;
+			if(!sym.get_unlock_image())
+			{
+			    // center image at text center position
+			    // remove displacement from image label
+			    cx = x - boost::get<0>(pos);
+			    cy = y - boost::get<1>(pos);
+			}
+			else
+			{
+			    // center image at reference location
+			    cx = label_x;
+			    cy = label_y;
+			}
+			box2d<double> label_ext(std::floor(cx - 0.5 * w), std::floor(cy - 0.5 * h),
+						std::ceil(cx + 0.5 * w), std::ceil(cy + 0.5 * h));
+
+			if(sym.get_allow_overlap() || detector_.has_placement(label_ext))
+			{
+			    generate_shield(symbol_id, filename, **marker, tr,
+					    label_ext.minx() + 0.5 * w, label_ext.miny() + 0.5 * h, sym.get_opacity());
+			    generator_.generate_text(text_placement.placements[0], x, y, attributes);
+			    detector_.insert(label_ext);
+			    finder.update_detector(text_placement);
+			}
+		    }
+		}
+	    }
+	    else if(geom.num_points() > 1 && how_placed == LINE_PLACEMENT)
+	    {
+		{
+		    trace_scope placement_scope(this->get_tracer(), "label placement", "labels");
+		    finder.find_point_placements<path_type>(text_placement, path);
+		}
+
+		position const& pos = sym.get_displacement();
+		for(unsigned ii = 0; ii < text_placement.placements.size(); ++ii)
+		{
+		    double x = std::floor(text_placement.placements[ii].starting_x);
+		    double y = std::floor(text_placement.placements[ii].starting_y);
+		    double lx = x - boost::get<0>(pos);
+		    double ly = y - boost::get<1>(pos);
+		    generate_shield(symbol_id, filename, **marker, tr,
+				    std::floor(lx - 0.5 * w) + 0.5 * w, std::floor(ly - 0.5 * h) + 0.5 * h, sym.get_opacity());
+		    generator_.generate_text(text_placement.placements[ii], x, y, attributes);
+		}
+		finder.update_detector(text_placement);
+	    }
+	}
+    }
+
+    template <typename T, typename E>
+    void svg_renderer<T, E>::generate_shield(std::string& symbol_id, std::string const& filename, marker& m,
+					  agg::trans_affine const& tr, double x, double y, double opacity)
+    {
+	// the marker is written as a symbol the first time it is placed.
+	if(symbol_id.empty() && !find_symbol(filename, symbol_id))
+	{
+	    generator_.generate_opening_symbol(symbol_id);
+	    generator_.generate_marker(m, filename);
+	    generator_.generate_closing_symbol();
+	}
+	agg::trans_affine matrix = tr;
+	matrix *= agg::trans_affine_translation(x, y);
+	generator_.generate_use(symbol_id, matrix, opacity);
     }
 
     template void svg_renderer<std::ostream_iterator<char> >::process(shield_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(shield_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(shield_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
@@ -24,45 +24,138 @@
 // mapnik
 #include <mapnik/svg_renderer.hpp>
 
+// stl
+#include <algorithm>
+
 namespace mapnik { 
 
-template <typename OutputIterator>
-bool svg_renderer<OutputIterator>::process(rule::symbolizers const& syms,
+template <typename OutputIterator, typename PathEmitter>
+bool svg_renderer<OutputIterator, PathEmitter>::process(rule::symbolizers const& syms,
                                            Feature const& feature,
                                            proj_transform const& prj_trans)
 {
     // svg renderer supports processing of multiple symbolizers.
 
-    typedef coord_transform2<CoordTransform, geometry_type> path_type;
-
-    // process each symbolizer to collect its (path) information.
+    // process each path symbolizer to collect its information.
     // path information (attributes from line_ and polygon_ symbolizers)
     // is collected with the path_attributes_ data member.
+    // the paths are simplified with the largest tolerance set on the
+    // symbolizers, or with the renderer's tolerance if none is set.
+    // no path is written if there is no line_ or polygon_ symbolizer.
+    double simplify_tolerance = 0.0;
+    bool paths = false;
+    bool patterns = false;
+    BOOST_FOREACH(symbolizer const& sym, syms)
+    {
+        if(boost::apply_visitor(path_symbolizer_dispatch(), sym))
+        {
+            boost::apply_visitor(symbol_dispatch(*this, feature, prj_trans), sym);
+            simplify_tolerance = std::max(simplify_tolerance, boost::apply_visitor(simplify_tolerance_dispatch(), sym));
+            paths = true;
+            patterns = patterns || boost::apply_visitor(pattern_symbolizer_dispatch(), sym);
+        }
+    }
+
+    if(paths)
+    {
+        generate_feature_paths(syms, feature, prj_trans, simplify_tolerance, patterns);
+    }
+
+    // symbolizers that draw other elements (i.e. markers and labels)
+    // write them once the paths are written, in symbolizer order, so
+    // that the paths do not cover them, as in the other renderers.
     BOOST_FOREACH(symbolizer const& sym, syms)
     {
-        boost::apply_visitor(symbol_dispatch(*this, feature, prj_trans), sym);
+        if(!boost::apply_visitor(path_symbolizer_dispatch(), sym))
+        {
+            boost::apply_visitor(symbol_dispatch(*this, feature, prj_trans), sym);
+        }
+    }
+
+    return true;
+};
+
+template <typename OutputIterator, typename PathEmitter>
+void svg_renderer<OutputIterator, PathEmitter>::generate_feature_paths(rule::symbolizers const& syms,
+                                                                      Feature const& feature,
+                                                                      proj_transform const& prj_trans,
+                                                                      double simplify_tolerance,
+                                                                      bool patterns)
+{
+    typedef coord_transform2<CoordTransform, geometry_type> path_type;
+    typedef coord_transform2<svg::source_transform, geometry_type> source_path_type;
+
+    // tolerances are in pixels, paths in source coordinates in map units.
+    simplify_tolerance = simplify_tolerance > 0.0 ? simplify_tolerance : simplify_tolerance_;
+    generator_.set_simplify_tolerance(source_coordinates_ ? simplify_tolerance / t_.scale_x() : simplify_tolerance);
+
+    // the collected attributes only depend on the rule, so they are
+    // serialized for its first feature (unless a style class was
+    // assigned to the rule) and written as is for the next ones.
+    // patterns are the exception: they may depend on the feature.
+    std::string pattern_fragment;
+    std::string const* fragment = &pattern_fragment;
+    if(patterns)
+    {
+        pattern_fragment = path_attributes_fragment(generator_.generate_path_attributes(path_attributes_));
+    }
+    else
+    {
+        std::map<rule::symbolizers const*, std::string>::iterator fragment_itr = path_attributes_fragments_.find(&syms);
+        if(fragment_itr == path_attributes_fragments_.end())
+        {
+            fragment_itr = path_attributes_fragments_.insert(
+                std::make_pair(&syms, path_attributes_fragment(generator_.generate_path_attributes(path_attributes_)))).first;
+        }
+        fragment = &fragment_itr->second;
     }
 
     // generate path output for each geometry of the current feature.
+    svg::source_transform source_t;
     for(unsigned i=0; i<feature.num_geometries(); ++i)
     {
         geometry_type const& geom = feature.get_geometry(i);
-        if(geom.num_points() > 1)
+        if(geom.num_points() > 1 && source_coordinates_)
+        {
+            source_path_type path(source_t, geom, prj_trans);
+            if(path_batching_)
+            {
+                generator_.append_path(path, *fragment);
+            }
+            else
+            {
+                generator_.generate_path(path, *fragment);
+            }
+        }
+        else if(geom.num_points() > 1)
         {
             path_type path(t_, geom, prj_trans);
-            generator_.generate_path(path, path_attributes_);
+            if(path_batching_)
+            {
+                generator_.append_path(path, *fragment);
+            }
+            else
+            {
+                generator_.generate_path(path, *fragment);
+            }
         }
     }
 
     // set the previously collected values back to their defaults
     // for the feature that will be processed next.
     path_attributes_.reset();
-
-    return true;
-};
+}
 
 template bool svg_renderer<std::ostream_iterator<char> >::process(rule::symbolizers const& syms,
                                                                   Feature const& feature,
                                                                   proj_transform const& prj_trans);
 
+template bool svg_renderer<svg::output_buffer_iterator>::process(rule::symbolizers const& syms,
+                                                                 Feature const& feature,
+                                                                 proj_transform const& prj_trans);
+
+template bool svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(rule::symbolizers const& syms,
+                                                                                         Feature const& feature,
+                                                                                         proj_transform const& prj_trans);
+
 }
@@ -23,18 +23,135 @@
 
 // mapnik
 #include <mapnik/svg_renderer.hpp>
+#include <mapnik/placement_finder.hpp>
+#include <mapnik/config_error.hpp>
 
 namespace mapnik 
 {
-    template <typename T>
-    void svg_renderer<T>::process(text_symbolizer const& sym,
+    template <typename T, typename E>
+    void svg_renderer<T, E>::process(text_symbolizer const& sym,
 			       Feature const& feature,
 			       proj_transform const& prj_trans)
     {
-	// nothing yet.
+	typedef coord_transform2<CoordTransform, geometry_type> path_type;
+
+	// labels are placed as agg_renderer places them, with the metrics of the
+	// glyphs (which are not rendered), and written as text tags.
+	bool placement_found = false;
+	text_placement_info_ptr placement_options = sym.get_placement_options()->get_placement_info();
+	while(!placement_found && placement_options->next())
+	{
+	    expression_ptr name_expr = sym.get_name();
+	    if(!name_expr) return;
+	    value_type result = boost::apply_visitor(evaluate<Feature, value_type>(feature), *name_expr);
+	    UnicodeString text = result.to_unicode();
+
+	    if(sym.get_text_transform() == UPPERCASE)
+	    {
+		text = text.toUpper();
+	    }
+	    else if(sym.get_text_transform() == LOWERCASE)
+	    {
+		text = text.toLower();
+	    }
+	    else if(sym.get_text_transform() == CAPITALIZE)
+	    {
+		text = text.toTitle(NULL);
+	    }
+
+	    if(text.length() <= 0) continue;
+
+	    face_set_ptr faces;
+	    if(sym.get_fontset().size() > 0)
+	    {
+		faces = font_manager_.get_face_set(sym.get_fontset());
+	    }
+	    else
+	    {
+		faces = font_manager_.get_face_set(sym.get_face_name());
+	    }
+
+	    if(!(faces->size() > 0))
+	    {
+		throw config_error("Unable to find specified font face '" + sym.get_face_name() + "'");
+	    }
+	    faces->set_pixel_sizes(placement_options->text_size);
+
+	    box2d<double> dims(0, 0, width_, height_);
+	    placement_finder<label_collision_detector4> finder(detector_, dims);
+
+	    string_info info(text);
+	    faces->get_string_info(info);
+	    svg::text_output_attributes attributes = text_attributes(sym, faces, info, placement_options->text_size);
+
+	    unsigned num_geom = feature.num_geometries();
+	    for(unsigned i = 0; i < num_geom; ++i)
+	    {
+		geometry_type const& geom = feature.get_geometry(i);
+		if(geom.num_points() == 0) continue; // don't bother with empty geometries
+		while(!placement_found && placement_options->next_position_only())
+		{
+		    placement text_placement(info, sym, placement_options, 1.0);
+		    text_placement.avoid_edges = sym.get_avoid_edges();
+		    if(sym.get_label_placement() == POINT_PLACEMENT ||
+		       sym.get_label_placement() == INTERIOR_PLACEMENT)
+		    {
+			double label_x;
+			double label_y;
+			double z = 0.0;
+			if(sym.get_label_placement() == POINT_PLACEMENT)
+			    geom.label_position(&label_x, &label_y);
+			else
+			    geom.label_interior_position(&label_x, &label_y);
+			prj_trans.backward(label_x, label_y, z);
+			t_.forward(&label_x, &label_y);
+
+			double angle = 0.0;
+			expression_ptr angle_expr = sym.get_orientation();
+			if(angle_expr)
+			{
+			    // apply rotation
+			    value_type result = boost::apply_visitor(evaluate<Feature, value_type>(feature), *angle_expr);
+			    angle = result.to_double();
+			}
+
+			trace_scope placement_scope(this->get_tracer(), "label placement", "labels");
+			finder.find_point_placement(text_placement, label_x, label_y,
+						    angle, sym.get_vertical_alignment(), sym.get_line_spacing(),
+						    sym.get_character_spacing(), sym.get_horizontal_alignment(),
+						    sym.get_justify_alignment());
+
+			finder.update_detector(text_placement);
+		    }
+		    else if(geom.num_points() > 1 && sym.get_label_placement() == LINE_PLACEMENT)
+		    {
+			path_type path(t_, geom, prj_trans);
+			trace_scope placement_scope(this->get_tracer(), "label placement", "labels");
+			finder.find_line_placements<path_type>(text_placement, path);
+		    }
+
+		    if(!text_placement.placements.size()) continue;
+		    placement_found = true;
+
+		    for(unsigned ii = 0; ii < text_placement.placements.size(); ++ii)
+		    {
+			text_path const& label = text_placement.placements[ii];
+			generator_.generate_text(label, label.starting_x, label.starting_y, attributes);
+		    }
+		}
+	    }
+	}
     }
 
     template void svg_renderer<std::ostream_iterator<char> >::process(text_symbolizer const& sym,
 								      Feature const& feature,
 								      proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator>::process(text_symbolizer const& sym,
+								     Feature const& feature,
+								     proj_transform const& prj_trans);
+
+    template void svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>::process(text_symbolizer const& sym,
+											     Feature const& feature,
+											     proj_transform const& prj_trans);
 }
@@ -23,60 +23,856 @@
 // mapnik
 #include <mapnik/svg/svg_generator.hpp>
 #include <mapnik/geometry.hpp>
+#include <mapnik/svg/svg_output_buffer.hpp>
+#include <mapnik/arrow.hpp>
+#include <mapnik/png_io.hpp>
+#include <mapnik/svg/svg_base64_encoder.hpp>
+#include <mapnik/text_path.hpp>
+
+// agg
+#include "agg_conv_curve.h"
 
 // boost
 #include <boost/spirit/include/karma.hpp>
 
+// stl
+#include <algorithm>
+#include <cmath>
+
 namespace mapnik { namespace svg {
 
     using namespace boost::spirit;
 
-    template <typename OutputIterator>
-    svg_generator<OutputIterator>::svg_generator(OutputIterator& output_iterator) 
-	: output_iterator_(output_iterator)
+    template <typename OutputIterator, typename PathEmitter>
+    svg_generator<OutputIterator, PathEmitter>::svg_generator(OutputIterator& output_iterator) 
+	: output_iterator_(output_iterator),
+	  coordinate_precision_(3),
+	  path_commands_(ABSOLUTE_PATH_COMMANDS),
+	  clip_box_(),
+	  clipping_(false),
+	  simplify_tolerance_(0.0),
+	  douglas_peucker_(false),
+	  source_matrix_(),
+	  source_group_open_(false)
     {}
 
-    template <typename OutputIterator>
-    svg_generator<OutputIterator>::~svg_generator() {}
+    template <typename OutputIterator, typename PathEmitter>
+    svg_generator<OutputIterator, PathEmitter>::~svg_generator() {}
 
-    template <typename OutputIterator>
-    void svg_generator<OutputIterator>::generate_header()
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_header()
     {
 	karma::generate(output_iterator_, lit("<?xml version=\"1.0\" standalone=\"no\"?>\n"));
 	karma::generate(output_iterator_, lit("<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n"));
     }
 
-    template <typename OutputIterator>
-    void svg_generator<OutputIterator>::generate_opening_root(root_output_attributes const& root_attributes)
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_opening_root(root_output_attributes const& root_attributes)
     {
 	root_attributes_grammar attributes_grammar;
 	karma::generate(output_iterator_, lit("<svg ") << attributes_grammar << lit(">\n"), root_attributes);
     }
 
-    template <typename OutputIterator>
-    void svg_generator<OutputIterator>::generate_closing_root()
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_closing_root()
     {
 	karma::generate(output_iterator_, lit("</svg>"));
     }
 
-    template <typename OutputIterator>
-    void svg_generator<OutputIterator>::generate_rect(rect_output_attributes const& rect_attributes)
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_rect(rect_output_attributes const& rect_attributes)
     {
 	rect_attributes_grammar attributes_grammar;
 	karma::generate(output_iterator_, lit("<rect ") << attributes_grammar << lit("/>\n"), rect_attributes);
     }
 
-    template <typename OutputIterator>
-    void svg_generator<OutputIterator>::generate_path(path_type const& path, path_output_attributes const& path_attributes) 
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_path(path_type const& path, path_output_attributes const& path_attributes) 
     {	
-        path_data_grammar data_grammar(path);
 	path_attributes_grammar attributes_grammar;
 	path_dash_array_grammar dash_array_grammar;
 
-	karma::generate(output_iterator_, lit("<path ")	<< data_grammar, path);
+	if(!generate_path_data(path))
+	{
+	    return;
+	}
 	karma::generate(output_iterator_, lit(" ") << dash_array_grammar, path_attributes.stroke_dasharray());
 	karma::generate(output_iterator_, lit(" ") << attributes_grammar << lit("/>\n"), path_attributes);
     }
 
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_path(path_type const& path, std::string const& attributes_fragment) 
+    {
+	if(!generate_path_data(path))
+	{
+	    return;
+	}
+	generate_path_end(attributes_fragment);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::append_path(path_type const& path, std::string const& attributes_fragment)
+    {
+	append_path_data(path, attributes_fragment);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_path(source_path_type const& path, std::string const& attributes_fragment) 
+    {
+	generate_opening_source_group();
+	if(!generate_path_data(path))
+	{
+	    return;
+	}
+	generate_path_end(attributes_fragment);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::append_path(source_path_type const& path, std::string const& attributes_fragment)
+    {
+	generate_opening_source_group();
+	append_path_data(path, attributes_fragment);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_opening_source_group()
+    {
+	if(source_group_open_)
+	{
+	    return;
+	}
+
+	generate_batch_path();
+
+	// source units are usually much smaller than pixels, so the scale
+	// is written with six significant digits rather than six fractional ones.
+	double scale = std::max(std::fabs(source_matrix_.sx), std::fabs(source_matrix_.sy));
+	unsigned factor_precision = 6;
+	if(scale > 0.0 && scale < 1.0)
+	{
+	    factor_precision += static_cast<unsigned>(-std::floor(std::log10(scale)));
+	}
+
+	karma::generate(output_iterator_, lit("<g"));
+	generate_transform(source_matrix_, factor_precision);
+	karma::generate(output_iterator_, lit(">\n"));
+	source_group_open_ = true;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    template <typename PathType>
+    void svg_generator<OutputIterator, PathEmitter>::append_path_data(PathType const& path, std::string const& attributes_fragment)
+    {
+	if(!batch_path_data_.empty() && batch_attributes_fragment_ != attributes_fragment)
+	{
+	    generate_batch_path();
+	}
+
+	std::string::size_type batch_size = batch_path_data_.size();
+	if(batch_path_data_.empty())
+	{
+	    batch_attributes_fragment_ = attributes_fragment;
+	}
+	else
+	{
+	    batch_path_data_ += ' ';
+	}
+
+	if(!generate_path_data(path, batch_path_data_))
+	{
+	    batch_path_data_.resize(batch_size);
+	}
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::flush_paths()
+    {
+	generate_batch_path();
+	if(source_group_open_)
+	{
+	    karma::generate(output_iterator_, lit("</g>\n"));
+	    source_group_open_ = false;
+	}
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_batch_path()
+    {
+	if(batch_path_data_.empty())
+	{
+	    return;
+	}
+
+	karma::generate(output_iterator_, lit("<path d=\"") << karma::string << lit('"'), batch_path_data_);
+	generate_path_end(batch_attributes_fragment_);
+	batch_path_data_.clear();
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_path_end(std::string const& attributes_fragment)
+    {
+	// attributes inherited from a group are not repeated: there may be none left.
+	if(attributes_fragment.empty())
+	{
+	    karma::generate(output_iterator_, lit("/>\n"));
+	}
+	else
+	{
+	    karma::generate(output_iterator_, lit(" ") << karma::string << lit("/>\n"), attributes_fragment);
+	}
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    std::string svg_generator<OutputIterator, PathEmitter>::generate_path_attributes(path_output_attributes const& path_attributes)
+    {
+	path_attributes_fragment_grammar attributes_grammar;
+	path_dash_array_fragment_grammar dash_array_grammar;
+
+	std::string fragment;
+	fragment_iterator fragment_output_iterator(fragment);
+	karma::generate(fragment_output_iterator, dash_array_grammar, path_attributes.stroke_dasharray());
+	karma::generate(fragment_output_iterator, lit(" ") << attributes_grammar, path_attributes);
+	return fragment;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    std::string svg_generator<OutputIterator, PathEmitter>::generate_path_style(path_output_attributes const& path_attributes)
+    {
+	path_style_fragment_grammar style_grammar;
+	path_dash_array_style_fragment_grammar dash_array_style_grammar;
+
+	std::string fragment;
+	fragment_iterator fragment_output_iterator(fragment);
+	karma::generate(fragment_output_iterator, style_grammar, path_attributes);
+	if(!path_attributes.stroke_dasharray().empty())
+	{
+	    karma::generate(fragment_output_iterator, dash_array_style_grammar, path_attributes.stroke_dasharray());
+	}
+	return fragment;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_style_sheet(std::vector<std::pair<std::string, std::string> > const& style_classes)
+    {
+	karma::generate(output_iterator_, lit("<style type=\"text/css\"><![CDATA[\n"));
+	for(std::vector<std::pair<std::string, std::string> >::const_iterator itr = style_classes.begin();
+	    itr != style_classes.end(); ++itr)
+	{
+	    karma::generate(output_iterator_,
+			    lit('.') << karma::string << lit('{') << karma::string << lit("}\n"),
+			    itr->first, itr->second);
+	}
+	karma::generate(output_iterator_, lit("]]></style>\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    template <typename PathType>
+    bool svg_generator<OutputIterator, PathEmitter>::generate_path_data(PathType const& path)
+    {
+	typedef path_clipper<PathType> clipped_path_type;
+	typedef path_simplifier<clipped_path_type> simplified_path_type;
+	typedef coordinate_snapper<simplified_path_type> snapped_path_type;
+	typedef path_command_encoder<snapped_path_type> encoded_path_type;
+
+	clipped_path_type clipped_path(path, clip_box_, clipping_, is_polygon(path));
+	if(clipping_ && clipped_path.empty())
+	{
+	    return false;
+	}
+
+	simplified_path_type simplified_path(clipped_path, simplify_tolerance_, douglas_peucker_);
+	snapped_path_type snapped_path(simplified_path, coordinate_precision_);
+
+	karma::generate(output_iterator_, lit("<path d=\""));
+	if(path_commands_ == ABSOLUTE_PATH_COMMANDS)
+	{
+	    PathEmitter::generate_path_data(output_iterator_, snapped_path, coordinate_precision_);
+	}
+	else
+	{
+	    encoded_path_type encoded_path(snapped_path, path_commands_, coordinate_precision_);
+	    PathEmitter::generate_path_commands_data(output_iterator_, encoded_path, coordinate_precision_);
+	}
+	karma::generate(output_iterator_, lit('"'));
+	return true;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    template <typename PathType>
+    bool svg_generator<OutputIterator, PathEmitter>::generate_path_data(PathType const& path, std::string& path_data)
+    {
+	typedef path_clipper<PathType> clipped_path_type;
+	typedef path_simplifier<clipped_path_type> simplified_path_type;
+	typedef coordinate_snapper<simplified_path_type> snapped_path_type;
+	typedef path_command_encoder<snapped_path_type> encoded_path_type;
+
+	clipped_path_type clipped_path(path, clip_box_, clipping_, is_polygon(path));
+	if(clipping_ && clipped_path.empty())
+	{
+	    return false;
+	}
+
+	simplified_path_type simplified_path(clipped_path, simplify_tolerance_, douglas_peucker_);
+	snapped_path_type snapped_path(simplified_path, coordinate_precision_);
+	fragment_iterator fragment_output_iterator(path_data);
+
+	if(path_commands_ == ABSOLUTE_PATH_COMMANDS)
+	{
+	    PathEmitter::generate_path_data(fragment_output_iterator, snapped_path, coordinate_precision_);
+	}
+	else
+	{
+	    encoded_path_type encoded_path(snapped_path, path_commands_, coordinate_precision_);
+	    PathEmitter::generate_path_commands_data(fragment_output_iterator, encoded_path, coordinate_precision_);
+	}
+	return true;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_opening_symbol(std::string const& id)
+    {
+	// symbols are written where they are first used, so
+	// the paths batched so far must be written before.
+	flush_paths();
+	karma::generate(output_iterator_,
+			lit("<defs>\n<symbol id=\"") << karma::string << lit("\" overflow=\"visible\">\n"),
+			id);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_closing_symbol()
+    {
+	karma::generate(output_iterator_, lit("</symbol>\n</defs>\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_opening_pattern(std::string const& id, double width, double height,
+								  agg::trans_affine const& matrix)
+    {
+	coordinate_policy<double> policy(coordinate_precision_);
+	coordinate_generator coordinate(policy);
+
+	// like symbols, patterns are written where they are first used.
+	flush_paths();
+	karma::generate(output_iterator_,
+			lit("<defs>\n<pattern id=\"") << karma::string
+			<< lit("\" patternUnits=\"userSpaceOnUse\" width=\"") << coordinate << lit("\" height=\"") << coordinate
+			<< lit("\" viewBox=\"") << coordinate << lit(' ') << coordinate << lit(' ') << coordinate << lit(' ') << coordinate << lit('"'),
+			id, width, height, -0.5 * width, -0.5 * height, width, height);
+	if(!matrix.is_identity())
+	{
+	    karma::generate(output_iterator_, lit(" patternTransform=\""));
+	    generate_matrix(matrix, 6);
+	    karma::generate(output_iterator_, lit('"'));
+	}
+	karma::generate(output_iterator_, lit(">\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_closing_pattern()
+    {
+	karma::generate(output_iterator_, lit("</pattern>\n</defs>\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_opening_group(std::string const& id, std::string const& name,
+									    std::string const& attributes_fragment)
+    {
+	flush_paths();
+	karma::generate(output_iterator_, lit("<g id=\"") << karma::string << lit("\" data-name=\""), id);
+	for(std::string::const_iterator c = name.begin(); c != name.end(); ++c)
+	{
+	    if(*c == '&')
+	    {
+		karma::generate(output_iterator_, lit("&amp;"));
+	    }
+	    else if(*c == '<')
+	    {
+		karma::generate(output_iterator_, lit("&lt;"));
+	    }
+	    else if(*c == '"')
+	    {
+		karma::generate(output_iterator_, lit("&quot;"));
+	    }
+	    else
+	    {
+		*output_iterator_++ = *c;
+	    }
+	}
+	karma::generate(output_iterator_, lit('"'));
+	if(!attributes_fragment.empty())
+	{
+	    karma::generate(output_iterator_, lit(' ') << karma::string, attributes_fragment);
+	}
+	karma::generate(output_iterator_, lit(">\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_closing_group()
+    {
+	flush_paths();
+	karma::generate(output_iterator_, lit("</g>\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_marker(marker& m, std::string const& filename)
+    {
+	coordinate_policy<double> policy(coordinate_precision_);
+	coordinate_generator coordinate(policy);
+
+	if(m.is_vector())
+	{
+	    path_attributes_grammar attributes_grammar;
+
+	    path_ptr vector_marker = *m.get_vector_data();
+	    coord<double, 2> center = vector_marker->bounding_box().center();
+	    agg::trans_affine recenter = agg::trans_affine_translation(-center.x, -center.y);
+
+	    vertex_stl_adapter<svg_path_storage> stl_storage(vector_marker->source());
+	    svg_path_adapter svg_path(stl_storage);
+	    agg::conv_curve<svg_path_adapter> curved_path(svg_path);
+
+	    agg::pod_bvector<path_attributes> const& attributes = vector_marker->attributes();
+	    for(unsigned i = 0; i < attributes.size(); ++i)
+	    {
+		path_attributes const& attr = attributes[i];
+		if(!attr.visibility_flag)
+		    continue;
+
+		// gradients are not written, the paths are painted
+		// with the first color of the gradient instead.
+		path_output_attributes output_attributes;
+		if(attr.fill_flag)
+		{
+		    output_attributes.set_fill_color(color(attr.fill_color.r, attr.fill_color.g, attr.fill_color.b));
+		    output_attributes.set_fill_opacity(attr.opacity * attr.fill_color.a / 255.0);
+		}
+		else if(attr.fill_gradient.get_gradient_type() != NO_GRADIENT && !attr.fill_gradient.get_stop_array().empty())
+		{
+		    color const& stop_color = attr.fill_gradient.get_stop_array().front().second;
+		    output_attributes.set_fill_color(stop_color);
+		    output_attributes.set_fill_opacity(attr.opacity * stop_color.alpha() / 255.0);
+		}
+
+		if(attr.stroke_flag)
+		{
+		    output_attributes.set_stroke_color(color(attr.stroke_color.r, attr.stroke_color.g, attr.stroke_color.b));
+		    output_attributes.set_stroke_opacity(attr.opacity * attr.stroke_color.a / 255.0);
+		}
+		else if(attr.stroke_gradient.get_gradient_type() != NO_GRADIENT && !attr.stroke_gradient.get_stop_array().empty())
+		{
+		    color const& stop_color = attr.stroke_gradient.get_stop_array().front().second;
+		    output_attributes.set_stroke_color(stop_color);
+		    output_attributes.set_stroke_opacity(attr.opacity * stop_color.alpha() / 255.0);
+		}
+		if(attr.stroke_flag || attr.stroke_gradient.get_gradient_type() != NO_GRADIENT)
+		{
+		    output_attributes.set_stroke_width(attr.stroke_width);
+		    output_attributes.set_stroke_linecap(line_cap_enum(attr.line_cap));
+		    output_attributes.set_stroke_linejoin(line_join_enum(attr.line_join));
+		}
+
+		karma::generate(output_iterator_, lit("<path d=\""));
+		generate_marker_path_data(curved_path, attr.index);
+		karma::generate(output_iterator_, lit("\" ") << attributes_grammar, output_attributes);
+		if(attr.even_odd_flag)
+		{
+		    karma::generate(output_iterator_, lit(" fill-rule=\"evenodd\""));
+		}
+
+		agg::trans_affine transform = attr.transform;
+		transform *= recenter;
+		if(!transform.is_identity())
+		{
+		    generate_transform(transform);
+		}
+		karma::generate(output_iterator_, lit("/>\n"));
+	    }
+	}
+	else if(m.is_bitmap())
+	{
+	    double width = m.width();
+	    double height = m.height();
+
+	    if(filename.empty())
+	    {
+		karma::generate(output_iterator_,
+				lit("<rect x=\"") << coordinate << lit("\" y=\"") << coordinate
+				<< lit("\" width=\"") << coordinate << lit("\" height=\"") << coordinate
+				<< lit("\" fill=\"#000000\"/>\n"),
+				-0.5 * width, -0.5 * height, width, height);
+	    }
+	    else
+	    {
+		karma::generate(output_iterator_,
+				lit("<image x=\"") << coordinate << lit("\" y=\"") << coordinate
+				<< lit("\" width=\"") << coordinate << lit("\" height=\"") << coordinate
+				<< lit("\" xlink:href=\""),
+				-0.5 * width, -0.5 * height, width, height);
+		generate_png_data_uri(**m.get_bitmap_data());
+		karma::generate(output_iterator_, lit("\"/>\n"));
+	    }
+	}
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_ellipse_marker(double rx, double ry, path_output_attributes const& attributes)
+    {
+	coordinate_policy<double> policy(coordinate_precision_);
+	coordinate_generator coordinate(policy);
+	path_attributes_grammar attributes_grammar;
+
+	karma::generate(output_iterator_,
+			lit("<ellipse rx=\"") << coordinate << lit("\" ry=\"") << coordinate << lit("\" ")
+			<< attributes_grammar << lit("/>\n"),
+			rx, ry, attributes);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_arrow_marker(path_output_attributes const& attributes)
+    {
+	path_attributes_grammar attributes_grammar;
+	arrow arrow_path;
+
+	karma::generate(output_iterator_, lit("<path d=\""));
+	generate_marker_path_data(arrow_path, 0);
+	karma::generate(output_iterator_, lit("\" ") << attributes_grammar << lit("/>\n"), attributes);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_use(std::string const& id, agg::trans_affine const& matrix, double opacity)
+    {
+	coordinate_policy<double> policy(coordinate_precision_);
+	coordinate_generator coordinate(policy);
+
+	flush_paths();
+	karma::generate(output_iterator_, lit("<use xlink:href=\"#") << karma::string << lit('"'), id);
+	if(matrix.sx == 1.0 && matrix.shy == 0.0 && matrix.shx == 0.0 && matrix.sy == 1.0)
+	{
+	    karma::generate(output_iterator_,
+			    lit(" x=\"") << coordinate << lit("\" y=\"") << coordinate << lit('"'),
+			    matrix.tx, matrix.ty);
+	}
+	else
+	{
+	    generate_transform(matrix);
+	}
+	if(opacity < 1.0)
+	{
+	    karma::generate(output_iterator_, lit(" opacity=\"") << karma::double_ << lit('"'), opacity);
+	}
+	karma::generate(output_iterator_, lit("/>\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_text(text_path const& path, double x, double y,
+								   text_output_attributes const& attributes)
+    {
+	if(path.num_nodes() == 0)
+	{
+	    return;
+	}
+
+	flush_paths();
+	if(attributes.halo_radius() > 0.0)
+	{
+	    generate_text_element(path, x, y, attributes, true);
+	}
+	generate_text_element(path, x, y, attributes, false);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_text_element(text_path const& path, double x, double y,
+									   text_output_attributes const& attributes, bool halo)
+    {
+	coordinate_policy<double> policy(coordinate_precision_);
+	coordinate_generator coordinate(policy);
+	coordinate_policy<double> angle_policy(2);
+	coordinate_generator angle(angle_policy);
+	text_attributes_grammar attributes_grammar;
+
+	// glyph positions are relative to (x, y), upwards, and
+	// rotated counterclockwise, as freetype lays them out.
+	std::vector<double> xs;
+	std::vector<double> ys;
+	std::vector<double> angles;
+	bool rotated = false;
+	for(text_path::character_nodes_t::const_iterator node = path.nodes_.begin(); node != path.nodes_.end(); ++node)
+	{
+	    xs.push_back(x + node->x);
+	    ys.push_back(y - node->y);
+	    angles.push_back(-node->angle * 180.0 / M_PI);
+	    rotated = rotated || node->angle != 0.0;
+	}
+
+	// spaces are significant: each character has its own position.
+	karma::generate(output_iterator_,
+			lit("<text xml:space=\"preserve\" x=\"") << (coordinate % lit(' '))
+			<< lit("\" y=\"") << (coordinate % lit(' ')) << lit('"'),
+			xs, ys);
+	if(rotated)
+	{
+	    karma::generate(output_iterator_, lit(" rotate=\"") << (angle % lit(' ')) << lit('"'), angles);
+	}
+	if(halo)
+	{
+	    text_output_attributes halo_attributes(attributes);
+	    halo_attributes.set_fill_color(attributes.halo_color());
+	    karma::generate(output_iterator_, lit(' ') << attributes_grammar, halo_attributes);
+	    karma::generate(output_iterator_,
+			    lit(" stroke=\"") << karma::string << lit("\" stroke-width=\"") << karma::double_
+			    << lit("\" stroke-linejoin=\"round\""),
+			    attributes.halo_color().to_hex_string(), 2.0 * attributes.halo_radius());
+	}
+	else
+	{
+	    karma::generate(output_iterator_, lit(' ') << attributes_grammar, attributes);
+	}
+	karma::generate(output_iterator_, lit('>'));
+
+	// the characters are written in UTF-8, in the
+	// (visual) order in which they were placed.
+	for(text_path::character_nodes_t::const_iterator node = path.nodes_.begin(); node != path.nodes_.end(); ++node)
+	{
+	    unsigned c = node->c;
+	    if(c == '&')
+	    {
+		karma::generate(output_iterator_, lit("&amp;"));
+	    }
+	    else if(c == '<')
+	    {
+		karma::generate(output_iterator_, lit("&lt;"));
+	    }
+	    else if(c == '>')
+	    {
+		karma::generate(output_iterator_, lit("&gt;"));
+	    }
+	    else if(c < 0x20)
+	    {
+		// control characters are not allowed in XML.
+		*output_iterator_++ = ' ';
+	    }
+	    else if(c < 0x80)
+	    {
+		*output_iterator_++ = static_cast<char>(c);
+	    }
+	    else if(c < 0x800)
+	    {
+		*output_iterator_++ = static_cast<char>(0xc0 | (c >> 6));
+		*output_iterator_++ = static_cast<char>(0x80 | (c & 0x3f));
+	    }
+	    else if(c < 0x10000)
+	    {
+		*output_iterator_++ = static_cast<char>(0xe0 | (c >> 12));
+		*output_iterator_++ = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+		*output_iterator_++ = static_cast<char>(0x80 | (c & 0x3f));
+	    }
+	    else
+	    {
+		*output_iterator_++ = static_cast<char>(0xf0 | (c >> 18));
+		*output_iterator_++ = static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+		*output_iterator_++ = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+		*output_iterator_++ = static_cast<char>(0x80 | (c & 0x3f));
+	    }
+	}
+	karma::generate(output_iterator_, lit("</text>\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_image(double x, double y, image_data_32 const& image, double opacity)
+    {
+	coordinate_policy<double> policy(coordinate_precision_);
+	coordinate_generator coordinate(policy);
+
+	flush_paths();
+	karma::generate(output_iterator_,
+			lit("<image x=\"") << coordinate << lit("\" y=\"") << coordinate
+			<< lit("\" width=\"") << karma::uint_ << lit("\" height=\"") << karma::uint_ << lit('"'),
+			x, y, image.width(), image.height());
+	if(opacity < 1.0)
+	{
+	    karma::generate(output_iterator_, lit(" opacity=\"") << karma::double_ << lit('"'), opacity);
+	}
+	karma::generate(output_iterator_, lit(" xlink:href=\""));
+	generate_png_data_uri(image);
+	karma::generate(output_iterator_, lit("\"/>\n"));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_png_data_uri(image_data_32 const& image)
+    {
+	karma::generate(output_iterator_, lit("data:image/png;base64,"));
+
+	base64_encoder<OutputIterator> encoder(output_iterator_);
+	save_as_png(encoder, image);
+	encoder.finish();
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    template <typename VertexSource>
+    void svg_generator<OutputIterator, PathEmitter>::generate_marker_path_data(VertexSource& path, unsigned path_id)
+    {
+	coordinate_policy<double> policy(coordinate_precision_);
+	coordinate_generator coordinate(policy);
+
+	path.rewind(path_id);
+	bool first = true;
+	double x, y;
+	unsigned command;
+	while(!agg::is_stop(command = path.vertex(&x, &y)))
+	{
+	    char command_char;
+	    if(agg::is_move_to(command))
+		command_char = 'M';
+	    else if(agg::is_vertex(command))
+		command_char = 'L';
+	    else if(agg::is_close(command))
+		command_char = 'Z';
+	    else
+		continue;
+
+	    if(!first)
+	    {
+		karma::generate(output_iterator_, lit(' '));
+	    }
+	    first = false;
+
+	    if(command_char == 'Z')
+	    {
+		karma::generate(output_iterator_, lit('Z'));
+	    }
+	    else
+	    {
+		karma::generate(output_iterator_, karma::char_ << coordinate << lit(' ') << coordinate, command_char, x, y);
+	    }
+	}
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_transform(agg::trans_affine const& matrix, unsigned factor_precision)
+    {
+	karma::generate(output_iterator_, lit(" transform=\""));
+	generate_matrix(matrix, factor_precision);
+	karma::generate(output_iterator_, lit('"'));
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::generate_matrix(agg::trans_affine const& matrix, unsigned factor_precision)
+    {
+	// the linear part of the matrix needs more digits than coordinates do.
+	coordinate_policy<double> factor_policy(factor_precision);
+	coordinate_policy<double> policy(coordinate_precision_);
+	coordinate_generator factor(factor_policy);
+	coordinate_generator coordinate(policy);
+
+	karma::generate(output_iterator_,
+			lit("matrix(") << factor << lit(' ') << factor << lit(' ') << factor << lit(' ') << factor
+			<< lit(' ') << coordinate << lit(' ') << coordinate << lit(')'),
+			matrix.sx, matrix.shy, matrix.shx, matrix.sy, matrix.tx, matrix.ty);
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    template <typename PathType>
+    bool svg_generator<OutputIterator, PathEmitter>::is_polygon(PathType const& path)
+    {
+	eGeomType type = path.geom().type();
+	return type == Polygon || type == MultiPolygon;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::set_coordinate_precision(unsigned precision)
+    {
+	coordinate_precision_ = precision;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    unsigned svg_generator<OutputIterator, PathEmitter>::coordinate_precision() const
+    {
+	return coordinate_precision_;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::set_clip_box(box2d<double> const& clip_box)
+    {
+	clip_box_ = clip_box;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    box2d<double> const& svg_generator<OutputIterator, PathEmitter>::clip_box() const
+    {
+	return clip_box_;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::set_clipping(bool clipping)
+    {
+	clipping_ = clipping;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    bool svg_generator<OutputIterator, PathEmitter>::clipping() const
+    {
+	return clipping_;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::set_simplify_tolerance(double tolerance)
+    {
+	simplify_tolerance_ = tolerance;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    double svg_generator<OutputIterator, PathEmitter>::simplify_tolerance() const
+    {
+	return simplify_tolerance_;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::set_douglas_peucker(bool douglas_peucker)
+    {
+	douglas_peucker_ = douglas_peucker;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    bool svg_generator<OutputIterator, PathEmitter>::douglas_peucker() const
+    {
+	return douglas_peucker_;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::set_source_matrix(agg::trans_affine const& matrix)
+    {
+	source_matrix_ = matrix;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    agg::trans_affine const& svg_generator<OutputIterator, PathEmitter>::source_matrix() const
+    {
+	return source_matrix_;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    void svg_generator<OutputIterator, PathEmitter>::set_path_commands(path_commands_e commands)
+    {
+	path_commands_ = commands;
+    }
+
+    template <typename OutputIterator, typename PathEmitter>
+    path_commands_e svg_generator<OutputIterator, PathEmitter>::path_commands() const
+    {
+	return path_commands_;
+    }
+
     template class svg_generator<std::ostream_iterator<char> >;
+    template class svg_generator<output_buffer_iterator>;
+    template class svg_generator<std::ostream_iterator<char>, fast_path_emitter>;
+    template class svg_generator<output_buffer_iterator, fast_path_emitter>;
+
+    template struct svg_root_attributes_grammar<output_buffer_iterator>;
+    template struct svg_rect_attributes_grammar<output_buffer_iterator>;
+    template struct svg_path_data_grammar<output_buffer_iterator, coordinate_snapper<path_simplifier<path_clipper<coord_transform2<CoordTransform, geometry_type> > > > >;
+    template struct svg_path_commands_data_grammar<output_buffer_iterator, path_command_encoder<coordinate_snapper<path_simplifier<path_clipper<coord_transform2<CoordTransform, geometry_type> > > > > >;
+    template struct svg_path_attributes_grammar<output_buffer_iterator>;
+    template struct svg_path_dash_array_grammar<output_buffer_iterator>;
+    template struct svg_text_attributes_grammar<output_buffer_iterator>;
 }}
@@ -45,6 +45,16 @@ namespace mapnik { namespace svg {
 	stroke_color_ = stroke_color.to_hex_string();
     }
 
+    void path_output_attributes::set_fill_pattern(std::string const& pattern_id)
+    {
+	fill_color_ = "url(#" + pattern_id + ")";
+    }
+
+    void path_output_attributes::set_stroke_pattern(std::string const& pattern_id)
+    {
+	stroke_color_ = "url(#" + pattern_id + ")";
+    }
+
     void path_output_attributes::set_stroke_opacity(const double stroke_opacity)
     {
 	stroke_opacity_ = stroke_opacity;
@@ -104,6 +114,17 @@ namespace mapnik { namespace svg {
 	stroke_dashoffset_ = stroke_dashoffset;
     }
 
+    void path_output_attributes::set_stroke(stroke const& path_stroke)
+    {
+	set_stroke_color(path_stroke.get_color());
+	set_stroke_opacity(path_stroke.get_opacity());
+	set_stroke_width(path_stroke.get_width());
+	set_stroke_linecap(path_stroke.get_line_cap());
+	set_stroke_linejoin(path_stroke.get_line_join());
+	set_stroke_dasharray(path_stroke.get_dash_array());
+	set_stroke_dashoffset(path_stroke.dash_offset());
+    }
+
     const std::string path_output_attributes::fill_color() const
     {
 	return fill_color_;
@@ -227,19 +248,22 @@ namespace mapnik { namespace svg {
 
     const double root_output_attributes::SVG_VERSION = 1.1;    
     const std::string root_output_attributes::SVG_NAMESPACE_URL = "http://www.w3.org/2000/svg";    
+    const std::string root_output_attributes::XLINK_NAMESPACE_URL = "http://www.w3.org/1999/xlink";
 
     root_output_attributes::root_output_attributes()
 	: width_(400),
 	  height_(400),
 	  svg_version_(SVG_VERSION),
-	  svg_namespace_url_(SVG_NAMESPACE_URL)
+	  svg_namespace_url_(SVG_NAMESPACE_URL),
+	  xlink_namespace_url_(XLINK_NAMESPACE_URL)
     {}
 
     root_output_attributes::root_output_attributes(const unsigned width, const unsigned height)
 	: width_(width),
 	  height_(height),
 	  svg_version_(SVG_VERSION),
-	  svg_namespace_url_(SVG_NAMESPACE_URL)
+	  svg_namespace_url_(SVG_NAMESPACE_URL),
+	  xlink_namespace_url_(XLINK_NAMESPACE_URL)
     {}
 
     void root_output_attributes::set_width(const unsigned width)
@@ -262,6 +286,11 @@ namespace mapnik { namespace svg {
 	svg_namespace_url_ = svg_namespace_url;
     }
 
+    void root_output_attributes::set_xlink_namespace_url(std::string const& xlink_namespace_url)
+    {
+	xlink_namespace_url_ = xlink_namespace_url;
+    }
+
     const unsigned root_output_attributes::width() const
     {
 	return width_;
@@ -282,11 +311,137 @@ namespace mapnik { namespace svg {
 	return svg_namespace_url_;
     }
 
+    const std::string root_output_attributes::xlink_namespace_url() const
+    {
+	return xlink_namespace_url_;
+    }
+
     void root_output_attributes::reset()
     {
 	width_ = 400;
 	height_ = 400;
 	svg_version_ = SVG_VERSION;
 	svg_namespace_url_ = SVG_NAMESPACE_URL;
+	xlink_namespace_url_ = XLINK_NAMESPACE_URL;
+    }
+
+    // text_output_attributes
+
+    void text_output_attributes::set_font_family(std::string const& font_family)
+    {
+	font_family_.clear();
+	for(std::string::const_iterator c = font_family.begin(); c != font_family.end(); ++c)
+	{
+	    if(*c == '&')
+	    {
+		font_family_ += "&amp;";
+	    }
+	    else if(*c == '<')
+	    {
+		font_family_ += "&lt;";
+	    }
+	    else if(*c == '"')
+	    {
+		font_family_ += "&quot;";
+	    }
+	    else
+	    {
+		font_family_ += *c;
+	    }
+	}
+    }
+
+    void text_output_attributes::set_font_size(const double font_size)
+    {
+	font_size_ = font_size;
+    }
+
+    void text_output_attributes::set_font_style_name(std::string const& style_name)
+    {
+	font_weight_ = (style_name.find("Bold") != std::string::npos) ? "bold" : "normal";
+	if(style_name.find("Italic") != std::string::npos)
+	{
+	    font_style_ = "italic";
+	}
+	else if(style_name.find("Oblique") != std::string::npos)
+	{
+	    font_style_ = "oblique";
+	}
+	else
+	{
+	    font_style_ = "normal";
+	}
+    }
+
+    void text_output_attributes::set_fill_color(color const& fill_color)
+    {
+	fill_color_ = fill_color.to_hex_string();
+    }
+
+    void text_output_attributes::set_fill_opacity(const double fill_opacity)
+    {
+	fill_opacity_ = fill_opacity;
+    }
+
+    void text_output_attributes::set_halo_color(color const& halo_color)
+    {
+	halo_color_ = halo_color;
+    }
+
+    void text_output_attributes::set_halo_radius(const double halo_radius)
+    {
+	halo_radius_ = halo_radius;
+    }
+
+    const std::string text_output_attributes::font_family() const
+    {
+	return font_family_;
+    }
+
+    const double text_output_attributes::font_size() const
+    {
+	return font_size_;
+    }
+
+    const std::string text_output_attributes::font_weight() const
+    {
+	return font_weight_;
+    }
+
+    const std::string text_output_attributes::font_style() const
+    {
+	return font_style_;
+    }
+
+    const std::string text_output_attributes::fill_color() const
+    {
+	return fill_color_;
+    }
+
+    const double text_output_attributes::fill_opacity() const
+    {
+	return fill_opacity_;
+    }
+
+    const color text_output_attributes::halo_color() const
+    {
+	return halo_color_;
+    }
+
+    const double text_output_attributes::halo_radius() const
+    {
+	return halo_radius_;
+    }
+
+    void text_output_attributes::reset()
+    {
+	font_family_.clear();
+	font_size_ = 10.0;
+	font_weight_ = "normal";
+	font_style_ = "normal";
+	fill_color_ = "#000000";
+	fill_opacity_ = 1.0;
+	halo_color_ = color(255, 255, 255);
+	halo_radius_ = 0.0;
     }
 }}
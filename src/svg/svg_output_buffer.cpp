@@ -0,0 +1,247 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/svg/svg_output_buffer.hpp>
+
+// zlib
+#include <zlib.h>
+
+// stl
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WINDOWS
+#include <io.h>
+#define write_fd(fd, data, size) ::_write(fd, data, static_cast<unsigned>(size))
+#else
+#include <unistd.h>
+#define write_fd(fd, data, size) ::write(fd, data, size)
+#endif
+
+namespace mapnik { namespace svg {
+
+    // output_buffer
+
+    const std::size_t output_buffer::DEFAULT_CHUNK_SIZE;
+
+    output_buffer::output_buffer(std::size_t chunk_size)
+	: buffer_(chunk_size > 0 ? chunk_size : DEFAULT_CHUNK_SIZE),
+	  pos_(&buffer_[0]),
+	  end_(&buffer_[0] + buffer_.size())
+    {}
+
+    output_buffer::~output_buffer() {}
+
+    void output_buffer::write(char const* s, std::size_t n)
+    {
+	while(n > 0)
+	{
+	    if(pos_ == end_)
+	    {
+		overflow();
+	    }
+	    std::size_t count = std::min(n, static_cast<std::size_t>(end_ - pos_));
+	    std::memcpy(pos_, s, count);
+	    pos_ += count;
+	    s += count;
+	    n -= count;
+	}
+    }
+
+    void output_buffer::flush() {}
+
+    char const* output_buffer::data() const
+    {
+	return &buffer_[0];
+    }
+
+    std::size_t output_buffer::size() const
+    {
+	return pos_ - &buffer_[0];
+    }
+
+    std::size_t output_buffer::capacity() const
+    {
+	return buffer_.size();
+    }
+
+    std::string output_buffer::str() const
+    {
+	return std::string(data(), size());
+    }
+
+    void output_buffer::clear()
+    {
+	pos_ = &buffer_[0];
+    }
+
+    void output_buffer::overflow()
+    {
+	std::size_t used = size();
+	buffer_.resize(buffer_.size() * 2);
+	pos_ = &buffer_[0] + used;
+	end_ = &buffer_[0] + buffer_.size();
+    }
+
+    // fd_output_buffer
+
+    fd_output_buffer::fd_output_buffer(int fd, std::size_t chunk_size)
+	: output_buffer(chunk_size),
+	  fd_(fd),
+	  bytes_written_(0)
+    {}
+
+    fd_output_buffer::~fd_output_buffer()
+    {
+	// destructors must not throw, remaining bytes are
+	// lost if the descriptor can't be written.
+	try
+	{
+	    flush();
+	}
+	catch(...) {}
+    }
+
+    void fd_output_buffer::flush()
+    {
+	char const* p = data();
+	std::size_t remaining = size();
+	while(remaining > 0)
+	{
+	    long written = write_fd(fd_, p, remaining);
+	    if(written < 0)
+	    {
+		if(errno == EINTR)
+		    continue;
+		throw std::runtime_error(std::string("could not write svg output: ") + std::strerror(errno));
+	    }
+	    p += written;
+	    remaining -= written;
+	    bytes_written_ += written;
+	}
+	clear();
+    }
+
+    std::size_t fd_output_buffer::bytes_written() const
+    {
+	return bytes_written_;
+    }
+
+    void fd_output_buffer::overflow()
+    {
+	flush();
+    }
+
+    // gzip_output_buffer
+
+    const int gzip_output_buffer::DEFAULT_COMPRESSION;
+
+    gzip_output_buffer::gzip_output_buffer(output_buffer& destination, int level, std::size_t chunk_size)
+	: output_buffer(chunk_size),
+	  destination_(destination),
+	  stream_(new z_stream),
+	  compressed_(capacity()),
+	  bytes_in_(0),
+	  finished_(false)
+    {
+	stream_->zalloc = Z_NULL;
+	stream_->zfree = Z_NULL;
+	stream_->opaque = Z_NULL;
+
+	// a window size of 15 + 16 makes zlib write a gzip header and trailer.
+	if(deflateInit2(stream_.get(), level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+	    throw std::runtime_error("could not initialize svgz compression");
+	}
+    }
+
+    gzip_output_buffer::~gzip_output_buffer()
+    {
+	// destructors must not throw, the output is left
+	// incomplete if it can't be compressed or written.
+	try
+	{
+	    finish();
+	}
+	catch(...) {}
+	deflateEnd(stream_.get());
+    }
+
+    void gzip_output_buffer::flush()
+    {
+	if(!finished_)
+	{
+	    deflate_buffer(Z_SYNC_FLUSH);
+	}
+	destination_.flush();
+    }
+
+    void gzip_output_buffer::finish()
+    {
+	if(!finished_)
+	{
+	    deflate_buffer(Z_FINISH);
+	    finished_ = true;
+	}
+    }
+
+    std::size_t gzip_output_buffer::bytes_in() const
+    {
+	return bytes_in_;
+    }
+
+    void gzip_output_buffer::overflow()
+    {
+	if(finished_)
+	{
+	    throw std::runtime_error("svgz output written after the end of the stream");
+	}
+	deflate_buffer(Z_NO_FLUSH);
+    }
+
+    void gzip_output_buffer::deflate_buffer(int flush)
+    {
+	stream_->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data()));
+	stream_->avail_in = static_cast<uInt>(size());
+	bytes_in_ += size();
+
+	int result;
+	do
+	{
+	    stream_->next_out = reinterpret_cast<Bytef*>(&compressed_[0]);
+	    stream_->avail_out = static_cast<uInt>(compressed_.size());
+	    result = deflate(stream_.get(), flush);
+	    if(result == Z_STREAM_ERROR)
+	    {
+		throw std::runtime_error("could not compress svgz output");
+	    }
+	    destination_.write(&compressed_[0], compressed_.size() - stream_->avail_out);
+	}
+	while(stream_->avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+	clear();
+    }
+}}
@@ -23,30 +23,286 @@
 
 // mapnik
 #include <mapnik/svg_renderer.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/scale_denominator.hpp>
+
+// boost
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#endif
 
 // stl
-#ifdef MAPNIK_DEBUG
+#include <algorithm>
 #include <iostream>
-#endif
 #include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace mapnik
 {
-    template <typename T>
-    svg_renderer<T>::svg_renderer(Map const& m, T & output_iterator, unsigned offset_x, unsigned offset_y) :
+    template <typename T, typename E>
+    svg_renderer<T, E>::svg_renderer(Map const& m, T & output_iterator, unsigned offset_x, unsigned offset_y,
+				  unsigned width, unsigned height) :
 	feature_style_processor<svg_renderer>(m),
+	map_(m),
 	output_iterator_(output_iterator),
-	width_(m.width()),
-	height_(m.height()),
+	width_(width ? width : m.width()),
+	height_(height ? height : m.height()),
 	t_(m.width(),m.height(),m.get_current_extent(),offset_x,offset_y),
-	generator_(output_iterator)
-    {}
+	generator_(output_iterator),
+	style_classes_(false),
+	layer_groups_(false),
+	path_batching_(false),
+	source_coordinates_(false),
+	simplify_tolerance_(*m.get_extra_attributes().get<double>("simplify-tolerance", 0.0)),
+	font_engine_(),
+	font_manager_(font_engine_),
+	detector_(box2d<double>(-m.buffer_size(), -m.buffer_size(), width_ + m.buffer_size(), height_ + m.buffer_size())),
+	layer_threads_(1),
+	symbol_id_prefix_("m")
+    {
+	// clip paths to the window, enlarged by the buffer around it.
+	double buffer_size = m.buffer_size();
+	generator_.set_clip_box(box2d<double>(-buffer_size, -buffer_size, width_ + buffer_size, height_ + buffer_size));
+	generator_.set_clipping(true);
+    }
 
-    template <typename T>
-    svg_renderer<T>::~svg_renderer() {}
+    template <typename T, typename E>
+    void svg_renderer<T, E>::set_source_coordinates(bool source_coordinates)
+    {
+	source_coordinates_ = source_coordinates;
 
-    template <typename T>
-    void svg_renderer<T>::start_map_processing(Map const& map)
+	// the clip box is in the units of the generated paths.
+	double buffer_size = map_.buffer_size();
+	box2d<double> clip_box(-buffer_size, -buffer_size, width_ + buffer_size, height_ + buffer_size);
+	if(source_coordinates_)
+	{
+	    clip_box = t_.backward(clip_box);
+	}
+	generator_.set_clip_box(clip_box);
+
+	// the transform of the paths in source coordinates is the map's
+	// transform: it scales them, flips them vertically and moves them.
+	double x0 = 0.0;
+	double y0 = 0.0;
+	t_.forward(&x0, &y0);
+	generator_.set_source_matrix(agg::trans_affine(t_.scale_x(), 0.0, 0.0, -t_.scale_y(), x0, y0));
+    }
+
+    template <typename T, typename E>
+    svg_renderer<T, E>::~svg_renderer() {}
+
+    template <typename T, typename E>
+    struct svg_renderer<T, E>::layer_jobs
+    {
+	layer_jobs() : next(0) {}
+
+	std::vector<layer const*> layers;
+	std::vector<boost::shared_ptr<svg::output_buffer> > buffers;
+	std::vector<render_stats> stats;
+	std::size_t next;
+	std::string error;
+	#ifdef MAPNIK_THREADSAFE
+	boost::mutex mutex;
+	#endif
+    };
+
+    template <typename T, typename E>
+    void svg_renderer<T, E>::apply()
+    {
+	#ifdef MAPNIK_THREADSAFE
+	if(layer_threads_ > 1)
+	{
+	    apply_to_layers_in_parallel();
+	    return;
+	}
+	#endif
+	feature_style_processor<svg_renderer>::apply();
+    }
+
+    template <typename T, typename E>
+    void svg_renderer<T, E>::apply_to_layers_in_parallel()
+    {
+	trace_scope map_scope(this->get_tracer(), "map");
+	render_stats* stats = this->get_render_stats();
+	double start = 0.0;
+	if(stats)
+	{
+	    stats->clear();
+	    start = stats_clock();
+	}
+
+	// the start of the document is only written once all the layers are rendered,
+	// so that a layer that fails leaves the output untouched.
+	svg::output_buffer map_start;
+	svg::output_buffer_iterator map_start_iterator(map_start);
+	svg_renderer<svg::output_buffer_iterator, E> map_start_renderer(map_, map_start_iterator, 0, 0, width_, height_);
+	configure_part_renderer(map_start_renderer);
+	map_start_renderer.start_map_processing(map_);
+	map_start_renderer.generator_.flush_paths();
+	path_attributes_fragments_ = map_start_renderer.path_attributes_fragments_;
+	symbol_ids_.clear();
+
+	layer_jobs jobs;
+	bool metawriters_started = false;
+	try
+	{
+	    projection proj(map_.srs());
+	    double scale_denom = scale_denominator(map_, proj.is_geographic());
+	    BOOST_FOREACH(layer const& lyr, map_.layers())
+	    {
+		if(lyr.isVisible(scale_denom))
+		{
+		    jobs.layers.push_back(&lyr);
+		    jobs.buffers.push_back(boost::shared_ptr<svg::output_buffer>(new svg::output_buffer));
+		}
+	    }
+
+	    // metawriters are started and stopped as in sequential rendering,
+	    // though no symbolizer of this renderer writes to them.
+	    for(Map::const_metawriter_iterator itr = map_.begin_metawriters(); itr != map_.end_metawriters(); ++itr)
+	    {
+		itr->second->set_size(map_.width(), map_.height());
+		itr->second->set_map_srs(proj);
+		itr->second->start(map_.metawriter_output_properties);
+	    }
+	    metawriters_started = true;
+	}
+	catch(proj_init_error& ex)
+	{
+	    std::clog << "proj_init_error:" << ex.what() << "\n";
+	}
+	if(stats)
+	{
+	    jobs.stats.resize(jobs.layers.size());
+	}
+
+	#ifdef MAPNIK_THREADSAFE
+	// each thread renders the next layer that is left, into the
+	// layer's own buffer, until all the layers are rendered.
+	boost::thread_group threads;
+	unsigned thread_count = std::min<std::size_t>(layer_threads_, jobs.layers.size());
+	for(unsigned i = 0; i < thread_count; ++i)
+	{
+	    threads.create_thread(boost::bind(&svg_renderer<T, E>::render_layers, this, boost::ref(jobs)));
+	}
+	threads.join_all();
+	#endif
+
+	if(metawriters_started)
+	{
+	    for(Map::const_metawriter_iterator itr = map_.begin_metawriters(); itr != map_.end_metawriters(); ++itr)
+	    {
+		itr->second->stop();
+	    }
+	}
+
+	if(!jobs.error.empty())
+	{
+	    throw std::runtime_error(jobs.error);
+	}
+
+	// write the start of the map, then the layers, and merge
+	// their stats, in their order in the map.
+	generator_.flush_paths();
+	std::copy(map_start.data(), map_start.data() + map_start.size(), output_iterator_);
+	BOOST_FOREACH(boost::shared_ptr<svg::output_buffer> const& buffer, jobs.buffers)
+	{
+	    std::copy(buffer->data(), buffer->data() + buffer->size(), output_iterator_);
+	}
+	BOOST_FOREACH(render_stats const& layer_render_stats, jobs.stats)
+	{
+	    stats->merge(layer_render_stats);
+	}
+
+	end_map_processing(map_);
+	if(stats)
+	{
+	    stats->time = stats_clock() - start;
+	}
+    }
+
+    template <typename T, typename E>
+    void svg_renderer<T, E>::render_layers(layer_jobs& jobs)
+    {
+	for(;;)
+	{
+	    std::size_t index;
+	    {
+		#ifdef MAPNIK_THREADSAFE
+		boost::mutex::scoped_lock lock(jobs.mutex);
+		#endif
+		if(jobs.next == jobs.layers.size() || !jobs.error.empty())
+		{
+		    return;
+		}
+		index = jobs.next++;
+	    }
+
+	    try
+	    {
+		svg::output_buffer_iterator output_iterator(*jobs.buffers[index]);
+		svg_renderer<svg::output_buffer_iterator, E> renderer(map_, output_iterator, 0, 0, width_, height_);
+		configure_part_renderer(renderer);
+		renderer.path_attributes_fragments_ = path_attributes_fragments_;
+		// the layers' events are recorded in the threads that render them.
+		renderer.set_tracer(this->get_tracer());
+		if(!jobs.stats.empty())
+		{
+		    renderer.set_render_stats(&jobs.stats[index]);
+		}
+		// symbols of different layers must not share ids.
+		renderer.symbol_id_prefix_ = symbol_id_prefix_ + boost::lexical_cast<std::string>(index) + "_";
+		renderer.feature_style_processor<svg_renderer<svg::output_buffer_iterator, E> >::apply(*jobs.layers[index]);
+		renderer.generator_.flush_paths();
+	    }
+	    catch(std::exception const& ex)
+	    {
+		#ifdef MAPNIK_THREADSAFE
+		boost::mutex::scoped_lock lock(jobs.mutex);
+		#endif
+		if(jobs.error.empty())
+		{
+		    jobs.error = ex.what();
+		}
+	    }
+	    catch(...)
+	    {
+		// an exception that escaped the thread would terminate the process.
+		#ifdef MAPNIK_THREADSAFE
+		boost::mutex::scoped_lock lock(jobs.mutex);
+		#endif
+		if(jobs.error.empty())
+		{
+		    jobs.error = "unknown error while rendering layer '" + jobs.layers[index]->name() + "'";
+		}
+	    }
+	}
+    }
+
+    template <typename T, typename E>
+    void svg_renderer<T, E>::configure_part_renderer(svg_renderer<svg::output_buffer_iterator, E>& renderer) const
+    {
+	renderer.t_ = t_;
+	renderer.set_coordinate_precision(coordinate_precision());
+	renderer.set_clipping(clipping());
+	renderer.set_douglas_peucker(douglas_peucker());
+	renderer.set_path_commands(path_commands());
+	renderer.set_simplify_tolerance(simplify_tolerance_);
+	renderer.set_path_batching(path_batching_);
+	renderer.set_layer_groups(layer_groups_);
+	renderer.style_classes_ = style_classes_;
+	renderer.set_source_coordinates(source_coordinates_);
+    }
+
+    template <typename T, typename E>
+    void svg_renderer<T, E>::start_map_processing(Map const& map)
     {
 	#ifdef MAPNIK_DEBUG
 	std::clog << "start map processing" << std::endl;
@@ -61,6 +317,13 @@ namespace mapnik
 	svg::root_output_attributes root_attributes(width_, height_);
 	generator_.generate_opening_root(root_attributes);	
 
+	path_attributes_fragments_.clear();
+	symbol_ids_.clear();
+	if(style_classes_)
+	{
+	    generate_style_classes(map);
+	}
+
 	boost::optional<color> const& bgcolor = map.background();
 	if(bgcolor)
 	{
@@ -70,8 +333,8 @@ namespace mapnik
 	}
     }
 
-    template <typename T>
-    void svg_renderer<T>::end_map_processing(Map const& map)
+    template <typename T, typename E>
+    void svg_renderer<T, E>::end_map_processing(Map const& map)
     {
 	// generate SVG root element closing tag.
 	generator_.generate_closing_root();
@@ -81,21 +344,299 @@ namespace mapnik
 	#endif
     }
 
-    template <typename T>
-    void svg_renderer<T>::start_layer_processing(layer const& lay)
+    template <typename T, typename E>
+    void svg_renderer<T, E>::start_layer_processing(layer const& lay)
     {
 	#ifdef MAPNIK_DEBUG
 	std::clog << "start layer processing: " << lay.name() << std::endl;
 	#endif
+
+	if(lay.clear_label_cache())
+	{
+	    detector_.clear();
+	}
+
+	if(layer_groups_)
+	{
+	    // with style classes, paths only refer to their class.
+	    std::string attributes_fragment;
+	    if(!style_classes_)
+	    {
+		attributes_fragment = hoist_path_attributes(lay);
+	    }
+	    generator_.generate_opening_group(layer_group_id(lay), lay.name(), attributes_fragment);
+	}
     }
     
-    template <typename T>
-    void svg_renderer<T>::end_layer_processing(layer const& lay)
+    template <typename T, typename E>
+    void svg_renderer<T, E>::end_layer_processing(layer const& lay)
     {
+	// write the paths batched for the last features of the layer.
+	generator_.flush_paths();
+
+	if(layer_groups_)
+	{
+	    generator_.generate_closing_group();
+
+	    // the rules may be used by other layers, with other groups.
+	    BOOST_FOREACH(rule::symbolizers const* syms, hoisted_rules_)
+	    {
+		path_attributes_fragments_.erase(syms);
+	    }
+	    hoisted_rules_.clear();
+	}
+
 	#ifdef MAPNIK_DEBUG
 	std::clog << "end layer processing: " << lay.name() << std::endl;
 	#endif
     }
 
+    template <typename T, typename E>
+    void svg_renderer<T, E>::generate_style_classes(Map const& map)
+    {
+	// each distinct set of declarations becomes a class, shared
+	// by all the rules whose symbolizers produce it.
+	std::map<std::string, std::string> class_names;
+	std::vector<std::pair<std::string, std::string> > style_classes;
+
+	BOOST_FOREACH(layer const& lay, map.layers())
+	{
+	    if(!lay.isActive())
+		continue;
+
+	    BOOST_FOREACH(std::string const& style_name, lay.styles())
+	    {
+		boost::optional<feature_type_style const&> style = map.find_style(style_name);
+		if(!style)
+		    continue;
+
+		BOOST_FOREACH(rule const& r, style->get_rules())
+		{
+		    rule::symbolizers const& syms = r.get_symbolizers();
+		    if(path_attributes_fragments_.count(&syms))
+			continue;
+
+		    bool patterns = false;
+		    BOOST_FOREACH(symbolizer const& sym, syms)
+		    {
+			patterns = patterns || boost::apply_visitor(pattern_symbolizer_dispatch(), sym);
+		    }
+		    if(patterns)
+			continue;
+
+		    svg::path_output_attributes path_attributes;
+		    BOOST_FOREACH(symbolizer const& sym, syms)
+		    {
+			boost::apply_visitor(path_attributes_dispatch(path_attributes), sym);
+		    }
+
+		    std::string declarations = generator_.generate_path_style(path_attributes);
+		    std::map<std::string, std::string>::const_iterator itr = class_names.find(declarations);
+		    if(itr == class_names.end())
+		    {
+			std::string class_name = "s" + boost::lexical_cast<std::string>(style_classes.size());
+			itr = class_names.insert(std::make_pair(declarations, class_name)).first;
+			style_classes.push_back(std::make_pair(class_name, declarations));
+		    }
+		    path_attributes_fragments_[&syms] = path_attributes_fragment("class=\"" + itr->second + "\"");
+		}
+	    }
+	}
+
+	if(!style_classes.empty())
+	{
+	    generator_.generate_style_sheet(style_classes);
+	}
+    }
+
+    template <typename T, typename E>
+    std::string svg_renderer<T, E>::hoist_path_attributes(layer const& lay)
+    {
+	std::vector<rule::symbolizers const*> rules;
+	std::vector<std::vector<std::string> > rule_attributes;
+	BOOST_FOREACH(std::string const& style_name, lay.styles())
+	{
+	    boost::optional<feature_type_style const&> style = map_.find_style(style_name);
+	    if(!style)
+		continue;
+
+	    BOOST_FOREACH(rule const& r, style->get_rules())
+	    {
+		rule::symbolizers const& syms = r.get_symbolizers();
+		svg::path_output_attributes path_attributes;
+		BOOST_FOREACH(symbolizer const& sym, syms)
+		{
+		    // markers, labels and pattern contents would inherit the
+		    // attributes of the group too, and patterns vary by feature.
+		    if(!boost::apply_visitor(path_symbolizer_dispatch(), sym) ||
+		       boost::apply_visitor(pattern_symbolizer_dispatch(), sym))
+		    {
+			return std::string();
+		    }
+		    boost::apply_visitor(path_attributes_dispatch(path_attributes), sym);
+		}
+		if(syms.empty())
+		    continue;
+
+		rules.push_back(&syms);
+		rule_attributes.push_back(split_path_attributes(generator_.generate_path_attributes(path_attributes)));
+	    }
+	}
+	if(rules.empty())
+	{
+	    return std::string();
+	}
+
+	// the attributes that every rule writes, with the same value.
+	std::vector<std::string> shared_attributes = rule_attributes[0];
+	for(std::size_t i = 1; i < rule_attributes.size(); ++i)
+	{
+	    std::vector<std::string> remaining;
+	    BOOST_FOREACH(std::string const& attribute, shared_attributes)
+	    {
+		if(std::find(rule_attributes[i].begin(), rule_attributes[i].end(), attribute) != rule_attributes[i].end())
+		{
+		    remaining.push_back(attribute);
+		}
+	    }
+	    shared_attributes.swap(remaining);
+	}
+	if(shared_attributes.empty())
+	{
+	    return std::string();
+	}
+
+	for(std::size_t i = 0; i < rules.size(); ++i)
+	{
+	    std::string fragment;
+	    BOOST_FOREACH(std::string const& attribute, rule_attributes[i])
+	    {
+		if(std::find(shared_attributes.begin(), shared_attributes.end(), attribute) == shared_attributes.end())
+		{
+		    fragment += fragment.empty() ? attribute : " " + attribute;
+		}
+	    }
+	    path_attributes_fragments_[rules[i]] = path_attributes_fragment(fragment);
+	    hoisted_rules_.push_back(rules[i]);
+	}
+
+	std::string group_fragment;
+	BOOST_FOREACH(std::string const& attribute, shared_attributes)
+	{
+	    group_fragment += group_fragment.empty() ? attribute : " " + attribute;
+	}
+	return group_fragment;
+    }
+
+    template <typename T, typename E>
+    std::string svg_renderer<T, E>::layer_group_id(layer const& lay) const
+    {
+	// layers are rendered from the map's own list, also in parallel.
+	std::vector<layer> const& layers = map_.layers();
+	std::size_t index = 0;
+	while(index < layers.size() && &layers[index] != &lay)
+	{
+	    ++index;
+	}
+
+	std::string id = "layer-" + boost::lexical_cast<std::string>(index) + "-";
+	for(std::string::const_iterator c = lay.name().begin(); c != lay.name().end(); ++c)
+	{
+	    bool allowed = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9')
+		|| *c == '-' || *c == '_' || *c == '.';
+	    id += allowed ? *c : '_';
+	}
+	return id;
+    }
+
+    template <typename T, typename E>
+    std::vector<std::string> svg_renderer<T, E>::split_path_attributes(std::string const& fragment)
+    {
+	// values are written between double quotes, and never contain any.
+	std::vector<std::string> attributes;
+	std::string::size_type start = fragment.find_first_not_of(' ');
+	while(start != std::string::npos)
+	{
+	    std::string::size_type value_start = fragment.find('"', start);
+	    if(value_start == std::string::npos)
+		break;
+	    std::string::size_type value_end = fragment.find('"', value_start + 1);
+	    if(value_end == std::string::npos)
+		break;
+	    attributes.push_back(fragment.substr(start, value_end + 1 - start));
+	    start = fragment.find_first_not_of(' ', value_end + 1);
+	}
+	return attributes;
+    }
+
+    template <typename T, typename E>
+    std::string svg_renderer<T, E>::path_attributes_fragment(std::string const& fragment) const
+    {
+	if(source_coordinates_)
+	{
+	    // strokes would otherwise be scaled by the transform of the paths.
+	    // the attribute is not inherited, so it is never hoisted onto groups.
+	    return fragment.empty() ? "vector-effect=\"non-scaling-stroke\"" : fragment + " vector-effect=\"non-scaling-stroke\"";
+	}
+	return fragment;
+    }
+
+    template <typename T, typename E>
+    bool svg_renderer<T, E>::find_symbol(std::string const& marker_key, std::string& id)
+    {
+	std::map<std::string, std::string>::const_iterator itr = symbol_ids_.find(marker_key);
+	if(itr != symbol_ids_.end())
+	{
+	    id = itr->second;
+	    return true;
+	}
+
+	id = symbol_id_prefix_ + boost::lexical_cast<std::string>(symbol_ids_.size());
+	symbol_ids_.insert(std::make_pair(marker_key, id));
+	return false;
+    }
+
+    template <typename T, typename E>
+    std::string svg_renderer<T, E>::find_pattern(std::string const& filename, marker& m)
+    {
+	std::string id;
+	if(!find_symbol("<pattern>" + filename, id))
+	{
+	    // paths in source coordinates are drawn in a transformed group: the
+	    // pattern must undo the transform, so that its cells stay in pixels.
+	    agg::trans_affine matrix;
+	    if(source_coordinates_)
+	    {
+		matrix = generator_.source_matrix();
+		matrix.invert();
+	    }
+	    generator_.generate_opening_pattern(id, m.width(), m.height(), matrix);
+	    generator_.generate_marker(m, filename);
+	    generator_.generate_closing_pattern();
+	}
+	return id;
+    }
+
+    template <typename T, typename E>
+    svg::text_output_attributes svg_renderer<T, E>::text_attributes(text_symbolizer const& sym, face_set_ptr const& faces,
+								   string_info const& info, double text_size) const
+    {
+	svg::text_output_attributes attributes;
+	if(info.num_characters() > 0)
+	{
+	    face_ptr face = faces->get_glyph(info.at(0).character)->get_face();
+	    attributes.set_font_family(face->family_name());
+	    attributes.set_font_style_name(face->style_name());
+	}
+	attributes.set_font_size(text_size);
+	attributes.set_fill_color(sym.get_fill());
+	attributes.set_fill_opacity(sym.get_text_opacity());
+	attributes.set_halo_color(sym.get_halo_fill());
+	attributes.set_halo_radius(sym.get_halo_radius());
+	return attributes;
+    }
+
     template class svg_renderer<std::ostream_iterator<char> >;
+    template class svg_renderer<svg::output_buffer_iterator>;
+    template class svg_renderer<svg::output_buffer_iterator, svg::fast_path_emitter>;
 }
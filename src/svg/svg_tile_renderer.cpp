@@ -0,0 +1,143 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+// mapnik
+#include <mapnik/svg_tile_renderer.hpp>
+
+// boost
+#include <boost/foreach.hpp>
+
+// stl
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace mapnik
+{
+    template <typename T>
+    svg_tile_renderer<T>::svg_tile_renderer(Map const& m, unsigned columns, unsigned rows, std::vector<T>& output_iterators) :
+	feature_style_processor<svg_tile_renderer>(m),
+	columns_(columns),
+	rows_(rows),
+	t_(m.width(),m.height(),m.get_current_extent())
+    {
+	if(columns == 0 || rows == 0 || output_iterators.size() != columns * rows)
+	{
+	    throw std::invalid_argument("svg_tile_renderer: there must be one output iterator per tile");
+	}
+
+	unsigned tile_width = m.width() / columns;
+	unsigned tile_height = m.height() / rows;
+	double buffer_size = m.buffer_size();
+	for(unsigned row = 0; row < rows; ++row)
+	{
+	    unsigned y = row * tile_height;
+	    unsigned height = (row + 1 == rows) ? m.height() - y : tile_height;
+	    for(unsigned column = 0; column < columns; ++column)
+	    {
+		unsigned x = column * tile_width;
+		unsigned width = (column + 1 == columns) ? m.width() - x : tile_width;
+		tiles_.push_back(boost::shared_ptr<tile_renderer_type>(
+				     new tile_renderer_type(m, output_iterators[row * columns + column], x, y, width, height)));
+		windows_.push_back(box2d<double>(x - buffer_size, y - buffer_size,
+						 x + width + buffer_size, y + height + buffer_size));
+	    }
+	}
+    }
+
+    template <typename T>
+    svg_tile_renderer<T>::~svg_tile_renderer() {}
+
+    template <typename T>
+    void svg_tile_renderer<T>::start_map_processing(Map const& map)
+    {
+	BOOST_FOREACH(boost::shared_ptr<tile_renderer_type> const& tile, tiles_)
+	{
+	    tile->start_map_processing(map);
+	}
+    }
+
+    template <typename T>
+    void svg_tile_renderer<T>::end_map_processing(Map const& map)
+    {
+	BOOST_FOREACH(boost::shared_ptr<tile_renderer_type> const& tile, tiles_)
+	{
+	    tile->end_map_processing(map);
+	}
+    }
+
+    template <typename T>
+    void svg_tile_renderer<T>::start_layer_processing(layer const& lay)
+    {
+	BOOST_FOREACH(boost::shared_ptr<tile_renderer_type> const& tile, tiles_)
+	{
+	    tile->start_layer_processing(lay);
+	}
+    }
+
+    template <typename T>
+    void svg_tile_renderer<T>::end_layer_processing(layer const& lay)
+    {
+	BOOST_FOREACH(boost::shared_ptr<tile_renderer_type> const& tile, tiles_)
+	{
+	    tile->end_layer_processing(lay);
+	}
+    }
+
+    template <typename T>
+    bool svg_tile_renderer<T>::process(rule::symbolizers const& syms,
+				       Feature const& feature,
+				       proj_transform const& prj_trans)
+    {
+	// the tiles that the feature does not intersect would clip all of its paths away.
+	box2d<double> extent = feature_extent(feature, prj_trans);
+	for(unsigned i = 0; i < tiles_.size(); ++i)
+	{
+	    if(windows_[i].intersects(extent))
+	    {
+		tiles_[i]->process(syms, feature, prj_trans);
+	    }
+	}
+	return true;
+    }
+
+    template <typename T>
+    box2d<double> svg_tile_renderer<T>::feature_extent(Feature const& feature,
+							proj_transform const& prj_trans) const
+    {
+	raster_ptr const& raster = feature.get_raster();
+	if(raster)
+	{
+	    return t_.forward(raster->ext_);
+	}
+	if(feature.num_geometries() == 0)
+	{
+	    double max = std::numeric_limits<double>::max();
+	    return box2d<double>(-max, -max, max, max);
+	}
+	return t_.forward(feature.envelope(), prj_trans);
+    }
+
+    template class svg_tile_renderer<std::ostream_iterator<char> >;
+    template class svg_tile_renderer<svg::output_buffer_iterator>;
+}
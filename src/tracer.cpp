@@ -0,0 +1,128 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2010 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/tracer.hpp>
+#include "stats_util.hpp"
+
+// stl
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+namespace mapnik {
+
+tracer::tracer()
+    : start_(wall_clock_us()) {}
+
+void tracer::begin(char const* name, char const* category, std::string const& detail)
+{
+    add(name, category, 'B', detail);
+}
+
+void tracer::end(char const* name, char const* category)
+{
+    add(name, category, 'E', std::string());
+}
+
+void tracer::add(char const* name, char const* category, char phase, std::string const& detail)
+{
+    event e;
+    e.name = name;
+    e.category = category;
+    e.phase = phase;
+    e.thread = 1;
+    e.detail = detail;
+#ifdef MAPNIK_THREADSAFE
+    boost::thread::id id = boost::this_thread::get_id();
+    boost::mutex::scoped_lock lock(mutex_);
+    // threads are numbered in the order of their first event.
+    std::vector<boost::thread::id>::const_iterator itr = std::find(threads_.begin(), threads_.end(), id);
+    e.thread = itr - threads_.begin() + 1;
+    if (itr == threads_.end())
+    {
+        threads_.push_back(id);
+    }
+#endif
+    e.timestamp = wall_clock_us() - start_;
+    events_.push_back(e);
+}
+
+std::size_t tracer::size() const
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+#endif
+    return events_.size();
+}
+
+void tracer::clear()
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+    threads_.clear();
+#endif
+    events_.clear();
+    start_ = wall_clock_us();
+}
+
+void tracer::write_json(std::ostream & out) const
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+#endif
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(0) << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < events_.size(); ++i)
+    {
+        event const& e = events_[i];
+        out << (i ? ",\n" : "\n") << "{\"name\":";
+        write_json_string(out, e.name);
+        out << ",\"cat\":";
+        write_json_string(out, e.category);
+        out << ",\"ph\":\"" << e.phase << "\",\"ts\":"
+            << e.timestamp
+            << ",\"pid\":1,\"tid\":" << e.thread;
+        if (!e.detail.empty())
+        {
+            out << ",\"args\":{\"name\":";
+            write_json_string(out, e.detail);
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+std::string tracer::to_json() const
+{
+    std::ostringstream out;
+    write_json(out);
+    return out.str();
+}
+}
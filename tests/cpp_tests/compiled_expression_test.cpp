@@ -0,0 +1,124 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mapnik/datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/expression_evaluator.hpp>
+#include <mapnik/compiled_expression.hpp>
+
+using namespace mapnik;
+
+//  --------------------------------------------------------------------------//
+
+// the compiled expression gives the value of the evaluator, of the same type.
+void check(std::string const& text, std::vector<feature_ptr> const& features)
+{
+  expression_ptr expr = parse_expression(text, "utf-8");
+  attribute_slots slots;
+  compiled_expression compiled(*expr, slots);
+  std::vector<value_type> values;
+  for (unsigned i = 0; i < features.size(); ++i)
+  {
+    slots.resolve(*features[i], values);
+    value_type result = compiled.evaluate(values);
+    value_type expected = boost::apply_visitor(evaluate<Feature,value_type>(*features[i]), *expr);
+    if (result.base().which() != expected.base().which() ||
+        result.to_expression_string() != expected.to_expression_string())
+    {
+      std::cerr << text << " on feature " << i << ": " << result.to_expression_string()
+                << " instead of " << expected.to_expression_string() << "\n";
+    }
+    BOOST_TEST( result.base().which() == expected.base().which() );
+    BOOST_TEST( result.to_expression_string() == expected.to_expression_string() );
+  }
+}
+
+std::size_t size(std::string const& text)
+{
+  attribute_slots slots;
+  return compiled_expression(*parse_expression(text, "utf-8"), slots).size();
+}
+
+int main( int, char*[] )
+{
+  transcoder tr("utf-8");
+  std::vector<feature_ptr> features;
+  for (int i = 0; i < 4; ++i)
+  {
+    feature_ptr feature(feature_factory::create(i));
+    (*feature)["int"] = i;
+    (*feature)["double"] = i * 1.5;
+    (*feature)["highway"] = tr.transcode(i % 2 ? "primary" : "residential");
+    if (i > 1)
+    {
+      (*feature)["name"] = tr.transcode("Main Street");
+    }
+    features.push_back(feature);
+  }
+
+//  compiled expressions evaluate as the expression tree does  ----------------//
+
+  char const* expressions[] = {
+    "[int] = 2",
+    "[int] != 2 and [double] >= 1.5",
+    "[highway] = 'primary' or [highway] = 'residential'",
+    "not ([int] < 2)",
+    "[int] + [double] * 2 - 1",
+    "[int] % 2 = 1",
+    "[double] / 3 > 0.4",
+    "[name] = ''",
+    "[name] <> '' and [int] > 2",
+    "[missing] or [int]",
+    "[int] and [highway]",
+    "[highway].match('pri.*')",
+    "[name].replace('Street','St')",
+    "[highway] = 'primary' and ([int] = 1 or [int] = 3) and not [name]",
+    "([int] = 1 or 1 = 1) and [highway]",
+    "1 = 2 or [int] = 0",
+    "1 = 1 and [int]",
+    "[int] > 1 and 2 + 3",
+    "'motor' + 'way'",
+    "[int] <= 1.5"
+  };
+  for (unsigned i = 0; i < sizeof(expressions) / sizeof(expressions[0]); ++i)
+  {
+    check(expressions[i], features);
+  }
+
+//  constant subexpressions are evaluated at compile time  --------------------//
+
+  BOOST_TEST( size("1 + 2 * 3 = 7") == 1 );
+  BOOST_TEST( size("'a'.match('a')") == 1 );
+  BOOST_TEST( size("[int] = 2 * 3") == 3 );
+  BOOST_TEST( size("1 = 2 and [int]") == 1 );
+  BOOST_TEST( size("1 = 1 or [int]") == 1 );
+  BOOST_TEST( size("1 = 1 and [int]") == 2 );
+  {
+    attribute_slots slots;
+    BOOST_TEST( compiled_expression(*parse_expression("2 > 1", "utf-8"), slots).is_constant() );
+    BOOST_TEST( !compiled_expression(*parse_expression("[int] > 1", "utf-8"), slots).is_constant() );
+  }
+
+//  attributes share their slots across expressions  --------------------------//
+
+  {
+    attribute_slots slots;
+    compiled_expression a(*parse_expression("[int] = 1 and [highway] = 'primary'", "utf-8"), slots);
+    compiled_expression b(*parse_expression("[highway] = 'residential' or [int] = [int]", "utf-8"), slots);
+    BOOST_TEST( slots.size() == 2 );
+    std::vector<value_type> values;
+    slots.resolve(*features[1], values);
+    BOOST_TEST( a.evaluate(values).to_bool() );
+    BOOST_TEST( b.evaluate(values).to_bool() );
+    slots.resolve(*features[2], values);
+    BOOST_TEST( !a.evaluate(values).to_bool() );
+    BOOST_TEST( b.evaluate(values).to_bool() );
+  }
+
+  return ::boost::report_errors();
+}
@@ -0,0 +1,153 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/feature_cache.hpp>
+#include <mapnik/feature_style_processor.hpp>
+
+using namespace mapnik;
+
+//  --------------------------------------------------------------------------//
+
+// memory datasource that counts its queries.
+class counting_datasource : public memory_datasource
+{
+public:
+    counting_datasource()
+        : queries(0) {}
+
+    featureset_ptr features(query const& q) const
+    {
+        ++queries;
+        return memory_datasource::features(q);
+    }
+
+    mutable int queries;
+};
+
+// processor that logs the features it processes, in order.
+struct logging_processor : public feature_style_processor<logging_processor>
+{
+    logging_processor(Map const& m)
+        : feature_style_processor<logging_processor>(m) {}
+
+    void start_map_processing(Map const&) {}
+    void end_map_processing(Map const&) {}
+    void start_layer_processing(layer const&) {}
+    void end_layer_processing(layer const&) {}
+
+    template <typename Symbolizer>
+    void process(Symbolizer const&, Feature const& feature, proj_transform const&)
+    {
+        log << " " << feature.id();
+    }
+
+    bool process(rule::symbolizers const&, Feature const&, proj_transform const&)
+    {
+        return false;
+    }
+
+    std::ostringstream log;
+};
+
+// feature with a line from (x0,y0) to (x1,y1).
+feature_ptr make_line(int id, double x0, double y0, double x1, double y1)
+{
+    feature_ptr feature(feature_factory::create(id));
+    geometry_type * line = new geometry_type(LineString);
+    line->move_to(x0, y0);
+    line->line_to(x1, y1);
+    feature->add_geometry(line);
+    return feature;
+}
+
+std::string read_ids(Featureset & features)
+{
+    std::ostringstream ids;
+    feature_ptr feature;
+    while ((feature = features.next()))
+    {
+        ids << " " << feature->id();
+    }
+    return ids.str();
+}
+
+int main( int, char*[] )
+{
+
+//  features are read if their bounding boxes intersect the query  ----------//
+
+  feature_cache cache;
+  cache.push(make_line(1, 0, 0, 10, 10));
+  cache.push(make_line(2, 20, 20, 30, 25));
+  cache.push(feature_ptr(feature_factory::create(3)));
+  feature_ptr two_lines = make_line(4, 50, 0, 60, 0);
+  geometry_type * other = new geometry_type(LineString);
+  other->move_to(0, 40);
+  other->line_to(5, 45);
+  two_lines->add_geometry(other);
+  cache.push(two_lines);
+
+  BOOST_TEST( cache.size() == 4 );
+  BOOST_TEST( cache.envelope() == box2d<double>(0, 0, 60, 45) );
+
+  feature_cache::reader all(cache, box2d<double>(-1, -1, 100, 100));
+  BOOST_TEST( read_ids(all) == " 1 2 3 4" );
+
+  feature_cache::reader first(cache, box2d<double>(5, 5, 15, 15));
+  BOOST_TEST( read_ids(first) == " 1 3 4" );
+
+  feature_cache::reader none(cache, box2d<double>(100, 100, 200, 200));
+  BOOST_TEST( read_ids(none) == " 3" );
+
+  feature_cache::reader empty;
+  BOOST_TEST( !empty.next() );
+
+  cache.clear();
+  BOOST_TEST( cache.size() == 0 );
+  feature_cache::reader cleared(cache, box2d<double>(-1, -1, 100, 100));
+  BOOST_TEST( !cleared.next() );
+
+//  styles after the first one read the cached features  --------------------//
+
+  Map m(256, 256);
+  for (int s = 0; s < 3; ++s)
+  {
+    feature_type_style style;
+    rule r;
+    r.append(line_symbolizer());
+    style.add_rule(r);
+    m.insert_style(s == 0 ? "a" : s == 1 ? "b" : "c", style);
+  }
+  boost::shared_ptr<counting_datasource> ds = boost::make_shared<counting_datasource>();
+  for (int i = 0; i < 20; ++i)
+  {
+    ds->push(make_line(i, i * 10, 0, i * 10 + 5, 5));
+  }
+  layer lyr("lines", m.srs());
+  lyr.set_datasource(ds);
+  lyr.add_style("a");
+  lyr.add_style("b");
+  lyr.add_style("c");
+  m.addLayer(lyr);
+  m.zoom_to_box(box2d<double>(-1, -1, 101, 6));
+
+  logging_processor uncached(m);
+  uncached.apply();
+  BOOST_TEST( ds->queries == 3 );
+
+  m.layers()[0].set_cache_features(true);
+  logging_processor cached(m);
+  cached.apply();
+  BOOST_TEST( ds->queries == 4 );
+  BOOST_TEST( cached.log.str() == uncached.log.str() );
+
+  return ::boost::report_errors();
+}
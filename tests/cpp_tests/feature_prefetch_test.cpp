@@ -0,0 +1,220 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/feature_style_processor.hpp>
+
+using namespace mapnik;
+
+//  --------------------------------------------------------------------------//
+
+// memory datasource that counts its queries, and fails on demand.
+class counting_datasource : public memory_datasource
+{
+public:
+    counting_datasource(bool fail = false)
+        : queries(0),
+          fail_(fail) {}
+
+    featureset_ptr features(query const& q) const
+    {
+        ++queries;
+        if (fail_)
+        {
+            throw datasource_exception("query failed");
+        }
+        return memory_datasource::features(q);
+    }
+
+    mutable boost::detail::atomic_count queries;
+
+private:
+    bool fail_;
+};
+
+// processor that logs the layers and the features it processes, in order.
+struct logging_processor : public feature_style_processor<logging_processor>
+{
+    logging_processor(Map const& m, counting_datasource const* next_ds = 0)
+        : feature_style_processor<logging_processor>(m),
+          next_ds_(next_ds),
+          next_ds_queried(false) {}
+
+    void start_map_processing(Map const&) {}
+    void end_map_processing(Map const&) {}
+
+    void start_layer_processing(layer const& lay)
+    {
+        log << lay.name() << ":";
+    }
+
+    void end_layer_processing(layer const& lay)
+    {
+        // wait a second at most for the next layer to be queried.
+        if (next_ds_ && lay.name() == "a")
+        {
+            for (int i = 0; i < 1000 && next_ds_->queries == 0; ++i)
+            {
+                usleep(1000);
+            }
+            next_ds_queried = next_ds_->queries != 0;
+        }
+        log << ";";
+    }
+
+    template <typename Symbolizer>
+    void process(Symbolizer const&, Feature const& feature, proj_transform const&)
+    {
+        log << " " << feature.id();
+    }
+
+    bool process(rule::symbolizers const&, Feature const&, proj_transform const&)
+    {
+        return false;
+    }
+
+    std::ostringstream log;
+    counting_datasource const* next_ds_;
+    bool next_ds_queried;
+};
+
+// layer of 'count' points, whose feature ids start at 'first_id'.
+boost::shared_ptr<counting_datasource> add_layer(Map & m, std::string const& name,
+                                                 int first_id, int count, bool fail = false)
+{
+    boost::shared_ptr<counting_datasource> ds = boost::make_shared<counting_datasource>(fail);
+    for (int i = 0; i < count; ++i)
+    {
+        feature_ptr feature(feature_factory::create(first_id + i));
+        geometry_type * point = new geometry_type(Point);
+        point->move_to(i % 100, i / 100);
+        feature->add_geometry(point);
+        ds->push(feature);
+    }
+    layer lyr(name, m.srs());
+    lyr.set_datasource(ds);
+    lyr.add_style("points");
+    m.addLayer(lyr);
+    return ds;
+}
+
+void add_style(Map & m)
+{
+    feature_type_style style;
+    rule r;
+    r.append(point_symbolizer());
+    style.add_rule(r);
+    m.insert_style("points", style);
+}
+
+int main( int, char*[] )
+{
+
+//  prefetching does not change what is processed, nor its order  ------------//
+
+  Map m(256, 256);
+  add_style(m);
+  add_layer(m, "a", 0, 50);
+  boost::shared_ptr<counting_datasource> b = add_layer(m, "b", 100, 300);
+  add_layer(m, "c", 1000, 20);
+  m.zoom_to_box(box2d<double>(-1, -1, 101, 4));
+
+  logging_processor sequential(m);
+  sequential.apply();
+  BOOST_TEST( b->queries == 1 );
+
+  // buffers of a few features, or of a few bytes (a feature at a time).
+  std::size_t const limits[][2] = { { 1, 1000000 }, { 7, 1000000 }, { 1000, 1 }, { 1000, 1000000 } };
+  for (unsigned i = 0; i < 4; ++i)
+  {
+    logging_processor prefetching(m);
+    prefetching.set_feature_prefetch(limits[i][0], limits[i][1]);
+    prefetching.apply();
+    BOOST_TEST( prefetching.log.str() == sequential.log.str() );
+  }
+  BOOST_TEST( b->queries == 5 );
+
+//  the next layer is queried while a layer is processed  ---------------------//
+
+#ifdef MAPNIK_THREADSAFE
+  {
+    logging_processor prefetching(m, b.get());
+    prefetching.set_feature_prefetch(16);
+    prefetching.apply();
+    BOOST_TEST( prefetching.next_ds_queried );
+    BOOST_TEST( prefetching.log.str() == sequential.log.str() );
+  }
+#endif
+
+//  styles after the first one query the datasource again  -----------------//
+
+  {
+    Map styled(256, 256);
+    add_style(styled);
+    feature_type_style second;
+    rule r;
+    r.append(point_symbolizer());
+    second.add_rule(r);
+    styled.insert_style("more points", second);
+    // only the layers after the first one are read ahead.
+    add_layer(styled, "a", 0, 3);
+    boost::shared_ptr<counting_datasource> d = add_layer(styled, "b", 10, 2);
+    styled.layers()[1].add_style("more points");
+    styled.zoom_to_box(box2d<double>(-1, -1, 101, 4));
+
+    logging_processor sequential_styles(styled);
+    sequential_styles.apply();
+    BOOST_TEST( sequential_styles.log.str() == "a: 0 1 2;b: 10 11 10 11;" );
+
+    logging_processor prefetching_styles(styled);
+    prefetching_styles.set_feature_prefetch(16);
+    prefetching_styles.apply();
+    BOOST_TEST( prefetching_styles.log.str() == sequential_styles.log.str() );
+    BOOST_TEST( d->queries == 4 );
+  }
+
+//  errors of the datasources read ahead are thrown where they are processed  //
+
+  Map failing(256, 256);
+  add_style(failing);
+  add_layer(failing, "a", 0, 10);
+  add_layer(failing, "b", 100, 10, true);
+  failing.zoom_to_box(box2d<double>(-1, -1, 101, 4));
+
+  std::string sequential_error;
+  logging_processor sequential_failing(failing);
+  try
+  {
+    sequential_failing.apply();
+  }
+  catch (std::exception const& ex)
+  {
+    sequential_error = ex.what();
+  }
+
+  std::string prefetching_error;
+  logging_processor prefetching_failing(failing);
+  prefetching_failing.set_feature_prefetch(16);
+  try
+  {
+    prefetching_failing.apply();
+  }
+  catch (std::exception const& ex)
+  {
+    prefetching_error = ex.what();
+  }
+  BOOST_TEST( sequential_error == "query failed" );
+  BOOST_TEST( prefetching_error == sequential_error );
+  BOOST_TEST( prefetching_failing.log.str() == sequential_failing.log.str() );
+
+  return ::boost::report_errors();
+}
@@ -0,0 +1,193 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/metatile.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/unicode.hpp>
+
+using namespace mapnik;
+
+//  --------------------------------------------------------------------------//
+
+void add_rectangle(memory_datasource & ds, int id, double x0, double y0, double x1, double y1)
+{
+    feature_ptr feature(feature_factory::create(id));
+    geometry_type * polygon = new geometry_type(Polygon);
+    polygon->move_to(x0, y0);
+    polygon->line_to(x1, y0);
+    polygon->line_to(x1, y1);
+    polygon->line_to(x0, y1);
+    polygon->line_to(x0, y0);
+    feature->add_geometry(polygon);
+    ds.push(feature);
+}
+
+unsigned pixel(metatile::tile_type const& tile, unsigned x, unsigned y)
+{
+    return tile.getRow(y)[x];
+}
+
+int main( int, char*[] )
+{
+  unsigned const red = color(255, 0, 0).rgba();
+  unsigned const white = color(255, 255, 255).rgba();
+
+  // a map of one unit per pixel, with a rectangle across the seam of its two
+  // columns, and one in its buffer.
+  Map m(512, 256);
+  m.set_background(color(255, 255, 255));
+  m.set_buffer_size(16);
+  feature_type_style style;
+  rule r;
+  r.append(polygon_symbolizer(color(255, 0, 0)));
+  style.add_rule(r);
+  m.insert_style("polygons", style);
+  boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+  add_rectangle(*ds, 1, 200, 100, 300, 150);
+  add_rectangle(*ds, 2, -12, 100, -4, 150);
+  layer lyr("polygons", m.srs());
+  lyr.set_datasource(ds);
+  lyr.add_style("polygons");
+  m.addLayer(lyr);
+  m.zoom_to_box(box2d<double>(0, 0, 512, 256));
+
+//  tiles are views of the image, inside its margin  --------------------------//
+
+  metatile meta(m, 2, 1);
+  BOOST_TEST( meta.margin() == 16 );
+  BOOST_TEST( meta.image().width() == 544 );
+  BOOST_TEST( meta.image().height() == 288 );
+
+  metatile::tile_type const right = meta.tile(1, 0);
+  BOOST_TEST( right.x() == 16 + 256 );
+  BOOST_TEST( right.y() == 16 );
+  BOOST_TEST( right.width() == 256 );
+  BOOST_TEST( right.height() == 256 );
+  BOOST_TEST( &right.data() == &meta.image().data() );
+
+  // the last column and row take the remaining pixels.
+  Map odd(515, 256);
+  metatile uneven(odd, 2, 3);
+  BOOST_TEST( uneven.tile(0, 0).width() == 257 );
+  BOOST_TEST( uneven.tile(1, 0).width() == 258 );
+  BOOST_TEST( uneven.tile(0, 1).height() == 85 );
+  BOOST_TEST( uneven.tile(0, 2).height() == 86 );
+  BOOST_TEST( uneven.tile(0, 2).y() == 170 );
+
+  // there are no tiles past the last column and row.
+  unsigned out_of_range = 0;
+  try
+  {
+    uneven.tile(2, 0);
+  }
+  catch (std::out_of_range const&)
+  {
+    ++out_of_range;
+  }
+  try
+  {
+    uneven.encode(0, 3, "png");
+  }
+  catch (std::out_of_range const&)
+  {
+    ++out_of_range;
+  }
+  BOOST_TEST( out_of_range == 2 );
+
+//  features are drawn across the seams, and into the margin  ----------------//
+
+  meta.render();
+  metatile::tile_type const left = meta.tile(0, 0);
+  BOOST_TEST( pixel(left, 250, 130) == red );
+  BOOST_TEST( pixel(left, 100, 130) == white );
+  BOOST_TEST( pixel(right, 30, 130) == red );
+  BOOST_TEST( pixel(right, 60, 130) == white );
+  BOOST_TEST( pixel(left, 0, 130) == white );
+  BOOST_TEST( meta.image().data()(16 - 8, 16 + 130) == red );
+
+  // rendering again starts from a blank image.
+  m.set_background(color(0, 0, 255));
+  meta.render();
+  BOOST_TEST( pixel(left, 100, 130) == color(0, 0, 255).rgba() );
+  BOOST_TEST( pixel(left, 250, 130) == red );
+
+//  tiles are encoded independently  -----------------------------------------//
+
+  std::string png = meta.encode(1, 0, "png");
+  BOOST_TEST( png.size() > 8 && png.substr(1, 3) == "PNG" );
+  tracer t;
+  BOOST_TEST( meta.encode(0, 0, "png", &t).substr(1, 3) == "PNG" );
+  BOOST_TEST( t.size() == 2 );
+
+//  labels are placed as if the map were rendered in one image  --------------//
+
+  // a label across the seam, and one along a line that runs into the buffer.
+  freetype_engine::register_font("fonts/dejavu-fonts-ttf-2.30/ttf/DejaVuSans.ttf");
+  transcoder tr("utf-8");
+  Map labels(512, 256);
+  labels.set_background(color(255, 255, 255));
+  labels.set_buffer_size(32);
+  feature_type_style label_style;
+  rule label_rule;
+  text_symbolizer text(parse_expression("[name]"), "DejaVu Sans Book", 16, color(0, 0, 0));
+  label_rule.append(text);
+  text.set_label_placement(LINE_PLACEMENT);
+  label_rule.append(text);
+  label_style.add_rule(label_rule);
+  labels.insert_style("labels", label_style);
+  boost::shared_ptr<memory_datasource> names = boost::make_shared<memory_datasource>();
+  feature_ptr point_feature(feature_factory::create(1));
+  geometry_type * point = new geometry_type(Point);
+  point->move_to(256, 64);
+  point_feature->add_geometry(point);
+  (*point_feature)["name"] = tr.transcode("Seam Street");
+  names->push(point_feature);
+  feature_ptr line_feature(feature_factory::create(2));
+  geometry_type * line = new geometry_type(LineString);
+  line->move_to(410, 192);
+  line->line_to(540, 192);
+  line_feature->add_geometry(line);
+  (*line_feature)["name"] = tr.transcode("Edge Road");
+  names->push(line_feature);
+  layer label_layer("labels", labels.srs());
+  label_layer.set_datasource(names);
+  label_layer.add_style("labels");
+  labels.addLayer(label_layer);
+  labels.zoom_to_box(box2d<double>(0, 0, 512, 256));
+
+  image_32 whole(512, 256);
+  agg_renderer<image_32> ren(labels, whole);
+  ren.apply();
+
+  metatile label_meta(labels, 2, 1);
+  label_meta.render();
+  unsigned differences = 0;
+  unsigned black = 0;
+  for (unsigned column = 0; column < 2; ++column)
+  {
+    metatile::tile_type const tile = label_meta.tile(column, 0);
+    for (unsigned y = 0; y < tile.height(); ++y)
+    {
+      for (unsigned x = 0; x < tile.width(); ++x)
+      {
+        unsigned expected = whole.data()(column * 256 + x, y);
+        if (pixel(tile, x, y) != expected) ++differences;
+        if (expected != white) ++black;
+      }
+    }
+  }
+  BOOST_TEST( black > 0 );
+  BOOST_TEST( differences == 0 );
+
+  return ::boost::report_errors();
+}
@@ -0,0 +1,167 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <string>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/feature_style_processor.hpp>
+
+using namespace mapnik;
+
+//  --------------------------------------------------------------------------//
+
+// processor that processes nothing.
+struct null_processor : public feature_style_processor<null_processor>
+{
+    explicit null_processor(Map const& m)
+        : feature_style_processor<null_processor>(m) {}
+
+    void start_map_processing(Map const&) {}
+    void end_map_processing(Map const&) {}
+    void start_layer_processing(layer const&) {}
+    void end_layer_processing(layer const&) {}
+
+    template <typename Symbolizer>
+    void process(Symbolizer const&, Feature const&, proj_transform const&) {}
+
+    bool process(rule::symbolizers const&, Feature const&, proj_transform const&)
+    {
+        return false;
+    }
+};
+
+// processor that processes the symbolizers of a rule at once, as svg_renderer does.
+struct grouping_processor : public feature_style_processor<grouping_processor>
+{
+    explicit grouping_processor(Map const& m)
+        : feature_style_processor<grouping_processor>(m) {}
+
+    void start_map_processing(Map const&) {}
+    void end_map_processing(Map const&) {}
+    void start_layer_processing(layer const&) {}
+    void end_layer_processing(layer const&) {}
+
+    template <typename Symbolizer>
+    void process(Symbolizer const&, Feature const&, proj_transform const&) {}
+
+    bool process(rule::symbolizers const&, Feature const&, proj_transform const&)
+    {
+        return true;
+    }
+};
+
+int main( int, char*[] )
+{
+  transcoder tr("utf-8");
+
+  // "roads" has three lines of two vertices, two of them primary roads.
+  Map m(256, 256);
+  boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+  for (int i = 0; i < 3; ++i)
+  {
+    feature_ptr feature(feature_factory::create(i));
+    geometry_type * line = new geometry_type(LineString);
+    line->move_to(0, i);
+    line->line_to(10, i);
+    feature->add_geometry(line);
+    (*feature)["highway"] = tr.transcode(i < 2 ? "primary" : "track");
+    ds->push(feature);
+  }
+  layer lyr("\"roads\"", m.srs());
+  lyr.set_datasource(ds);
+  lyr.add_style("casing");
+  lyr.add_style("roads");
+  m.addLayer(lyr);
+
+  feature_type_style casing;
+  rule all("all");
+  all.append(line_symbolizer());
+  casing.add_rule(all);
+  m.insert_style("casing", casing);
+
+  feature_type_style roads;
+  rule primary("primary");
+  primary.set_filter(parse_expression("[highway] = 'primary'", "utf-8"));
+  primary.append(line_symbolizer());
+  primary.append(text_symbolizer(parse_expression("[highway]"), "DejaVu Sans Book", 10, color(0, 0, 0)));
+  roads.add_rule(primary);
+  rule other("other");
+  other.set_else(true);
+  other.append(line_symbolizer());
+  roads.add_rule(other);
+  m.insert_style("roads", roads);
+  m.zoom_to_box(box2d<double>(-1, -1, 11, 3));
+
+//  stats are not collected by default  ---------------------------------------//
+
+  null_processor processor(m);
+  BOOST_TEST( processor.get_render_stats() == 0 );
+  processor.apply();
+
+//  layers, rules and symbolizers are counted  --------------------------------//
+
+  render_stats stats;
+  processor.set_render_stats(&stats);
+  processor.apply();
+
+  BOOST_TEST( stats.layers.size() == 1 );
+  layer_stats const& roads_stats = stats.layers[0];
+  BOOST_TEST( roads_stats.name == "\"roads\"" );
+  BOOST_TEST( roads_stats.features_fetched == 6 );
+  BOOST_TEST( roads_stats.features_matched == 6 );
+  BOOST_TEST( roads_stats.rules.size() == 3 );
+  BOOST_TEST( roads_stats.rules[0].style == "casing" && roads_stats.rules[0].name == "all" );
+  BOOST_TEST( roads_stats.rules[0].features == 3 );
+  BOOST_TEST( roads_stats.rules[1].style == "roads" && roads_stats.rules[1].name == "primary" );
+  BOOST_TEST( roads_stats.rules[1].features == 2 );
+  BOOST_TEST( roads_stats.rules[2].name == "other" );
+  BOOST_TEST( roads_stats.rules[2].features == 1 );
+  BOOST_TEST( roads_stats.time >= roads_stats.query_time );
+  BOOST_TEST( stats.time >= roads_stats.time );
+
+  symbolizer line = line_symbolizer();
+  symbolizer text = text_symbolizer(parse_expression("[highway]"), "DejaVu Sans Book", 10, color(0, 0, 0));
+  BOOST_TEST( stats.symbolizer_type(line).type == "line" );
+  BOOST_TEST( stats.symbolizer_type(line).calls == 6 );
+  BOOST_TEST( stats.symbolizer_type(line).vertices == 12 );
+  BOOST_TEST( stats.symbolizer_type(text).type == "text" );
+  BOOST_TEST( stats.symbolizer_type(text).calls == 2 );
+
+//  symbolizers processed at once are counted too  ----------------------------//
+
+#ifdef SVG_RENDERER
+  {
+    render_stats grouped_stats;
+    grouping_processor grouping(m);
+    grouping.set_render_stats(&grouped_stats);
+    grouping.apply();
+    BOOST_TEST( grouped_stats.layers[0].rules[1].features == 2 );
+    BOOST_TEST( grouped_stats.symbolizer_type(line).calls == 6 );
+    BOOST_TEST( grouped_stats.symbolizer_type(line).vertices == 12 );
+    BOOST_TEST( grouped_stats.symbolizer_type(text).calls == 2 );
+  }
+#endif
+
+//  stats are those of the last render, and can be written as JSON  -----------//
+
+  processor.apply();
+  BOOST_TEST( stats.layers.size() == 1 );
+  BOOST_TEST( stats.symbolizer_type(line).calls == 6 );
+
+  std::string json = stats.to_json();
+  BOOST_TEST( json.find("{\"time\":") == 0 );
+  BOOST_TEST( json.find("\"layers\":[{\"name\":\"\\\"roads\\\"\",\"time\":") != std::string::npos );
+  BOOST_TEST( json.find(",\"features_fetched\":6,\"features_matched\":6,\"rules\":[{\"style\":\"casing\",\"name\":\"all\",\"features\":3,\"time\":") != std::string::npos );
+  BOOST_TEST( json.find("\"symbolizers\":{\"line\":{\"calls\":6,\"time\":") != std::string::npos );
+  BOOST_TEST( json.find(",\"vertices\":12}") != std::string::npos );
+  BOOST_TEST( json.find("\"text\":{\"calls\":2,") != std::string::npos );
+  BOOST_TEST( json.find("\"point\"") == std::string::npos );
+
+  return ::boost::report_errors();
+}
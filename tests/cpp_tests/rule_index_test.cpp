@@ -0,0 +1,131 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mapnik/datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/expression_evaluator.hpp>
+#include <mapnik/rule_index.hpp>
+
+using namespace mapnik;
+
+//  --------------------------------------------------------------------------//
+
+std::vector<expression_ptr> parse(char const* texts[], unsigned count)
+{
+  std::vector<expression_ptr> filters;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    filters.push_back(parse_expression(texts[i], "utf-8"));
+  }
+  return filters;
+}
+
+// the filters that match a feature, evaluated one by one.
+std::vector<unsigned> evaluated(std::vector<expression_ptr> const& filters, Feature const& feature)
+{
+  std::vector<unsigned> matches;
+  for (unsigned i = 0; i < filters.size(); ++i)
+  {
+    if (boost::apply_visitor(evaluate<Feature,value_type>(feature), *filters[i]).to_bool())
+    {
+      matches.push_back(i);
+    }
+  }
+  return matches;
+}
+
+// the filters that match a feature, looked up in the index.
+std::vector<unsigned> indexed(rule_index & index, Feature const& feature)
+{
+  std::vector<unsigned> matches;
+  index.resolve(feature);
+  for (unsigned i = 0; i < index.candidates().size(); ++i)
+  {
+    if (index.match(index.candidates()[i]))
+    {
+      matches.push_back(index.candidates()[i]);
+    }
+  }
+  return matches;
+}
+
+feature_ptr create_feature(int id, value_type const& highway, bool named)
+{
+  transcoder tr("utf-8");
+  feature_ptr feature(feature_factory::create(id));
+  (*feature)["highway"] = highway;
+  if (named)
+  {
+    (*feature)["name"] = tr.transcode("Main Street");
+  }
+  (*feature)["bridge"] = tr.transcode(id % 2 ? "yes" : "no");
+  return feature;
+}
+
+int main( int, char*[] )
+{
+  transcoder tr("utf-8");
+
+//  indexed filters match the features the filters do, in order  -------------//
+
+  char const* texts[] = {
+    "[highway] = 'motorway'",
+    "[highway] = 'primary' and [bridge] = 'yes'",
+    "[railway] = 'rail'",
+    "[highway] = 'primary'",
+    "'residential' = [highway] and [name] <> ''",
+    "[bridge] = 'yes' and [highway] = 'residential' and [name] = ''",
+    "[highway] = 1",
+    "[highway] = 'motorway' or [highway] = 'trunk'",
+    "[highway] = 'primary' and [highway] = 'secondary'",
+    "true"
+  };
+  std::vector<expression_ptr> filters = parse(texts, sizeof(texts) / sizeof(texts[0]));
+  rule_index index(filters);
+  BOOST_TEST( index.key() == "highway" );
+
+  std::vector<feature_ptr> features;
+  char const* highways[] = { "motorway", "primary", "residential", "trunk", "footway" };
+  for (unsigned i = 0; i < 5; ++i)
+  {
+    features.push_back(create_feature(2 * i, tr.transcode(highways[i]), true));
+    features.push_back(create_feature(2 * i + 1, tr.transcode(highways[i]), false));
+  }
+  features.push_back(create_feature(10, 1, false));
+  features.push_back(create_feature(11, 1.0, false));
+  features.push_back(create_feature(12, value_type(), false));
+  features.push_back(create_feature(13, true, false));
+
+  for (unsigned i = 0; i < features.size(); ++i)
+  {
+    std::vector<unsigned> matches = indexed(index, *features[i]);
+    BOOST_TEST( matches == evaluated(filters, *features[i]) );
+    std::vector<unsigned> candidates = index.candidates();
+    BOOST_TEST( candidates.size() < filters.size() );
+  }
+
+//  unkeyed filters only are the candidates of features with other values  ----//
+
+  index.resolve(*features[8]);
+  unsigned unkeyed[] = { 2, 7, 9 };
+  BOOST_TEST( index.candidates() == std::vector<unsigned>(unkeyed, unkeyed + 3) );
+  index.resolve(*features[4]);
+  unsigned residential[] = { 2, 4, 5, 7, 9 };
+  BOOST_TEST( index.candidates() == std::vector<unsigned>(residential, residential + 5) );
+
+//  filters are not indexed by attributes fewer than two of them test  --------//
+
+  char const* single[] = { "[highway] = 'primary'", "[railway] = 'rail'", "[name] <> ''" };
+  rule_index unindexed(parse(single, 3));
+  BOOST_TEST( unindexed.key().empty() );
+  unindexed.resolve(*features[2]);
+  BOOST_TEST( unindexed.candidates().size() == 3 );
+  BOOST_TEST( indexed(unindexed, *features[2]) == evaluated(parse(single, 3), *features[2]) );
+
+  return ::boost::report_errors();
+}
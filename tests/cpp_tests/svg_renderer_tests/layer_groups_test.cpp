@@ -0,0 +1,201 @@
+#define BOOST_TEST_MODULE layer_groups_test
+
+/*
+ * This test module contains test cases that verify
+ * how svg_renderer writes each layer in its own group,
+ * with the path attributes shared by the layer's rules.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <string>
+
+// test utilities
+#include "occurrences.hpp"
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * The fixture map maps a 256x256 extent onto a 256x256 image. Its
+ * "lines" layer has two horizontal lines, its "points" layer a point.
+ */
+struct F : map_fixture
+{
+    F()
+    {
+	boost::shared_ptr<memory_datasource> lines = boost::make_shared<memory_datasource>();
+	for(int i = 0; i < 2; ++i)
+	{
+	    feature_ptr feature(feature_factory::create(i));
+	    geometry_type* line = new geometry_type(LineString);
+	    line->move_to(0, 100 + i * 50);
+	    line->line_to(256, 100 + i * 50);
+	    feature->add_geometry(line);
+	    lines->push(feature);
+	}
+	add_layer("lines", lines);
+
+	boost::shared_ptr<memory_datasource> points = boost::make_shared<memory_datasource>();
+	feature_ptr feature(feature_factory::create(2));
+	geometry_type* point = new geometry_type(Point);
+	point->move_to(128, 128);
+	feature->add_geometry(point);
+	points->push(feature);
+	add_layer("points", points);
+
+	map.insert_style("lines", feature_type_style());
+	map.insert_style("points", feature_type_style());
+	map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+    }
+
+    ~F() {}
+
+    std::string render(bool layer_groups = true)
+    {
+	buffer_rendering rendering(map);
+	rendering.renderer.set_layer_groups(layer_groups);
+	return rendering.apply();
+    }
+};
+
+/*
+ * Layers are not grouped by default. When they are, each layer has
+ * a group, even if it has no feature to draw.
+ */
+BOOST_FIXTURE_TEST_CASE(layer_group_test_case, F)
+{
+    std::string output = render(false);
+    BOOST_CHECK_EQUAL(occurrences(output, "<g "), 0u);
+
+    output = render();
+    BOOST_CHECK_EQUAL(occurrences(output, "<g id=\"layer-0-lines\" data-name=\"lines\">\n</g>\n"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<g id=\"layer-1-points\" data-name=\"points\">\n</g>\n"), 1u);
+    BOOST_CHECK(output.find("<g id=\"layer-0-lines\"") < output.find("<g id=\"layer-1-points\""));
+}
+
+/*
+ * The attributes of a layer whose paths all have the same attributes
+ * are written on its group, and not on its paths.
+ */
+BOOST_FIXTURE_TEST_CASE(hoisted_attributes_test_case, F)
+{
+    feature_type_style style;
+    mapnik::rule r;
+    r.append(line_symbolizer(stroke(color(255, 0, 0), 2.0)));
+    style.add_rule(r);
+    insert_style("lines", style);
+
+    std::string output = render();
+
+    std::string::size_type group = output.find("<g id=\"layer-0-lines\" data-name=\"lines\" ");
+    BOOST_REQUIRE(group != std::string::npos);
+    std::string group_tag = output.substr(group, output.find('>', group) - group);
+    BOOST_CHECK_EQUAL(occurrences(group_tag, " stroke=\"#ff0000\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(group_tag, " stroke-width=\"2.0px\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<path "), 2u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<path d=\"M0 156 L256 156\"/>\n"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<path d=\"M0 106 L256 106\"/>\n"), 1u);
+    BOOST_CHECK(group < output.find("<path "));
+    BOOST_CHECK(output.find("<path ") < output.find("</g>"));
+}
+
+/*
+ * Only the attributes that all the rules share are written on the group;
+ * the paths keep the others.
+ */
+BOOST_FIXTURE_TEST_CASE(shared_attributes_test_case, F)
+{
+    feature_type_style style;
+    mapnik::rule casing;
+    casing.append(line_symbolizer(stroke(color(0, 0, 0), 4.0)));
+    style.add_rule(casing);
+    mapnik::rule inline_rule;
+    inline_rule.append(line_symbolizer(stroke(color(255, 255, 255), 2.0)));
+    style.add_rule(inline_rule);
+    insert_style("lines", style);
+
+    std::string output = render();
+
+    std::string::size_type group = output.find("<g id=\"layer-0-lines\" data-name=\"lines\" ");
+    BOOST_REQUIRE(group != std::string::npos);
+    std::string group_tag = output.substr(group, output.find('>', group) - group);
+    BOOST_CHECK_EQUAL(occurrences(group_tag, " fill=\"none\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(group_tag, " stroke="), 0u);
+    BOOST_CHECK_EQUAL(occurrences(group_tag, " stroke-width="), 0u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<path "), 4u);
+    BOOST_CHECK_EQUAL(occurrences(output, "\" stroke=\"#000000\" "), 2u);
+    BOOST_CHECK_EQUAL(occurrences(output, "\" stroke=\"#ffffff\" "), 2u);
+    BOOST_CHECK_EQUAL(occurrences(output, " fill=\"none\""), 1u);
+}
+
+/*
+ * Attributes are not hoisted in layers that draw markers, which would inherit them.
+ */
+BOOST_FIXTURE_TEST_CASE(marker_layer_test_case, F)
+{
+    feature_type_style style;
+    mapnik::rule r;
+    r.append(polygon_symbolizer(color(0, 0, 255)));
+    r.append(point_symbolizer());
+    style.add_rule(r);
+    insert_style("points", style);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<g id=\"layer-1-points\" data-name=\"points\">\n"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use "), 1u);
+}
+
+/*
+ * Layer names are escaped, reduced to valid characters in ids, and layers
+ * outside of the map's extent are grouped too.
+ */
+BOOST_FIXTURE_TEST_CASE(layer_name_test_case, F)
+{
+    boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+    feature_ptr feature(feature_factory::create(3));
+    geometry_type* line = new geometry_type(LineString);
+    line->move_to(1000, 1000);
+    line->line_to(2000, 2000);
+    feature->add_geometry(line);
+    ds->push(feature);
+    layer lyr("roads & \"paths\"", map.srs());
+    lyr.set_datasource(ds);
+    lyr.add_style("lines");
+    map.addLayer(lyr);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<g id=\"layer-2-roads____paths_\" data-name=\"roads &amp; &quot;paths&quot;\">\n</g>\n"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<g "), occurrences(output, "</g>"));
+}
+
+/*
+ * Group ids stay unique when layers share a name, and do not take the ids
+ * of symbols.
+ */
+BOOST_FIXTURE_TEST_CASE(layer_id_test_case, F)
+{
+    add_layer("lines", boost::make_shared<memory_datasource>());
+    add_layer("m0", boost::make_shared<memory_datasource>());
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<g id=\"layer-0-lines\" data-name=\"lines\">"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<g id=\"layer-2-lines\" data-name=\"lines\">"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<g id=\"layer-3-m0\" data-name=\"m0\">"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "id=\"m0\""), 0u);
+}
@@ -0,0 +1,82 @@
+#ifndef SVG_RENDERER_TESTS_MAP_FIXTURE_HPP
+#define SVG_RENDERER_TESTS_MAP_FIXTURE_HPP
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// stl
+#include <string>
+
+/*
+ * An svg_renderer of 'map' (or of a window of it) that writes into an
+ * output buffer. The renderer can be set up before apply() renders the
+ * map and returns the document.
+ */
+struct buffer_rendering
+{
+    explicit buffer_rendering(mapnik::Map const& map, unsigned offset_x = 0, unsigned offset_y = 0,
+			      unsigned width = 0, unsigned height = 0)
+	: output_iterator(buffer),
+	  renderer(map, output_iterator, offset_x, offset_y, width, height)
+    {}
+
+    std::string apply()
+    {
+	renderer.apply();
+	return buffer.str();
+    }
+
+    mapnik::svg::output_buffer buffer;
+    mapnik::svg::output_buffer_iterator output_iterator;
+    mapnik::svg_renderer<mapnik::svg::output_buffer_iterator> renderer;
+};
+
+/*
+ * Base of the fixtures that render a 256x256 map, each layer of
+ * which is drawn by the style of the same name.
+ */
+struct map_fixture
+{
+    map_fixture() : map(256, 256) {}
+
+    void add_layer(std::string const& name, mapnik::datasource_ptr ds)
+    {
+	mapnik::layer lyr(name, map.srs());
+	lyr.set_datasource(ds);
+	lyr.add_style(name);
+	map.addLayer(lyr);
+    }
+
+    /*
+     * Insert 'style' as the style 'name', replacing the previous one.
+     */
+    void insert_style(std::string const& name, mapnik::feature_type_style const& style)
+    {
+	map.remove_style(name);
+	map.insert_style(name, style);
+    }
+
+    /*
+     * Insert a style with a single rule, that applies 'sym' to all the features.
+     */
+    void insert_style(std::string const& name, mapnik::symbolizer const& sym)
+    {
+	mapnik::feature_type_style style;
+	mapnik::rule r;
+	r.append(sym);
+	style.add_rule(r);
+	insert_style(name, style);
+    }
+
+    std::string render()
+    {
+	buffer_rendering rendering(map);
+	return rendering.apply();
+    }
+
+    mapnik::Map map;
+};
+
+#endif // SVG_RENDERER_TESTS_MAP_FIXTURE_HPP
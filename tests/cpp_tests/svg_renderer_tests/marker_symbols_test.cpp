@@ -0,0 +1,200 @@
+#define BOOST_TEST_MODULE marker_symbols_test
+
+/*
+ * This test module contains test cases that verify
+ * how svg_renderer writes point and marker symbolizers:
+ * each distinct marker once, as a symbol, and each of
+ * its placements as a use tag.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/parse_path.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <string>
+
+// test utilities
+#include "occurrences.hpp"
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * The fixture map maps a 256x256 extent onto a 256x256 image. Its
+ * "points" layer has three points, its "lines" layer a diagonal line.
+ */
+struct F : map_fixture
+{
+    F()
+    {
+	boost::shared_ptr<memory_datasource> points = boost::make_shared<memory_datasource>();
+	for(int i = 0; i < 3; ++i)
+	{
+	    feature_ptr feature(feature_factory::create(i));
+	    geometry_type* point = new geometry_type(Point);
+	    point->move_to(50 + i * 50, 56);
+	    feature->add_geometry(point);
+	    points->push(feature);
+	}
+	add_layer("points", points);
+
+	boost::shared_ptr<memory_datasource> lines = boost::make_shared<memory_datasource>();
+	feature_ptr feature(feature_factory::create(3));
+	geometry_type* line = new geometry_type(LineString);
+	line->move_to(0, 0);
+	line->line_to(256, 256);
+	feature->add_geometry(line);
+	lines->push(feature);
+	add_layer("lines", lines);
+
+	map.insert_style("points", feature_type_style());
+	map.insert_style("lines", feature_type_style());
+	map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+    }
+
+    ~F() {}
+};
+
+/*
+ * The default marker of point symbolizers (a 4x4 black square)
+ * is written once, and placed at each point.
+ */
+BOOST_FIXTURE_TEST_CASE(default_point_marker_test_case, F)
+{
+    point_symbolizer sym;
+    sym.set_allow_overlap(true);
+    insert_style("points", sym);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "xmlns:xlink=\"http://www.w3.org/1999/xlink\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<symbol "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<symbol id=\"m0\" overflow=\"visible\">\n"
+			    "<rect x=\"-2\" y=\"-2\" width=\"4\" height=\"4\" fill=\"#000000\"/>\n"
+			    "</symbol>"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use "), 3u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use xlink:href=\"#m0\" x=\"50\" y=\"200\"/>"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use xlink:href=\"#m0\" x=\"150\" y=\"200\"/>"), 1u);
+
+    // the symbol is defined before it is used.
+    BOOST_CHECK(output.find("<symbol ") < output.find("<use "));
+}
+
+/*
+ * Vector markers are written as paths, moved to be centered on
+ * the origin of the symbol. Placements that collide are skipped.
+ */
+BOOST_FIXTURE_TEST_CASE(vector_point_marker_test_case, F)
+{
+    path_ptr marker_path(new svg_storage_type);
+    vertex_stl_adapter<svg_path_storage> stl_storage(marker_path->source());
+    svg_path_adapter svg_path(stl_storage);
+    svg_path.move_to(0, 0);
+    svg_path.line_to(60, 0);
+    svg_path.line_to(60, 10);
+    svg_path.line_to(0, 10);
+    svg_path.close_polygon();
+    svg::path_attributes attributes;
+    attributes.fill_color = agg::rgba8(255, 0, 0);
+    marker_path->attributes().add(attributes);
+    marker_path->set_bounding_box(0, 0, 60, 10);
+    marker_cache::insert("marker_symbols_test.svg", boost::make_shared<marker>(boost::optional<path_ptr>(marker_path)));
+
+    point_symbolizer sym(parse_path("marker_symbols_test.svg"));
+    sym.set_opacity(0.5);
+    insert_style("points", sym);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<symbol "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<path d=\"M0 0 L60 0 L60 10 L0 10 Z\" fill=\"#ff0000\" fill-opacity=\"1.0\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "transform=\"matrix(1 0 0 1 -30 -5)\"/>\n</symbol>"), 1u);
+    // the second point is too close to the first one.
+    BOOST_CHECK_EQUAL(occurrences(output, "<use "), 2u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use xlink:href=\"#m0\" x=\"50\" y=\"200\" opacity=\"0.5\"/>"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use xlink:href=\"#m0\" x=\"150\" y=\"200\" opacity=\"0.5\"/>"), 1u);
+}
+
+/*
+ * Bitmap markers are embedded once in their symbol, as a PNG
+ * data URI: the output does not refer to the marker's file.
+ */
+BOOST_FIXTURE_TEST_CASE(bitmap_point_marker_test_case, F)
+{
+    image_ptr bitmap(new image_data_32(8, 6));
+    bitmap->set(0xff00ff00);
+    marker_cache::insert("marker_symbols_test&bitmap.png", boost::make_shared<marker>(boost::optional<image_ptr>(bitmap)));
+
+    point_symbolizer sym(parse_path("marker_symbols_test&bitmap.png"));
+    sym.set_allow_overlap(true);
+    insert_style("points", sym);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<symbol "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<image x=\"-4\" y=\"-3\" width=\"8\" height=\"6\""
+			    " xlink:href=\"data:image/png;base64,iVBORw0KGgo"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "\"/>\n</symbol>"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "marker_symbols_test"), 0u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use xlink:href=\"#m0\" "), 3u);
+}
+
+/*
+ * Markers placed along lines are rotated (and transformed)
+ * by the matrix of their use tags.
+ */
+BOOST_FIXTURE_TEST_CASE(line_markers_test_case, F)
+{
+    markers_symbolizer sym;
+    sym.set_marker_placement(MARKER_LINE_PLACEMENT);
+    sym.set_marker_type(ARROW);
+    sym.set_spacing(50);
+    insert_style("lines", sym);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<symbol "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<path d=\"M-7 1 L1 1 L1 3 L7 0 L1 -3 L1 -1 L-7 -1\" fill=\"#0000ff\""), 1u);
+    BOOST_CHECK(occurrences(output, "<use xlink:href=\"#m0\" transform=\"matrix(") > 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use "), occurrences(output, "<use xlink:href=\"#m0\" transform=\"matrix("));
+
+    // the line itself is not drawn.
+    BOOST_CHECK_EQUAL(occurrences(output, "<path "), 1u);
+}
+
+/*
+ * The path of a rule is written before its markers, whatever the order
+ * of its symbolizers, so that the line does not cover the markers.
+ */
+BOOST_FIXTURE_TEST_CASE(markers_over_path_test_case, F)
+{
+    markers_symbolizer markers;
+    markers.set_marker_placement(MARKER_LINE_PLACEMENT);
+    markers.set_marker_type(ARROW);
+    markers.set_spacing(50);
+
+    feature_type_style style;
+    mapnik::rule r;
+    r.append(markers);
+    r.append(line_symbolizer(color(255, 0, 0)));
+    style.add_rule(r);
+    insert_style("lines", style);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "stroke=\"#ff0000\""), 1u);
+    BOOST_CHECK(occurrences(output, "<use ") > 1u);
+    BOOST_CHECK(output.find("stroke=\"#ff0000\"") < output.find("<use "));
+}
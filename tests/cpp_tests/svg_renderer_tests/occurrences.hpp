@@ -0,0 +1,20 @@
+#ifndef SVG_RENDERER_TESTS_OCCURRENCES_HPP
+#define SVG_RENDERER_TESTS_OCCURRENCES_HPP
+
+// stl
+#include <string>
+
+/*
+ * Count the (non-overlapping) occurrences of 'text' in 'output'.
+ */
+inline unsigned occurrences(std::string const& output, std::string const& text)
+{
+    unsigned found = 0;
+    for(std::string::size_type pos = output.find(text); pos != std::string::npos; pos = output.find(text, pos + text.size()))
+    {
+	++found;
+    }
+    return found;
+}
+
+#endif // SVG_RENDERER_TESTS_OCCURRENCES_HPP
@@ -0,0 +1,170 @@
+/*
+ * This benchmark compares the throughput of svg_renderer when
+ * generating into a std::ostream_iterator<char> (one virtual
+ * stream call per character) and into an svg::output_buffer,
+ * both in memory and drained to a file descriptor in chunks,
+ * uncompressed and compressed on the fly (svgz).
+ *
+ * usage: output_buffer_benchmark [features] [vertices] [iterations] [compression level]
+ */
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/svg_renderer.hpp>
+#include <mapnik/color_factory.hpp>
+#include <mapnik/wall_clock_timer.hpp>
+
+// boost
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+// stl
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+using namespace mapnik;
+
+/*
+ * Build a map with a single layer of random polylines
+ * stroked with a line symbolizer.
+ */
+void prepare_map(Map& m, unsigned num_features, unsigned num_vertices)
+{
+    feature_type_style lines_style;
+    rule lines_rule;
+    stroke lines_stroke(color(171, 158, 137), 2.0);
+    lines_stroke.set_line_cap(ROUND_CAP);
+    lines_stroke.set_line_join(ROUND_JOIN);
+    lines_rule.append(line_symbolizer(lines_stroke));
+    lines_style.add_rule(lines_rule);
+    m.insert_style("lines", lines_style);
+
+    boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+    std::srand(1);
+    for(unsigned i = 0; i < num_features; ++i)
+    {
+	feature_ptr feature(feature_factory::create(i));
+	geometry_type* line = new geometry_type(LineString);
+	double x = std::rand() % 1000;
+	double y = std::rand() % 1000;
+	line->move_to(x, y);
+	for(unsigned j = 1; j < num_vertices; ++j)
+	{
+	    x += (std::rand() % 2001 - 1000) / 100.0;
+	    y += (std::rand() % 2001 - 1000) / 100.0;
+	    line->line_to(x, y);
+	}
+	feature->add_geometry(line);
+	ds->push(feature);
+    }
+
+    layer lyr("lines", m.srs());
+    lyr.set_datasource(ds);
+    lyr.add_style("lines");
+    m.addLayer(lyr);
+    m.zoom_all();
+}
+
+void report(std::string const& name, double elapsed, std::size_t bytes, unsigned iterations)
+{
+    std::clog << name << ": " << elapsed / iterations << " ms/render, "
+	      << (bytes / (1024.0 * 1024.0)) / (elapsed / 1000.0) << " MB/s ("
+	      << bytes / iterations << " bytes/render)\n";
+}
+
+int main(int argc, char** argv)
+{
+    unsigned num_features = argc > 1 ? boost::lexical_cast<unsigned>(argv[1]) : 10000;
+    unsigned num_vertices = argc > 2 ? boost::lexical_cast<unsigned>(argv[2]) : 50;
+    unsigned iterations = argc > 3 ? boost::lexical_cast<unsigned>(argv[3]) : 10;
+    int compression_level = argc > 4 ? boost::lexical_cast<int>(argv[4]) : svg::gzip_output_buffer::DEFAULT_COMPRESSION;
+
+    Map m(1024, 1024);
+    m.set_background(color_factory::from_string("white"));
+    prepare_map(m, num_features, num_vertices);
+
+    std::clog << num_features << " features, " << num_vertices << " vertices per feature, "
+	      << iterations << " iterations\n";
+
+    // std::ostream_iterator<char> into a stringstream.
+    {
+	std::size_t bytes = 0;
+	wall_clock_timer timer;
+	for(unsigned i = 0; i < iterations; ++i)
+	{
+	    std::ostringstream output_stream;
+	    std::ostream_iterator<char> output_stream_iterator(output_stream);
+	    svg_renderer<std::ostream_iterator<char> > renderer(m, output_stream_iterator);
+	    renderer.apply();
+	    bytes += output_stream.str().size();
+	}
+	report("ostream_iterator", timer.elapsed(), bytes, iterations);
+    }
+
+    // svg::output_buffer_iterator into a growable memory buffer.
+    {
+	std::size_t bytes = 0;
+	svg::output_buffer buffer;
+	wall_clock_timer timer;
+	for(unsigned i = 0; i < iterations; ++i)
+	{
+	    buffer.clear();
+	    svg::output_buffer_iterator output_buffer_iterator(buffer);
+	    svg_renderer<svg::output_buffer_iterator> renderer(m, output_buffer_iterator);
+	    renderer.apply();
+	    bytes += buffer.size();
+	}
+	report("output_buffer", timer.elapsed(), bytes, iterations);
+    }
+
+    // svg::output_buffer_iterator into a file descriptor, drained in chunks.
+    {
+	std::FILE* file = std::fopen("/dev/null", "wb");
+	if(file)
+	{
+	    svg::fd_output_buffer buffer(fileno(file));
+	    wall_clock_timer timer;
+	    for(unsigned i = 0; i < iterations; ++i)
+	    {
+		svg::output_buffer_iterator output_buffer_iterator(buffer);
+		svg_renderer<svg::output_buffer_iterator> renderer(m, output_buffer_iterator);
+		renderer.apply();
+		buffer.flush();
+	    }
+	    report("fd_output_buffer", timer.elapsed(), buffer.bytes_written(), iterations);
+	    std::fclose(file);
+	}
+    }
+
+    // svg::output_buffer_iterator into a gzip buffer, drained to a file descriptor.
+    {
+	std::FILE* file = std::fopen("/dev/null", "wb");
+	if(file)
+	{
+	    svg::fd_output_buffer buffer(fileno(file));
+	    std::size_t bytes = 0;
+	    wall_clock_timer timer;
+	    for(unsigned i = 0; i < iterations; ++i)
+	    {
+		svg::gzip_output_buffer gzip_buffer(buffer, compression_level);
+		svg::output_buffer_iterator output_buffer_iterator(gzip_buffer);
+		svg_renderer<svg::output_buffer_iterator> renderer(m, output_buffer_iterator);
+		renderer.apply();
+		gzip_buffer.finish();
+		bytes += gzip_buffer.bytes_in();
+	    }
+	    buffer.flush();
+	    report("gzip_output_buffer", timer.elapsed(), bytes, iterations);
+	    std::clog << "  compressed to " << buffer.bytes_written() / iterations << " bytes/render\n";
+	    std::fclose(file);
+	}
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+#define BOOST_TEST_MODULE output_buffer_test
+
+/*
+ * This test module contains test cases that
+ * verify the buffered output destinations
+ * used by svg_renderer.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// boost.spirit
+#include <boost/spirit/include/karma.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/svg_renderer.hpp>
+#include <mapnik/color_factory.hpp>
+
+// zlib
+#include <zlib.h>
+
+// stl
+#include <cstdio>
+#include <sstream>
+#include <iterator>
+#include <string>
+
+namespace karma = boost::spirit::karma;
+using namespace mapnik;
+
+/*
+ * The buffer starts with the requested capacity
+ * and doubles it whenever it runs out of space, so
+ * every character put into it is kept, in order.
+ */
+BOOST_AUTO_TEST_CASE(output_buffer_growth_test_case)
+{
+    svg::output_buffer buffer(4);
+    std::string expected_output;
+
+    for(unsigned i = 0; i < 100; ++i)
+    {
+	char c = 'a' + (i % 26);
+	buffer.put(c);
+	expected_output += c;
+    }
+    buffer.write("0123456789", 10);
+    expected_output += "0123456789";
+
+    BOOST_CHECK_EQUAL(buffer.size(), expected_output.size());
+    BOOST_CHECK(buffer.capacity() >= buffer.size());
+    BOOST_CHECK_EQUAL(buffer.str(), expected_output);
+
+    buffer.clear();
+    BOOST_CHECK_EQUAL(buffer.size(), 0u);
+}
+
+/*
+ * Karma generators write through output_buffer_iterator
+ * exactly as they do through a stream iterator.
+ */
+BOOST_AUTO_TEST_CASE(output_buffer_iterator_test_case)
+{
+    using karma::int_;
+    using karma::lit;
+
+    svg::output_buffer buffer(8);
+    svg::output_buffer_iterator output_iterator(buffer);
+
+    std::ostringstream output_stream;
+    std::ostream_iterator<char> output_stream_iterator(output_stream);
+
+    karma::generate(output_iterator, lit("<rect x=\"") << int_ << lit("\"/>"), 12345);
+    karma::generate(output_stream_iterator, lit("<rect x=\"") << int_ << lit("\"/>"), 12345);
+
+    BOOST_CHECK_EQUAL(buffer.str(), output_stream.str());
+}
+
+/*
+ * The file descriptor buffer writes its content in chunks
+ * of (at most) its capacity, plus whatever remains on flush.
+ */
+BOOST_AUTO_TEST_CASE(fd_output_buffer_test_case)
+{
+    std::FILE* file = std::tmpfile();
+    BOOST_REQUIRE(file);
+
+    std::string expected_output;
+    {
+	svg::fd_output_buffer buffer(fileno(file), 16);
+	for(unsigned i = 0; i < 1000; ++i)
+	{
+	    char c = '0' + (i % 10);
+	    buffer.put(c);
+	    expected_output += c;
+	}
+	BOOST_CHECK(buffer.size() <= 16);
+	buffer.flush();
+	BOOST_CHECK_EQUAL(buffer.size(), 0u);
+	BOOST_CHECK_EQUAL(buffer.bytes_written(), expected_output.size());
+    }
+
+    std::string actual_output;
+    std::rewind(file);
+    int c;
+    while((c = std::fgetc(file)) != EOF)
+    {
+	actual_output += static_cast<char>(c);
+    }
+    std::fclose(file);
+
+    BOOST_CHECK_EQUAL(actual_output, expected_output);
+}
+
+/*
+ * Decompress a gzip stream.
+ */
+std::string gunzip(std::string const& compressed)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = compressed.size();
+    inflateInit2(&stream, 15 + 16);
+
+    std::string output;
+    char chunk[256];
+    int result;
+    do
+    {
+	stream.next_out = reinterpret_cast<Bytef*>(chunk);
+	stream.avail_out = sizeof(chunk);
+	result = inflate(&stream, Z_NO_FLUSH);
+	output.append(chunk, sizeof(chunk) - stream.avail_out);
+    }
+    while(result == Z_OK);
+    inflateEnd(&stream);
+
+    BOOST_CHECK_EQUAL(result, Z_STREAM_END);
+    return output;
+}
+
+/*
+ * The gzip buffer compresses its content, chunk by chunk,
+ * into a valid gzip stream.
+ */
+BOOST_AUTO_TEST_CASE(gzip_output_buffer_test_case)
+{
+    svg::output_buffer compressed_buffer;
+    std::string expected_output;
+    {
+	svg::gzip_output_buffer buffer(compressed_buffer, 9, 64);
+	for(unsigned i = 0; i < 10000; ++i)
+	{
+	    char c = '0' + (i % 10);
+	    buffer.put(c);
+	    expected_output += c;
+	}
+	buffer.finish();
+	BOOST_CHECK_EQUAL(buffer.bytes_in(), expected_output.size());
+    }
+
+    std::string compressed_output = compressed_buffer.str();
+    BOOST_REQUIRE(compressed_output.size() > 2);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(compressed_output[0]), 0x1f);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(compressed_output[1]), 0x8b);
+    BOOST_CHECK(compressed_output.size() < expected_output.size());
+    BOOST_CHECK_EQUAL(gunzip(compressed_output), expected_output);
+}
+
+/*
+ * svg_renderer generates the same document into an output
+ * buffer as it does into a stream.
+ */
+BOOST_AUTO_TEST_CASE(output_buffer_renderer_test_case)
+{
+    Map map(800, 600);
+    map.set_background(color_factory::from_string("white"));
+
+    std::ostringstream output_stream;
+    std::ostream_iterator<char> output_stream_iterator(output_stream);
+    svg_renderer<std::ostream_iterator<char> > stream_renderer(map, output_stream_iterator);
+    stream_renderer.apply();
+
+    svg::output_buffer buffer;
+    svg::output_buffer_iterator output_buffer_iterator(buffer);
+    svg_renderer<svg::output_buffer_iterator> buffer_renderer(map, output_buffer_iterator);
+    buffer_renderer.apply();
+
+    BOOST_CHECK_EQUAL(buffer.str(), output_stream.str());
+}
+
+/*
+ * svg_renderer output compressed on the fly decompresses
+ * to the same document as the uncompressed output.
+ */
+BOOST_AUTO_TEST_CASE(gzip_output_buffer_renderer_test_case)
+{
+    Map map(800, 600);
+    map.set_background(color_factory::from_string("white"));
+
+    svg::output_buffer buffer;
+    svg::output_buffer_iterator output_buffer_iterator(buffer);
+    svg_renderer<svg::output_buffer_iterator> buffer_renderer(map, output_buffer_iterator);
+    buffer_renderer.apply();
+
+    svg::output_buffer compressed_buffer;
+    svg::gzip_output_buffer gzip_buffer(compressed_buffer);
+    svg::output_buffer_iterator gzip_buffer_iterator(gzip_buffer);
+    svg_renderer<svg::output_buffer_iterator> gzip_renderer(map, gzip_buffer_iterator);
+    gzip_renderer.apply();
+    gzip_buffer.finish();
+
+    BOOST_CHECK_EQUAL(gunzip(compressed_buffer.str()), buffer.str());
+}
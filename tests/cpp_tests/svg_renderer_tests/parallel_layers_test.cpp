@@ -0,0 +1,247 @@
+#define BOOST_TEST_MODULE parallel_layers_test
+
+/*
+ * This test module contains test cases that verify
+ * that svg_renderer writes the same document whether
+ * it renders the layers of a map in turn or in parallel.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/metawriter.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+// stl
+#include <stdexcept>
+#include <string>
+
+// test utilities
+#include "occurrences.hpp"
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * Datasource that throws something that is not a std::exception.
+ */
+struct throwing_datasource : public memory_datasource
+{
+    featureset_ptr features(query const&) const
+    {
+	throw 42;
+    }
+
+    box2d<double> envelope() const
+    {
+	return box2d<double>(0, 0, 256, 256);
+    }
+};
+
+/*
+ * Metawriter that counts the times it is started and stopped.
+ */
+struct counting_metawriter : public metawriter
+{
+    counting_metawriter() : metawriter(metawriter_properties()), started(0), stopped(0) {}
+
+    void add_box(box2d<double> const&, Feature const&, CoordTransform const&, metawriter_properties const&) {}
+    void add_text(placement const&, face_set_ptr, Feature const&, CoordTransform const&, metawriter_properties const&) {}
+    void add_polygon(path_type&, Feature const&, CoordTransform const&, metawriter_properties const&) {}
+    void add_line(path_type&, Feature const&, CoordTransform const&, metawriter_properties const&) {}
+    void set_map_srs(projection const&) {}
+
+    void start(metawriter_property_map const&)
+    {
+	++started;
+    }
+
+    void stop()
+    {
+	++stopped;
+    }
+
+    unsigned started;
+    unsigned stopped;
+};
+
+/*
+ * The fixture map maps a 256x256 extent onto a 256x256 image. It has
+ * eight layers of five lines each, drawn with a different color by layer.
+ */
+struct F : map_fixture
+{
+    F()
+    {
+	for(int i = 0; i < 8; ++i)
+	{
+	    std::string name = "layer" + boost::lexical_cast<std::string>(i);
+	    boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+	    for(int j = 0; j < 5; ++j)
+	    {
+		feature_ptr feature(feature_factory::create(i * 5 + j));
+		geometry_type* line = new geometry_type(LineString);
+		line->move_to(i * 30 + j, 0);
+		line->line_to(j * 50, 256 - i * 30);
+		feature->add_geometry(line);
+		ds->push(feature);
+	    }
+
+	    add_layer(name, ds);
+	    insert_style(name, line_symbolizer(color(i * 30, 0, 255 - i * 30)));
+	}
+	map.set_background(color(255, 255, 255));
+	map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+    }
+
+    ~F() {}
+
+    std::string render(unsigned layer_threads, bool path_batching = false, render_stats* stats = 0,
+		       bool style_classes = false)
+    {
+	buffer_rendering rendering(map);
+	rendering.renderer.set_layer_threads(layer_threads);
+	rendering.renderer.set_path_batching(path_batching);
+	rendering.renderer.set_style_classes(style_classes);
+	rendering.renderer.set_render_stats(stats);
+	return rendering.apply();
+    }
+};
+
+/*
+ * The layers rendered in parallel are written in their order in the
+ * map, exactly as they are when rendered in turn.
+ */
+BOOST_FIXTURE_TEST_CASE(same_output_test_case, F)
+{
+    std::string serial_output = render(1);
+
+    BOOST_CHECK_EQUAL(occurrences(serial_output, "<path "), 40u);
+    BOOST_CHECK_EQUAL(render(2), serial_output);
+    BOOST_CHECK_EQUAL(render(4), serial_output);
+    // more threads than layers.
+    BOOST_CHECK_EQUAL(render(16), serial_output);
+}
+
+/*
+ * Paths are not batched across layers, whether they are rendered in parallel or not.
+ */
+BOOST_FIXTURE_TEST_CASE(path_batching_test_case, F)
+{
+    std::string serial_output = render(1, true);
+
+    BOOST_CHECK_EQUAL(occurrences(serial_output, "<path "), 8u);
+    BOOST_CHECK_EQUAL(render(4, true), serial_output);
+}
+
+/*
+ * The style sheet is written before the layers rendered in parallel,
+ * whose paths refer to its classes.
+ */
+BOOST_FIXTURE_TEST_CASE(style_classes_test_case, F)
+{
+    std::string serial_output = render(1, false, 0, true);
+
+    BOOST_CHECK_EQUAL(occurrences(serial_output, "<style "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(serial_output, " class=\"s"), 40u);
+    BOOST_CHECK_EQUAL(render(4, false, 0, true), serial_output);
+}
+
+/*
+ * Layers that are not visible at the map's scale are not rendered.
+ */
+BOOST_FIXTURE_TEST_CASE(invisible_layer_test_case, F)
+{
+    map.layers()[3].setMaxZoom(1.0);
+
+    std::string serial_output = render(1);
+
+    BOOST_CHECK_EQUAL(occurrences(serial_output, "<path "), 35u);
+    BOOST_CHECK_EQUAL(render(4), serial_output);
+}
+
+/*
+ * Layers rendered in parallel write their own symbols, with ids that are
+ * unique in the document, and their markers do not avoid each other.
+ */
+BOOST_FIXTURE_TEST_CASE(marker_symbols_test_case, F)
+{
+    for(int i = 0; i < 2; ++i)
+    {
+	std::string name = "layer" + boost::lexical_cast<std::string>(i);
+	point_symbolizer sym;
+	feature_type_style style;
+	mapnik::rule r;
+	r.append(sym);
+	style.add_rule(r);
+	map.remove_style(name);
+	map.insert_style(name, style);
+    }
+
+    std::string serial_output = render(1);
+    std::string parallel_output = render(4);
+
+    BOOST_CHECK_EQUAL(occurrences(serial_output, "<symbol "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(parallel_output, "<symbol "), 2u);
+    BOOST_CHECK_EQUAL(occurrences(parallel_output, "<symbol id=\"m0_0\" "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(parallel_output, "<symbol id=\"m1_0\" "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(parallel_output, "<use xlink:href=\"#m0_0\""), occurrences(parallel_output, "<use xlink:href=\"#m1_0\""));
+    BOOST_CHECK_EQUAL(occurrences(parallel_output, "<path "), 30u);
+}
+
+/*
+ * The render stats of the layers rendered in parallel are merged in
+ * layer order.
+ */
+BOOST_FIXTURE_TEST_CASE(render_stats_test_case, F)
+{
+    render_stats serial_stats;
+    render(1, false, &serial_stats);
+    render_stats parallel_stats;
+    render(4, false, &parallel_stats);
+
+    BOOST_REQUIRE_EQUAL(parallel_stats.layers.size(), 8u);
+    for(unsigned i = 0; i < 8; ++i)
+    {
+	BOOST_CHECK_EQUAL(parallel_stats.layers[i].name, serial_stats.layers[i].name);
+	BOOST_CHECK_EQUAL(parallel_stats.layers[i].features_fetched, 5u);
+	BOOST_CHECK_EQUAL(parallel_stats.layers[i].rules[0].features, 5u);
+    }
+    symbolizer line = line_symbolizer();
+    BOOST_CHECK_EQUAL(parallel_stats.symbolizer_type(line).calls, 40u);
+    BOOST_CHECK_EQUAL(parallel_stats.symbolizer_type(line).vertices, 80u);
+    BOOST_CHECK_EQUAL(serial_stats.symbolizer_type(line).calls, 40u);
+    BOOST_CHECK(parallel_stats.time >= parallel_stats.layers[0].time);
+}
+
+/*
+ * Errors in the layer threads, whatever their type, are thrown
+ * by apply() once the threads are done, and the metawriters are
+ * stopped. Nothing is written then.
+ */
+BOOST_FIXTURE_TEST_CASE(layer_error_test_case, F)
+{
+    layer lyr("broken", map.srs());
+    lyr.set_datasource(boost::make_shared<throwing_datasource>());
+    lyr.add_style("layer0");
+    map.addLayer(lyr);
+    boost::shared_ptr<counting_metawriter> writer = boost::make_shared<counting_metawriter>();
+    map.insert_metawriter("counter", writer);
+
+    buffer_rendering rendering(map);
+    rendering.renderer.set_layer_threads(4);
+    BOOST_CHECK_THROW(rendering.apply(), std::runtime_error);
+
+    BOOST_CHECK_EQUAL(rendering.buffer.size(), 0u);
+    BOOST_CHECK_EQUAL(writer->started, 1u);
+    BOOST_CHECK_EQUAL(writer->stopped, 1u);
+}
@@ -0,0 +1,238 @@
+#define BOOST_TEST_MODULE path_data_test
+
+/*
+ * This test module contains test cases that verify
+ * the path data (the 'd' attribute of path elements)
+ * written by svg_generator.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/geometry.hpp>
+#include <mapnik/ctrans.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/svg/svg_generator.hpp>
+#include <mapnik/svg/svg_output_buffer.hpp>
+
+// stl
+#include <string>
+
+using namespace mapnik;
+
+/*
+ * The fixture maps a 256x256 extent onto a 256x256 image,
+ * so a vertex (x, y) is written as (x, 256 - y).
+ */
+struct F
+{
+    typedef svg::svg_generator<svg::output_buffer_iterator> generator_type;
+
+    F() :
+	t(256, 256, box2d<double>(0, 0, 256, 256)),
+	proj("+proj=latlong +datum=WGS84"),
+	prj_trans(proj, proj),
+	geom(LineString),
+	output_iterator(buffer),
+	generator(output_iterator)
+    {
+	geom.move_to(0, 256);
+	geom.line_to(10.12345, 250.5);
+	geom.line_to(10.1236, 250.4999);
+	geom.line_to(100, 56);
+    }
+
+    ~F() {}
+
+    /*
+     * Generate the path element of 'geometry' and return its 'd'
+     * attribute (or an empty string if no path element was generated).
+     */
+    std::string generate_path_data(geometry_type const& geometry)
+    {
+	buffer.clear();
+	coord_transform2<CoordTransform, geometry_type> path(t, geometry, prj_trans);
+	generator.generate_path(path, svg::path_output_attributes());
+
+	std::string output = buffer.str();
+	if(output.empty())
+	{
+	    return output;
+	}
+	std::string::size_type begin = output.find("d=\"") + 3;
+	return output.substr(begin, output.find('"', begin) - begin);
+    }
+
+    /*
+     * Generate the path element of the fixture's line string with
+     * the given precision and commands, and return its 'd' attribute.
+     */
+    std::string generate_path_data(unsigned precision,
+				   svg::path_commands_e commands = svg::ABSOLUTE_PATH_COMMANDS)
+    {
+	generator.set_coordinate_precision(precision);
+	generator.set_path_commands(commands);
+	return generate_path_data(geom);
+    }
+
+    /*
+     * Generate the path element of 'geometry', clipped to a 50x50
+     * rectangle, and return its 'd' attribute.
+     */
+    std::string generate_clipped_path_data(geometry_type const& geometry)
+    {
+	generator.set_clip_box(box2d<double>(0, 0, 50, 50));
+	generator.set_clipping(true);
+	return generate_path_data(geometry);
+    }
+
+    CoordTransform t;
+    projection proj;
+    proj_transform prj_trans;
+    geometry_type geom;
+    svg::output_buffer buffer;
+    svg::output_buffer_iterator output_iterator;
+    generator_type generator;
+};
+
+/*
+ * The default precision writes up to three fractional digits,
+ * without trailing zeros or exponents.
+ */
+BOOST_FIXTURE_TEST_CASE(default_precision_test_case, F)
+{
+    BOOST_CHECK_EQUAL(generate_path_data(3), "M0 0 L10.123 5.5 L10.124 5.5 L100 200");
+}
+
+/*
+ * Vertices that are snapped to the same coordinates
+ * as the previous vertex are not written.
+ */
+BOOST_FIXTURE_TEST_CASE(reduced_precision_test_case, F)
+{
+    BOOST_CHECK_EQUAL(generate_path_data(2), "M0 0 L10.12 5.5 L100 200");
+}
+
+/*
+ * A precision of 0 snaps vertices to integral pixels.
+ */
+BOOST_FIXTURE_TEST_CASE(pixel_snapping_test_case, F)
+{
+    BOOST_CHECK_EQUAL(generate_path_data(0), "M0 0 L10 6 L100 200");
+}
+
+/*
+ * Relative commands write every vertex but the first one as a
+ * delta from the previous vertex, omitting repeated commands.
+ */
+BOOST_FIXTURE_TEST_CASE(relative_commands_test_case, F)
+{
+    BOOST_CHECK_EQUAL(generate_path_data(3, svg::RELATIVE_PATH_COMMANDS),
+		      "M0 0l10.123 5.5 0.001 0 89.876 194.5");
+    BOOST_CHECK_EQUAL(generate_path_data(0, svg::RELATIVE_PATH_COMMANDS),
+		      "M0 0l10 6 90 194");
+}
+
+/*
+ * The shortest mode chooses absolute or relative coordinates for each
+ * vertex, whichever is shorter, and writes the implied command on ties.
+ */
+BOOST_FIXTURE_TEST_CASE(shortest_commands_test_case, F)
+{
+    BOOST_CHECK_EQUAL(generate_path_data(3, svg::SHORTEST_PATH_COMMANDS),
+		      "M0 0 10.123 5.5l0.001 0L100 200");
+}
+
+/*
+ * Move-to commands are never implied: each sub-path starts with one,
+ * and the line-tos that follow it are implied by it.
+ */
+BOOST_FIXTURE_TEST_CASE(relative_move_to_test_case, F)
+{
+    geom.move_to(110, 246);
+    geom.line_to(120, 236);
+    BOOST_CHECK_EQUAL(generate_path_data(0, svg::RELATIVE_PATH_COMMANDS),
+		      "M0 0l10 6 90 194m10 -190 10 10");
+}
+
+/*
+ * Clipped line strings keep the parts that are inside the clipping
+ * rectangle, ending where they cross its edges.
+ */
+BOOST_FIXTURE_TEST_CASE(line_clipping_test_case, F)
+{
+    geometry_type line(LineString);
+    line.move_to(-10, 226);
+    line.line_to(40, 226);
+    line.line_to(40, 156);
+    line.line_to(60, 226);
+    line.line_to(20, 246);
+    BOOST_CHECK_EQUAL(generate_clipped_path_data(line), "M0 30 L40 30 L40 50 M50 25 L20 10");
+}
+
+/*
+ * Clipped polygon rings stay closed: they run along the edges
+ * of the clipping rectangle and end at their first vertex.
+ */
+BOOST_FIXTURE_TEST_CASE(polygon_clipping_test_case, F)
+{
+    geometry_type polygon(Polygon);
+    polygon.move_to(-10, 266);
+    polygon.line_to(20, 266);
+    polygon.line_to(20, 236);
+    polygon.line_to(-10, 236);
+    polygon.line_to(-10, 266);
+    BOOST_CHECK_EQUAL(generate_clipped_path_data(polygon), "M0 0 L20 0 L20 20 L0 20 L0 0");
+}
+
+/*
+ * No path element is generated for geometries outside of the clipping rectangle.
+ */
+BOOST_FIXTURE_TEST_CASE(outside_clipping_test_case, F)
+{
+    geometry_type line(LineString);
+    line.move_to(100, 100);
+    line.line_to(200, 200);
+    BOOST_CHECK_EQUAL(generate_clipped_path_data(line), "");
+}
+
+/*
+ * Vertices closer than the tolerance to the last kept vertex are
+ * dropped, but the last vertex of each sub-path is always kept.
+ */
+BOOST_FIXTURE_TEST_CASE(distance_simplification_test_case, F)
+{
+    geometry_type line(LineString);
+    line.move_to(0, 256);
+    line.line_to(0.5, 256);
+    line.line_to(1, 255.5);
+    line.line_to(3, 256);
+    line.line_to(3.5, 256);
+    line.move_to(10, 256);
+    line.line_to(10.5, 256);
+
+    generator.set_simplify_tolerance(1.5);
+    BOOST_CHECK_EQUAL(generate_path_data(line), "M0 0 L3 0 L3.5 0 M10 0 L10.5 0");
+}
+
+/*
+ * Douglas-Peucker simplification also drops the vertices that are
+ * closer than the tolerance to the line through the kept ones.
+ */
+BOOST_FIXTURE_TEST_CASE(douglas_peucker_simplification_test_case, F)
+{
+    geometry_type line(LineString);
+    line.move_to(0, 256);
+    line.line_to(10, 255);
+    line.line_to(20, 256.5);
+    line.line_to(30, 246);
+    line.line_to(40, 256);
+
+    generator.set_simplify_tolerance(2);
+    BOOST_CHECK_EQUAL(generate_path_data(line), "M0 0 L10 1 L20 -0.5 L30 10 L40 0");
+
+    generator.set_douglas_peucker(true);
+    BOOST_CHECK_EQUAL(generate_path_data(line), "M0 0 L20 -0.5 L30 10 L40 0");
+}
@@ -0,0 +1,112 @@
+/*
+ * This benchmark compares the throughput of svg_generator when
+ * writing path data with the Karma grammars (karma_path_emitter)
+ * and with the hand-written fast_path_emitter, for each kind of
+ * path commands. Both write the same bytes, into an svg::output_buffer.
+ *
+ * usage: path_emitter_benchmark [paths] [vertices] [iterations] [precision]
+ */
+
+// mapnik
+#include <mapnik/geometry.hpp>
+#include <mapnik/ctrans.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/svg/svg_generator.hpp>
+#include <mapnik/svg/svg_output_buffer.hpp>
+#include <mapnik/wall_clock_timer.hpp>
+
+// boost
+#include <boost/lexical_cast.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+// stl
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace mapnik;
+
+/*
+ * Build random polylines within a 1000x1000 extent.
+ */
+void prepare_geometries(boost::ptr_vector<geometry_type>& geometries, unsigned num_paths, unsigned num_vertices)
+{
+    std::srand(1);
+    for(unsigned i = 0; i < num_paths; ++i)
+    {
+	geometry_type* line = new geometry_type(LineString);
+	double x = std::rand() % 1000;
+	double y = std::rand() % 1000;
+	line->move_to(x, y);
+	for(unsigned j = 1; j < num_vertices; ++j)
+	{
+	    x += (std::rand() % 2001 - 1000) / 100.0;
+	    y += (std::rand() % 2001 - 1000) / 100.0;
+	    line->line_to(x, y);
+	}
+	geometries.push_back(line);
+    }
+}
+
+void report(std::string const& name, double elapsed, std::size_t bytes, unsigned iterations)
+{
+    std::clog << name << ": " << elapsed / iterations << " ms/iteration, "
+	      << (bytes / (1024.0 * 1024.0)) / (elapsed / 1000.0) << " MB/s ("
+	      << bytes / iterations << " bytes/iteration)\n";
+}
+
+/*
+ * Generate a path tag for each geometry, 'iterations' times.
+ */
+template <typename PathEmitter>
+void run(std::string const& name, boost::ptr_vector<geometry_type> const& geometries,
+	 unsigned iterations, unsigned precision, svg::path_commands_e commands)
+{
+    CoordTransform t(1024, 1024, box2d<double>(0, 0, 1000, 1000));
+    projection proj("+proj=latlong +datum=WGS84");
+    proj_transform prj_trans(proj, proj);
+    svg::path_output_attributes attributes;
+
+    svg::output_buffer buffer;
+    svg::output_buffer_iterator output_buffer_iterator(buffer);
+    svg::svg_generator<svg::output_buffer_iterator, PathEmitter> generator(output_buffer_iterator);
+    generator.set_coordinate_precision(precision);
+    generator.set_path_commands(commands);
+    std::string attributes_fragment = generator.generate_path_attributes(attributes);
+
+    std::size_t bytes = 0;
+    wall_clock_timer timer;
+    for(unsigned i = 0; i < iterations; ++i)
+    {
+	buffer.clear();
+	for(unsigned j = 0; j < geometries.size(); ++j)
+	{
+	    coord_transform2<CoordTransform, geometry_type> path(t, geometries[j], prj_trans);
+	    generator.generate_path(path, attributes_fragment);
+	}
+	bytes += buffer.size();
+    }
+    report(name, timer.elapsed(), bytes, iterations);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned num_paths = argc > 1 ? boost::lexical_cast<unsigned>(argv[1]) : 10000;
+    unsigned num_vertices = argc > 2 ? boost::lexical_cast<unsigned>(argv[2]) : 50;
+    unsigned iterations = argc > 3 ? boost::lexical_cast<unsigned>(argv[3]) : 10;
+    unsigned precision = argc > 4 ? boost::lexical_cast<unsigned>(argv[4]) : 3;
+
+    boost::ptr_vector<geometry_type> geometries;
+    prepare_geometries(geometries, num_paths, num_vertices);
+
+    std::clog << num_paths << " paths, " << num_vertices << " vertices per path, "
+	      << iterations << " iterations, precision " << precision << "\n";
+
+    run<svg::karma_path_emitter>("karma, absolute", geometries, iterations, precision, svg::ABSOLUTE_PATH_COMMANDS);
+    run<svg::fast_path_emitter>("fast, absolute", geometries, iterations, precision, svg::ABSOLUTE_PATH_COMMANDS);
+    run<svg::karma_path_emitter>("karma, shortest", geometries, iterations, precision, svg::SHORTEST_PATH_COMMANDS);
+    run<svg::fast_path_emitter>("fast, shortest", geometries, iterations, precision, svg::SHORTEST_PATH_COMMANDS);
+
+    return EXIT_SUCCESS;
+}
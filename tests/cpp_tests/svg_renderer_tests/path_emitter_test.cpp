@@ -0,0 +1,304 @@
+#define BOOST_TEST_MODULE path_emitter_test
+
+/*
+ * This test module contains test cases that verify
+ * that fast_path_emitter writes the same path data,
+ * byte for byte, as the default karma_path_emitter.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/geometry.hpp>
+#include <mapnik/ctrans.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/svg_renderer.hpp>
+#include <mapnik/svg/svg_generator.hpp>
+#include <mapnik/svg/svg_output_buffer.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+#include <boost/spirit/include/karma.hpp>
+
+// stl
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <string>
+
+using namespace mapnik;
+
+/*
+ * Write 'value' with Karma's coordinate generator.
+ */
+std::string karma_coordinate(double value, unsigned precision)
+{
+    std::string output;
+    std::back_insert_iterator<std::string> output_iterator(output);
+    svg::coordinate_policy<double> policy(precision);
+    boost::spirit::karma::real_generator<double, svg::coordinate_policy<double> > coordinate(policy);
+    boost::spirit::karma::generate(output_iterator, coordinate, value);
+    return output;
+}
+
+/*
+ * Write 'value' with fast_path_emitter.
+ */
+std::string fast_coordinate(double value, unsigned precision)
+{
+    std::string output;
+    std::back_insert_iterator<std::string> output_iterator(output);
+    svg::fast_path_emitter::generate_coordinate(output_iterator, value, precision);
+    return output;
+}
+
+/*
+ * The fixture maps a 256x256 extent onto a 256x256 image. Its geometries
+ * are random line strings and polygons that reach out of the extent.
+ */
+struct F
+{
+    typedef svg::svg_generator<svg::output_buffer_iterator> karma_generator_type;
+    typedef svg::svg_generator<svg::output_buffer_iterator, svg::fast_path_emitter> fast_generator_type;
+
+    F() :
+	t(256, 256, box2d<double>(0, 0, 256, 256)),
+	proj("+proj=latlong +datum=WGS84"),
+	prj_trans(proj, proj),
+	karma_output_iterator(karma_buffer),
+	fast_output_iterator(fast_buffer),
+	karma_generator(karma_output_iterator),
+	fast_generator(fast_output_iterator),
+	line(LineString),
+	polygon(Polygon)
+    {
+	std::srand(42);
+	for(int i = 0; i < 200; ++i)
+	{
+	    if(i % 50 == 0)
+		line.move_to(random_coordinate(), random_coordinate());
+	    else
+		line.line_to(random_coordinate(), random_coordinate());
+	}
+	polygon.move_to(random_coordinate(), random_coordinate());
+	for(int i = 0; i < 50; ++i)
+	{
+	    polygon.line_to(random_coordinate(), random_coordinate());
+	}
+    }
+
+    ~F() {}
+
+    static double random_coordinate()
+    {
+	return -64.0 + 384.0 * std::rand() / RAND_MAX;
+    }
+
+    /*
+     * Apply the same settings to both generators.
+     */
+    void configure(unsigned precision, svg::path_commands_e commands)
+    {
+	karma_generator.set_coordinate_precision(precision);
+	karma_generator.set_path_commands(commands);
+	fast_generator.set_coordinate_precision(precision);
+	fast_generator.set_path_commands(commands);
+    }
+
+    /*
+     * Check that both generators write the same path tag for 'geometry'.
+     */
+    void check_path(geometry_type const& geometry)
+    {
+	coord_transform2<CoordTransform, geometry_type> path(t, geometry, prj_trans);
+	karma_buffer.clear();
+	fast_buffer.clear();
+	karma_generator.generate_path(path, svg::path_output_attributes());
+	fast_generator.generate_path(path, svg::path_output_attributes());
+	BOOST_CHECK_EQUAL(fast_buffer.str(), karma_buffer.str());
+    }
+
+    CoordTransform t;
+    projection proj;
+    proj_transform prj_trans;
+    svg::output_buffer karma_buffer;
+    svg::output_buffer fast_buffer;
+    svg::output_buffer_iterator karma_output_iterator;
+    svg::output_buffer_iterator fast_output_iterator;
+    karma_generator_type karma_generator;
+    fast_generator_type fast_generator;
+    geometry_type line;
+    geometry_type polygon;
+};
+
+/*
+ * Coordinates are written as Karma writes them, including the
+ * rounding carries, the sign of values that round to zero and
+ * the leading zeros of fractional parts.
+ */
+BOOST_AUTO_TEST_CASE(coordinate_test_case)
+{
+    double const values[] =
+    {
+	0.0, -0.0, 1.0, -1.0, 0.5, -0.5, 0.9995, -0.9995, 9.9996, 0.0004, -0.0004,
+	0.0005, -0.0005, 0.05, 1.05, 2.675, 10.12345, -10.1236, 100.001, 255.9999,
+	1e-9, -1e-9, 123456789.123, -987654321.5, 4503599627370495.5, 9007199254740991.0
+    };
+    for(unsigned precision = 0; precision <= 6; ++precision)
+    {
+	for(unsigned i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+	{
+	    BOOST_CHECK_EQUAL(fast_coordinate(values[i], precision), karma_coordinate(values[i], precision));
+	}
+    }
+
+    std::srand(7);
+    for(int i = 0; i < 100000; ++i)
+    {
+	double value = (std::rand() - RAND_MAX / 2) / 1000.0 + std::rand() / (double)RAND_MAX;
+	unsigned precision = i % 7;
+	if(fast_coordinate(value, precision) != karma_coordinate(value, precision))
+	{
+	    BOOST_CHECK_EQUAL(fast_coordinate(value, precision), karma_coordinate(value, precision));
+	}
+    }
+}
+
+/*
+ * Values that the hand-written formatter does not handle
+ * are written by Karma.
+ */
+BOOST_AUTO_TEST_CASE(coordinate_fallback_test_case)
+{
+    char buffer[svg::fast_path_emitter::max_coordinate_length];
+    BOOST_CHECK(svg::fast_path_emitter::format_coordinate(buffer, 1e20, 3) == 0);
+    BOOST_CHECK(svg::fast_path_emitter::format_coordinate(buffer, 1.0, 16) == 0);
+    BOOST_CHECK(svg::fast_path_emitter::format_coordinate(buffer, std::numeric_limits<double>::infinity(), 3) == 0);
+
+    BOOST_CHECK_EQUAL(fast_coordinate(1e20, 3), karma_coordinate(1e20, 3));
+    BOOST_CHECK_EQUAL(fast_coordinate(-1e20, 3), karma_coordinate(-1e20, 3));
+    BOOST_CHECK_EQUAL(fast_coordinate(std::numeric_limits<double>::quiet_NaN(), 3),
+		      karma_coordinate(std::numeric_limits<double>::quiet_NaN(), 3));
+}
+
+/*
+ * Path data is the same at every precision and with every kind of commands.
+ */
+BOOST_FIXTURE_TEST_CASE(path_data_test_case, F)
+{
+    svg::path_commands_e const commands[] =
+    {
+	svg::ABSOLUTE_PATH_COMMANDS, svg::RELATIVE_PATH_COMMANDS, svg::SHORTEST_PATH_COMMANDS
+    };
+    for(unsigned precision = 0; precision <= 6; ++precision)
+    {
+	for(unsigned i = 0; i < 3; ++i)
+	{
+	    configure(precision, commands[i]);
+	    check_path(line);
+	    check_path(polygon);
+	}
+    }
+}
+
+/*
+ * Clipped and simplified paths, and batches of paths, are the same too.
+ */
+BOOST_FIXTURE_TEST_CASE(converted_path_data_test_case, F)
+{
+    configure(2, svg::ABSOLUTE_PATH_COMMANDS);
+    karma_generator.set_clip_box(box2d<double>(0, 0, 256, 256));
+    karma_generator.set_clipping(true);
+    karma_generator.set_simplify_tolerance(2);
+    fast_generator.set_clip_box(box2d<double>(0, 0, 256, 256));
+    fast_generator.set_clipping(true);
+    fast_generator.set_simplify_tolerance(2);
+    check_path(line);
+    check_path(polygon);
+
+    configure(3, svg::SHORTEST_PATH_COMMANDS);
+    coord_transform2<CoordTransform, geometry_type> line_path(t, line, prj_trans);
+    coord_transform2<CoordTransform, geometry_type> polygon_path(t, polygon, prj_trans);
+    karma_buffer.clear();
+    fast_buffer.clear();
+    karma_generator.append_path(line_path, " fill=\"none\"");
+    karma_generator.append_path(polygon_path, " fill=\"none\"");
+    karma_generator.flush_paths();
+    fast_generator.append_path(line_path, " fill=\"none\"");
+    fast_generator.append_path(polygon_path, " fill=\"none\"");
+    fast_generator.flush_paths();
+    BOOST_CHECK(!fast_buffer.str().empty());
+    BOOST_CHECK_EQUAL(fast_buffer.str(), karma_buffer.str());
+}
+
+/*
+ * Render 'map' with the renderer that uses PathEmitter.
+ */
+template <typename PathEmitter>
+std::string render(Map const& map, unsigned precision, svg::path_commands_e commands, unsigned layer_threads)
+{
+    svg::output_buffer buffer;
+    svg::output_buffer_iterator output_iterator(buffer);
+    svg_renderer<svg::output_buffer_iterator, PathEmitter> renderer(map, output_iterator);
+    renderer.set_coordinate_precision(precision);
+    renderer.set_path_commands(commands);
+    renderer.set_layer_threads(layer_threads);
+    renderer.apply();
+    return buffer.str();
+}
+
+/*
+ * A renderer that uses fast_path_emitter writes the same document
+ * as one that uses the default emitter.
+ */
+BOOST_AUTO_TEST_CASE(renderer_test_case)
+{
+    Map map(256, 256);
+    feature_type_style lines;
+    mapnik::rule line_rule;
+    line_rule.append(line_symbolizer(color(255, 0, 0)));
+    lines.add_rule(line_rule);
+    map.insert_style("lines", lines);
+    feature_type_style polygons;
+    mapnik::rule polygon_rule;
+    polygon_rule.append(polygon_symbolizer(color(0, 0, 255)));
+    polygons.add_rule(polygon_rule);
+    map.insert_style("polygons", polygons);
+
+    std::srand(3);
+    for(int l = 0; l < 2; ++l)
+    {
+	boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+	for(int i = 0; i < 20; ++i)
+	{
+	    feature_ptr feature(feature_factory::create(i));
+	    geometry_type* geometry = new geometry_type(l == 0 ? LineString : Polygon);
+	    geometry->move_to(F::random_coordinate(), F::random_coordinate());
+	    for(int j = 0; j < 10; ++j)
+	    {
+		geometry->line_to(F::random_coordinate(), F::random_coordinate());
+	    }
+	    feature->add_geometry(geometry);
+	    ds->push(feature);
+	}
+	layer lyr(l == 0 ? "lines" : "polygons", map.srs());
+	lyr.set_datasource(ds);
+	lyr.add_style(l == 0 ? "lines" : "polygons");
+	map.addLayer(lyr);
+    }
+    map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+
+    std::string karma = render<svg::karma_path_emitter>(map, 3, svg::ABSOLUTE_PATH_COMMANDS, 1);
+    BOOST_CHECK(karma.find("<path ") != std::string::npos);
+    BOOST_CHECK_EQUAL(render<svg::fast_path_emitter>(map, 3, svg::ABSOLUTE_PATH_COMMANDS, 1), karma);
+    BOOST_CHECK_EQUAL(render<svg::fast_path_emitter>(map, 1, svg::SHORTEST_PATH_COMMANDS, 1),
+		      render<svg::karma_path_emitter>(map, 1, svg::SHORTEST_PATH_COMMANDS, 1));
+    // layers rendered in parallel use the same emitter.
+    BOOST_CHECK_EQUAL(render<svg::fast_path_emitter>(map, 3, svg::ABSOLUTE_PATH_COMMANDS, 2), karma);
+}
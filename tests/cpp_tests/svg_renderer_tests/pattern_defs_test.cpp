@@ -0,0 +1,144 @@
+#define BOOST_TEST_MODULE pattern_defs_test
+
+/*
+ * This test module contains test cases that verify how
+ * svg_renderer writes pattern symbolizers: each distinct
+ * pattern once, as a pattern tag, which paths refer to.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/parse_path.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <string>
+
+// test utilities
+#include "occurrences.hpp"
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * The fixture map maps a 256x256 extent onto a 256x256 image. Its
+ * "shapes" layer has two squares, and the "pattern_defs_test.svg"
+ * marker is a red 8x8 square.
+ */
+struct F : map_fixture
+{
+    F()
+    {
+	boost::shared_ptr<memory_datasource> shapes = boost::make_shared<memory_datasource>();
+	for(int i = 0; i < 2; ++i)
+	{
+	    feature_ptr feature(feature_factory::create(i));
+	    geometry_type* square = new geometry_type(Polygon);
+	    square->move_to(10 + i * 100, 10);
+	    square->line_to(90 + i * 100, 10);
+	    square->line_to(90 + i * 100, 90);
+	    square->line_to(10 + i * 100, 90);
+	    square->line_to(10 + i * 100, 10);
+	    feature->add_geometry(square);
+	    shapes->push(feature);
+	}
+
+	add_layer("shapes", shapes);
+	map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+
+	path_ptr marker_path(new svg_storage_type);
+	vertex_stl_adapter<svg_path_storage> stl_storage(marker_path->source());
+	svg_path_adapter svg_path(stl_storage);
+	svg_path.move_to(0, 0);
+	svg_path.line_to(8, 0);
+	svg_path.line_to(8, 8);
+	svg_path.line_to(0, 8);
+	svg_path.close_polygon();
+	svg::path_attributes attributes;
+	attributes.fill_color = agg::rgba8(255, 0, 0);
+	marker_path->attributes().add(attributes);
+	marker_path->set_bounding_box(0, 0, 8, 8);
+	marker_cache::insert("pattern_defs_test.svg", boost::make_shared<marker>(boost::optional<path_ptr>(marker_path)));
+    }
+
+    ~F() {}
+
+    std::string render(symbolizer const& sym, bool style_classes = false)
+    {
+	insert_style("shapes", sym);
+
+	buffer_rendering rendering(map);
+	rendering.renderer.set_style_classes(style_classes);
+	return rendering.apply();
+    }
+};
+
+/*
+ * Polygons are filled with the pattern, which is written once.
+ */
+BOOST_FIXTURE_TEST_CASE(polygon_pattern_test_case, F)
+{
+    std::string output = render(polygon_pattern_symbolizer(parse_path("pattern_defs_test.svg")));
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<pattern "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<defs>\n<pattern id=\"m0\" patternUnits=\"userSpaceOnUse\" width=\"8\" height=\"8\" viewBox=\"-4 -4 8 8\">\n"
+				  "<path d=\"M0 0 L8 0 L8 8 L0 8 Z\" fill=\"#ff0000\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "</pattern>\n</defs>\n"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "fill=\"url(#m0)\""), 2u);
+
+    // the pattern is defined before it is used.
+    BOOST_CHECK(output.find("<pattern ") < output.find("url(#m0)"));
+}
+
+/*
+ * Bitmap patterns are embedded once in the pattern, as a PNG data
+ * URI: the output does not refer to the pattern's file.
+ */
+BOOST_FIXTURE_TEST_CASE(bitmap_pattern_test_case, F)
+{
+    image_ptr bitmap(new image_data_32(6, 4));
+    bitmap->set(0xff0000ff);
+    marker_cache::insert("pattern_defs_test&bitmap.png", boost::make_shared<marker>(boost::optional<image_ptr>(bitmap)));
+
+    std::string output = render(polygon_pattern_symbolizer(parse_path("pattern_defs_test&bitmap.png")));
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<pattern "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<pattern id=\"m0\" patternUnits=\"userSpaceOnUse\" width=\"6\" height=\"4\" viewBox=\"-3 -2 6 4\">\n"
+				  "<image x=\"-3\" y=\"-2\" width=\"6\" height=\"4\" xlink:href=\"data:image/png;base64,iVBORw0KGgo"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "data:image/png;base64,"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "\"/>\n</pattern>\n"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "pattern_defs_test"), 0u);
+    BOOST_CHECK_EQUAL(occurrences(output, "fill=\"url(#m0)\""), 2u);
+}
+
+/*
+ * Lines are stroked with the pattern, as wide as the pattern.
+ */
+BOOST_FIXTURE_TEST_CASE(line_pattern_test_case, F)
+{
+    std::string output = render(line_pattern_symbolizer(parse_path("pattern_defs_test.svg")));
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<pattern "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "fill=\"none\" fill-opacity=\"1.0\" stroke=\"url(#m0)\" stroke-opacity=\"1.0\" stroke-width=\"8.0px\""), 2u);
+}
+
+/*
+ * Rules with patterns get no style class: their attributes are written on each path.
+ */
+BOOST_FIXTURE_TEST_CASE(pattern_style_classes_test_case, F)
+{
+    std::string output = render(polygon_pattern_symbolizer(parse_path("pattern_defs_test.svg")), true);
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<style "), 0u);
+    BOOST_CHECK_EQUAL(occurrences(output, "fill=\"url(#m0)\""), 2u);
+}
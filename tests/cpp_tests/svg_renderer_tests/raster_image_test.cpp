@@ -0,0 +1,153 @@
+#define BOOST_TEST_MODULE raster_image_test
+
+/*
+ * This test module contains test cases that verify how
+ * svg_renderer embeds rasters: as PNG images, base64-encoded
+ * into data URIs as they are written.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/raster.hpp>
+#include <mapnik/svg_renderer.hpp>
+#include <mapnik/svg/svg_base64_encoder.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <iterator>
+#include <string>
+
+// test utilities
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * Base64-encode 'input', writing it in chunks of 'chunk_size' bytes.
+ */
+std::string encode(std::string const& input, std::size_t chunk_size)
+{
+    std::string output;
+    std::back_insert_iterator<std::string> output_iterator(output);
+    svg::base64_encoder<std::back_insert_iterator<std::string> > encoder(output_iterator);
+    for(std::size_t pos = 0; pos < input.size(); pos += chunk_size)
+    {
+	encoder.write(input.data() + pos, std::min(chunk_size, input.size() - pos));
+	encoder.flush();
+    }
+    encoder.finish();
+    return output;
+}
+
+/*
+ * Decode the base64 text 'input' (without checking it).
+ */
+std::string decode(std::string const& input)
+{
+    static std::string const alphabet("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+
+    std::string output;
+    unsigned bits = 0;
+    unsigned value = 0;
+    for(std::string::size_type i = 0; i < input.size() && input[i] != '='; ++i)
+    {
+	value = (value << 6) | alphabet.find(input[i]);
+	bits += 6;
+	if(bits >= 8)
+	{
+	    bits -= 8;
+	    output += static_cast<char>((value >> bits) & 0xff);
+	}
+    }
+    return output;
+}
+
+/*
+ * The fixture map maps a 256x256 extent onto a 256x256 image. Its
+ * "raster" layer has a 2x2 raster that covers its center, half as
+ * large as the image.
+ */
+struct F : map_fixture
+{
+    F()
+    {
+	image_data_32 data(2, 2);
+	data(0, 0) = 0xff0000ff;
+	data(1, 0) = 0xff00ff00;
+	data(0, 1) = 0xffff0000;
+	data(1, 1) = 0x80000000;
+	box2d<double> extent(64, 64, 192, 192);
+
+	feature_ptr feature(feature_factory::create(0));
+	feature->set_raster(boost::make_shared<raster>(extent, data));
+	geometry_type* outline = new geometry_type(Polygon);
+	outline->move_to(64, 64);
+	outline->line_to(192, 64);
+	outline->line_to(192, 192);
+	outline->line_to(64, 192);
+	outline->line_to(64, 64);
+	feature->add_geometry(outline);
+	boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+	ds->push(feature);
+
+	add_layer("raster", ds);
+	map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+    }
+
+    ~F() {}
+
+    std::string render(raster_symbolizer const& sym)
+    {
+	insert_style("raster", sym);
+	return map_fixture::render();
+    }
+};
+
+/*
+ * Groups of three bytes are encoded as four characters, whatever
+ * the size of the writes, and the last group is padded.
+ */
+BOOST_AUTO_TEST_CASE(base64_encoder_test_case)
+{
+    BOOST_CHECK_EQUAL(encode("", 1), "");
+    BOOST_CHECK_EQUAL(encode("Man", 3), "TWFu");
+    BOOST_CHECK_EQUAL(encode("Ma", 1), "TWE=");
+    BOOST_CHECK_EQUAL(encode("M", 1), "TQ==");
+    BOOST_CHECK_EQUAL(encode("any carnal pleasure.", 1), "YW55IGNhcm5hbCBwbGVhc3VyZS4=");
+    BOOST_CHECK_EQUAL(encode("any carnal pleasure.", 7), "YW55IGNhcm5hbCBwbGVhc3VyZS4=");
+    BOOST_CHECK_EQUAL(decode(encode(std::string("\0\xff\x80\x01", 4), 2)), std::string("\0\xff\x80\x01", 4));
+}
+
+/*
+ * The raster is scaled to the image and embedded as a PNG image
+ * where it is drawn.
+ */
+BOOST_FIXTURE_TEST_CASE(raster_image_test_case, F)
+{
+    raster_symbolizer sym;
+    sym.set_opacity(0.5);
+
+    std::string output = render(sym);
+
+    std::string const prefix("<image x=\"64\" y=\"64\" width=\"128\" height=\"128\" opacity=\"0.5\" xlink:href=\"data:image/png;base64,");
+    std::string::size_type begin = output.find(prefix);
+    BOOST_REQUIRE(begin != std::string::npos);
+    begin += prefix.size();
+    std::string::size_type end = output.find("\"/>\n", begin);
+    BOOST_REQUIRE(end != std::string::npos);
+
+    std::string png = decode(output.substr(begin, end - begin));
+    BOOST_CHECK_EQUAL(png.substr(0, 8), "\x89PNG\r\n\x1a\n");
+    // the IHDR chunk holds the width and height of the image.
+    BOOST_CHECK_EQUAL(png.substr(12, 12), std::string("IHDR\0\0\0\x80\0\0\0\x80", 12));
+    // no path is written for the feature's outline.
+    BOOST_CHECK(output.find("<path ") == std::string::npos);
+}
@@ -0,0 +1,351 @@
+/*
+ * This benchmark renders the maps of tests/data/good_maps with
+ * svg_renderer and agg_renderer, at several image sizes and
+ * extents, and writes one line of comma separated values per
+ * map, renderer, size and extent to the standard output, so that
+ * results can be compared from release to release:
+ *
+ *   map,renderer,width,height,extent,iterations,features,bytes,
+ *   total_ms,fetch_ms,process_ms,output_ms,features_per_sec,
+ *   bytes_per_sec,peak_rss_kb
+ *
+ * Times are averages per render. fetch_ms is the time spent in the
+ * datasources (querying and reading features), process_ms the time
+ * spent processing symbolizers and output_ms the time spent encoding
+ * the image as PNG. svg_renderer generates the document while it
+ * processes the symbolizers, so for svg process_ms includes the
+ * generation and output_ms is left empty. Each map, renderer, size
+ * and extent is rendered in a child process of its own, so that
+ * peak_rss_kb is the peak resident set size of that configuration
+ * alone. Maps that fail to load are reported on the standard error
+ * and skipped.
+ *
+ * usage: render_benchmark [plugins dir] [fonts dir] [maps dir] [iterations]
+ */
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/datasource.hpp>
+#include <mapnik/datasource_cache.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/load_map.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/filesystem/operations.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+// stl
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// posix
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace mapnik;
+
+/*
+ * Wall clock time in milliseconds, with microsecond resolution.
+ */
+double now()
+{
+    timeval time;
+    gettimeofday(&time, NULL);
+    return time.tv_sec * 1000.0 + time.tv_usec / 1000.0;
+}
+
+std::string file_name(boost::filesystem::path const& path)
+{
+#if (BOOST_FILESYSTEM_VERSION == 3)
+    return path.filename().string();
+#else // v2
+    return path.leaf();
+#endif
+}
+
+long peak_rss_kb()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/*
+ * Time spent in the datasources of a map, and features read from them.
+ */
+struct fetch_stats
+{
+    fetch_stats() : elapsed(0.0), features(0) {}
+
+    double elapsed;
+    std::size_t features;
+};
+
+/*
+ * Featureset that adds the time spent reading features to a fetch_stats.
+ */
+class timed_featureset : public Featureset
+{
+public:
+    timed_featureset(featureset_ptr featureset, fetch_stats& stats)
+	: featureset_(featureset),
+	  stats_(stats)
+    {}
+
+    feature_ptr next()
+    {
+	double start = now();
+	feature_ptr feature = featureset_->next();
+	stats_.elapsed += now() - start;
+	if(feature)
+	{
+	    ++stats_.features;
+	}
+	return feature;
+    }
+
+private:
+    featureset_ptr featureset_;
+    fetch_stats& stats_;
+};
+
+/*
+ * Datasource that wraps the datasource of a layer, and
+ * adds the time spent querying it to a fetch_stats.
+ */
+class timed_datasource : public datasource
+{
+public:
+    timed_datasource(datasource_ptr ds, fetch_stats& stats)
+	: datasource(ds->params()),
+	  ds_(ds),
+	  stats_(stats)
+    {}
+
+    int type() const
+    {
+	return ds_->type();
+    }
+
+    void bind() const
+    {
+	ds_->bind();
+    }
+
+    featureset_ptr features(query const& q) const
+    {
+	double start = now();
+	featureset_ptr featureset = ds_->features(q);
+	stats_.elapsed += now() - start;
+	if(!featureset)
+	{
+	    return featureset;
+	}
+	return boost::make_shared<timed_featureset>(featureset, boost::ref(stats_));
+    }
+
+    featureset_ptr features_at_point(coord2d const& pt) const
+    {
+	return ds_->features_at_point(pt);
+    }
+
+    box2d<double> envelope() const
+    {
+	return ds_->envelope();
+    }
+
+    layer_descriptor get_descriptor() const
+    {
+	return ds_->get_descriptor();
+    }
+
+private:
+    datasource_ptr ds_;
+    fetch_stats& stats_;
+};
+
+/*
+ * Average times and totals of the renders of a map.
+ */
+struct benchmark_stats
+{
+    benchmark_stats() : total(0.0), output(-1.0), bytes(0) {}
+
+    double total;
+    double output; // negative when the output is not timed separately
+    std::size_t bytes;
+    fetch_stats fetch;
+};
+
+void render_svg(Map const& m, benchmark_stats& stats)
+{
+    double start = now();
+    svg::output_buffer buffer;
+    svg::output_buffer_iterator output_iterator(buffer);
+    svg_renderer<svg::output_buffer_iterator> renderer(m, output_iterator);
+    renderer.apply();
+    stats.bytes += buffer.size();
+    stats.total += now() - start;
+}
+
+void render_agg(Map const& m, benchmark_stats& stats)
+{
+    double start = now();
+    image_32 image(m.width(), m.height());
+    agg_renderer<image_32> renderer(m, image);
+    renderer.apply();
+
+    double output_start = now();
+    std::string png = save_to_string(image, "png");
+    stats.output = std::max(stats.output, 0.0) + now() - output_start;
+    stats.bytes += png.size();
+    stats.total += now() - start;
+}
+
+void report(std::string const& map_name, std::string const& renderer_name, Map const& m,
+	    std::string const& extent_name, unsigned iterations, benchmark_stats const& stats)
+{
+    double seconds = stats.total / 1000.0;
+    double output = std::max(stats.output, 0.0);
+    std::cout << map_name << ',' << renderer_name << ','
+	      << m.width() << ',' << m.height() << ',' << extent_name << ','
+	      << iterations << ','
+	      << stats.fetch.features / iterations << ','
+	      << stats.bytes / iterations << ','
+	      << stats.total / iterations << ','
+	      << stats.fetch.elapsed / iterations << ','
+	      << (stats.total - stats.fetch.elapsed - output) / iterations << ',';
+    if(stats.output >= 0.0)
+    {
+	std::cout << output / iterations;
+    }
+    std::cout << ','
+	      << (seconds > 0.0 ? stats.fetch.features / seconds : 0.0) << ','
+	      << (seconds > 0.0 ? stats.bytes / seconds : 0.0) << ','
+	      << peak_rss_kb() << std::endl;
+}
+
+/*
+ * Renders a map iterations times in a child process, so that the
+ * peak resident set size it reports belongs to this configuration
+ * only, and reports the results from there.
+ */
+void benchmark(std::string const& map_name, std::string const& renderer_name, Map const& m,
+	       std::string const& extent_name, unsigned iterations, fetch_stats& fetch,
+	       void (*render)(Map const&, benchmark_stats&))
+{
+    std::cout.flush();
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+	std::cerr << map_name << ": fork failed\n";
+	return;
+    }
+    if(pid == 0)
+    {
+	int status = EXIT_SUCCESS;
+	try
+	{
+	    benchmark_stats stats;
+	    fetch = fetch_stats();
+	    for(unsigned k = 0; k < iterations; ++k)
+	    {
+		render(m, stats);
+	    }
+	    stats.fetch = fetch;
+	    report(map_name, renderer_name, m, extent_name, iterations, stats);
+	}
+	catch(std::exception const& ex)
+	{
+	    std::cerr << map_name << ": " << ex.what() << "\n";
+	    status = EXIT_FAILURE;
+	}
+	std::cout.flush();
+	_exit(status);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+}
+
+int main(int argc, char** argv)
+{
+    std::string plugins_dir = argc > 1 ? argv[1] : "../../../plugins/input/";
+    std::string fonts_dir = argc > 2 ? argv[2] : "../../../fonts/";
+    std::string maps_dir = argc > 3 ? argv[3] : "../../data/good_maps/";
+    unsigned iterations = argc > 4 ? boost::lexical_cast<unsigned>(argv[4]) : 5;
+
+    datasource_cache::instance()->register_datasources(plugins_dir);
+    freetype_engine::register_fonts(fonts_dir, true);
+
+    std::vector<std::string> map_files;
+    for(boost::filesystem::directory_iterator it(maps_dir), end; it != end; ++it)
+    {
+	std::string name = file_name(it->path());
+	if(name.size() > 4 && name.compare(name.size() - 4, 4, ".xml") == 0)
+	{
+	    map_files.push_back(it->path().string());
+	}
+    }
+    std::sort(map_files.begin(), map_files.end());
+
+    unsigned const sizes[] = { 256, 512, 1024 };
+
+    std::cout << "map,renderer,width,height,extent,iterations,features,bytes,"
+	      << "total_ms,fetch_ms,process_ms,output_ms,features_per_sec,"
+	      << "bytes_per_sec,peak_rss_kb" << std::endl;
+
+    for(std::size_t i = 0; i < map_files.size(); ++i)
+    {
+	std::string map_name = file_name(boost::filesystem::path(map_files[i]));
+	Map m(256, 256);
+	fetch_stats fetch;
+	try
+	{
+	    load_map(m, map_files[i]);
+	    std::vector<layer>& layers = m.layers();
+	    for(std::size_t j = 0; j < layers.size(); ++j)
+	    {
+		if(layers[j].datasource())
+		{
+		    layers[j].set_datasource(boost::make_shared<timed_datasource>(layers[j].datasource(), boost::ref(fetch)));
+		}
+	    }
+	}
+	catch(std::exception const& ex)
+	{
+	    std::cerr << map_name << ": skipped (" << ex.what() << ")\n";
+	    continue;
+	}
+
+	for(unsigned j = 0; j < sizeof(sizes) / sizeof(sizes[0]); ++j)
+	{
+	    for(unsigned extent = 0; extent < 2; ++extent)
+	    {
+		// the whole map, then the central quarter of it.
+		m.resize(sizes[j], sizes[j]);
+		m.zoom_all();
+		if(extent == 1)
+		{
+		    m.zoom(0.5);
+		}
+		std::string extent_name = (extent == 0) ? "all" : "center";
+
+		benchmark(map_name, "svg", m, extent_name, iterations, fetch, render_svg);
+		benchmark(map_name, "agg", m, extent_name, iterations, fetch, render_agg);
+	    }
+	}
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#define BOOST_TEST_MODULE source_coordinates_test
+
+/*
+ * This test module contains test cases that verify how
+ * svg_renderer writes paths in source coordinates: in
+ * the map's projection, within a transformed group.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <string>
+
+// test utilities
+#include "occurrences.hpp"
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * The fixture map maps a 512x512 extent onto a 256x256 image,
+ * so a vertex (x, y) is drawn at (x / 2, 256 - y / 2). Its
+ * "lines" layer has a diagonal line, drawn with a line symbolizer.
+ */
+struct F : map_fixture
+{
+    F() : lines(boost::make_shared<memory_datasource>())
+    {
+	add_line(0, 0, 512, 512);
+
+	add_layer("lines", lines);
+	insert_style("lines", line_symbolizer(color(255, 0, 0)));
+	map.zoom_to_box(box2d<double>(0, 0, 512, 512));
+    }
+
+    ~F() {}
+
+    void add_line(double x0, double y0, double x1, double y1)
+    {
+	feature_ptr feature(feature_factory::create(lines->size()));
+	geometry_type* line = new geometry_type(LineString);
+	line->move_to(x0, y0);
+	line->line_to(x1, y1);
+	feature->add_geometry(line);
+	lines->push(feature);
+    }
+
+    std::string render(bool source_coordinates, bool path_batching = false)
+    {
+	buffer_rendering rendering(map);
+	rendering.renderer.set_source_coordinates(source_coordinates);
+	rendering.renderer.set_path_batching(path_batching);
+	return rendering.apply();
+    }
+
+    boost::shared_ptr<memory_datasource> lines;
+};
+
+/*
+ * The paths of a layer are written untransformed, in a group
+ * whose transform maps them to the image.
+ */
+BOOST_FIXTURE_TEST_CASE(source_group_test_case, F)
+{
+    std::string output = render(true);
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<g "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<g transform=\"matrix(0.5 0 0 -0.5 0 256)\">\n"
+				  "<path d=\"M0 0 L512 512\" "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, " vector-effect=\"non-scaling-stroke\"/>\n</g>\n"), 1u);
+
+    // by default, the vertices are transformed.
+    BOOST_CHECK_EQUAL(occurrences(render(false), "<path d=\"M0 256 L256 0\""), 1u);
+}
+
+/*
+ * Paths are clipped to the buffered map extent, in source units.
+ */
+BOOST_FIXTURE_TEST_CASE(source_clipping_test_case, F)
+{
+    add_line(-1000, 256, 256, 256);
+
+    BOOST_CHECK_EQUAL(occurrences(render(true), "<path d=\"M0 256 L256 256\""), 1u);
+}
+
+/*
+ * Batched paths are written in the group of the layer too.
+ */
+BOOST_FIXTURE_TEST_CASE(source_path_batching_test_case, F)
+{
+    add_line(0, 512, 512, 0);
+
+    std::string output = render(true, true);
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<path "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<g transform=\"matrix(0.5 0 0 -0.5 0 256)\">\n"
+				  "<path d=\"M0 0 L512 512 M0 512 L512 0\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "</g>\n"), 1u);
+}
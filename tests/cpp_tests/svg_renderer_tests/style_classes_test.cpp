@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE style_classes_test
+
+/*
+ * This test module contains test cases that verify
+ * how svg_renderer writes the presentation attributes
+ * of paths: inline, or as classes of a style sheet, and
+ * how it merges paths that share their attributes.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <string>
+
+// test utilities
+#include "occurrences.hpp"
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * The fixture map has three layers of two lines each. The first two
+ * layers use different styles with the same stroke, the third one
+ * uses a dashed stroke.
+ */
+struct F : map_fixture
+{
+    F()
+    {
+	stroke plain_stroke(color(171, 158, 137), 2.0);
+	stroke dashed_stroke(color(0, 0, 0), 1.0);
+	dashed_stroke.add_dash(8, 4);
+
+	add_layer("roads", plain_stroke);
+	add_layer("tracks", plain_stroke);
+	add_layer("borders", dashed_stroke);
+	map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+    }
+
+    ~F() {}
+
+    void add_layer(std::string const& name, stroke const& line_stroke)
+    {
+	insert_style(name, line_symbolizer(line_stroke));
+
+	boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+	for(int i = 0; i < 2; ++i)
+	{
+	    feature_ptr feature(feature_factory::create(i));
+	    geometry_type* line = new geometry_type(LineString);
+	    line->move_to(10, 10 + i * 10);
+	    line->line_to(200, 10 + i * 10);
+	    feature->add_geometry(line);
+	    ds->push(feature);
+	}
+
+	map_fixture::add_layer(name, ds);
+    }
+
+    std::string render(bool style_classes, bool path_batching = false)
+    {
+	buffer_rendering rendering(map);
+	rendering.renderer.set_style_classes(style_classes);
+	rendering.renderer.set_path_batching(path_batching);
+	return rendering.apply();
+    }
+};
+
+/*
+ * By default, every path carries its whole set of attributes.
+ */
+BOOST_FIXTURE_TEST_CASE(inline_attributes_test_case, F)
+{
+    std::string output = render(false);
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<path "), 6u);
+    BOOST_CHECK_EQUAL(occurrences(output, "stroke=\"#ab9e89\""), 4u);
+    BOOST_CHECK_EQUAL(occurrences(output, "stroke-dasharray=\"8.0,4.0\""), 2u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<style"), 0u);
+    BOOST_CHECK_EQUAL(occurrences(output, "class="), 0u);
+}
+
+/*
+ * With style classes, the rules that share a stroke share a class,
+ * and paths only refer to their class.
+ */
+BOOST_FIXTURE_TEST_CASE(style_classes_test_case, F)
+{
+    std::string output = render(true);
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<style type=\"text/css\">"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, ".s0{fill:none;fill-opacity:1.0;stroke:#ab9e89;"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, ".s1{fill:none;fill-opacity:1.0;stroke:#000000;"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, ";stroke-dasharray:8.0,4.0}"), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, ".s2{"), 0u);
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<path "), 6u);
+    BOOST_CHECK_EQUAL(occurrences(output, "class=\"s0\"/>"), 4u);
+    BOOST_CHECK_EQUAL(occurrences(output, "class=\"s1\"/>"), 2u);
+    BOOST_CHECK_EQUAL(occurrences(output, "stroke=\""), 0u);
+
+    // the style sheet comes before any path.
+    BOOST_CHECK(output.find("<style") < output.find("<path "));
+}
+
+/*
+ * With path batching, the lines of each layer are written as the
+ * sub-paths of a single path. Batches do not span layers, even
+ * if the next layer uses the same attributes.
+ */
+BOOST_FIXTURE_TEST_CASE(path_batching_test_case, F)
+{
+    std::string output = render(true, true);
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<path "), 3u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<path d=\"M10 246 L200 246 M10 236 L200 236\" class=\"s0\"/>"), 2u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<path d=\"M10 246 L200 246 M10 236 L200 236\" class=\"s1\"/>"), 1u);
+}
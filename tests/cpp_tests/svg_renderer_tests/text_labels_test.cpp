@@ -0,0 +1,205 @@
+#define BOOST_TEST_MODULE text_labels_test
+
+/*
+ * This test module contains test cases that verify
+ * how svg_renderer writes text and shield symbolizers:
+ * labels are placed as agg_renderer places them and
+ * written as text tags, with a position per glyph.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/filter_factory.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/parse_path.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/svg_renderer.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <string>
+
+// test utilities
+#include "occurrences.hpp"
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * The fixture map maps a 256x256 extent onto a 256x256 image. Its
+ * "points" layer has a point named "Main & Co", its "lines" layer
+ * a diagonal line named "High Street".
+ */
+struct F : map_fixture
+{
+    F()
+    {
+	freetype_engine::register_font("../../data/fonts/DejaVuSansMono-BoldOblique.ttf");
+	transcoder tr("utf-8");
+
+	boost::shared_ptr<memory_datasource> points = boost::make_shared<memory_datasource>();
+	feature_ptr point_feature(feature_factory::create(0));
+	geometry_type* point = new geometry_type(Point);
+	point->move_to(128, 128);
+	point_feature->add_geometry(point);
+	(*point_feature)["name"] = tr.transcode("Main & Co");
+	points->push(point_feature);
+	add_layer("points", points);
+
+	boost::shared_ptr<memory_datasource> lines = boost::make_shared<memory_datasource>();
+	feature_ptr line_feature(feature_factory::create(1));
+	geometry_type* line = new geometry_type(LineString);
+	line->move_to(16, 16);
+	line->line_to(240, 240);
+	line_feature->add_geometry(line);
+	(*line_feature)["name"] = tr.transcode("High Street");
+	lines->push(line_feature);
+	add_layer("lines", lines);
+
+	map.insert_style("points", feature_type_style());
+	map.insert_style("lines", feature_type_style());
+	map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+    }
+
+    ~F() {}
+};
+
+/*
+ * A point label is a single text tag, whose font attributes are those
+ * of the face that laid it out, and whose characters are escaped.
+ */
+BOOST_FIXTURE_TEST_CASE(point_label_test_case, F)
+{
+    text_symbolizer sym(parse_expression("[name]"), "DejaVu Sans Mono Bold Oblique", 12, color(255, 0, 0));
+    insert_style("points", sym);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<text "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<text xml:space=\"preserve\" x=\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, " font-family=\"DejaVu Sans Mono\" font-size=\"12.0\""
+			    " font-weight=\"bold\" font-style=\"oblique\" fill=\"#ff0000\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, ">Main &amp; Co</text>\n"), 1u);
+    // horizontal labels are not rotated.
+    BOOST_CHECK_EQUAL(occurrences(output, " rotate=\""), 0u);
+}
+
+/*
+ * A halo is a stroked copy of the label, written under it.
+ */
+BOOST_FIXTURE_TEST_CASE(halo_label_test_case, F)
+{
+    text_symbolizer sym(parse_expression("[name]"), "DejaVu Sans Mono Bold Oblique", 12, color(0, 0, 0));
+    sym.set_halo_fill(color(255, 255, 255));
+    sym.set_halo_radius(1.5);
+    insert_style("points", sym);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<text "), 2u);
+    BOOST_CHECK_EQUAL(occurrences(output, " stroke=\"#ffffff\" stroke-width=\"3.0\" stroke-linejoin=\"round\">"), 1u);
+    BOOST_CHECK(output.find(" stroke=\"#ffffff\"") < output.find(" fill=\"#000000\""));
+}
+
+/*
+ * Labels placed along lines have a rotation per glyph.
+ */
+BOOST_FIXTURE_TEST_CASE(line_label_test_case, F)
+{
+    text_symbolizer sym(parse_expression("[name]"), "DejaVu Sans Mono Bold Oblique", 12, color(0, 0, 0));
+    sym.set_label_placement(LINE_PLACEMENT);
+    insert_style("lines", sym);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<text "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, " rotate=\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, ">High Street</text>\n"), 1u);
+}
+
+/*
+ * A shield is the marker's symbol, used under its text.
+ */
+BOOST_FIXTURE_TEST_CASE(shield_test_case, F)
+{
+    path_ptr marker_path(new svg_storage_type);
+    vertex_stl_adapter<svg_path_storage> stl_storage(marker_path->source());
+    svg_path_adapter svg_path(stl_storage);
+    svg_path.move_to(0, 0);
+    svg_path.line_to(100, 0);
+    svg_path.line_to(100, 20);
+    svg_path.line_to(0, 20);
+    svg_path.close_polygon();
+    svg::path_attributes attributes;
+    attributes.fill_color = agg::rgba8(0, 0, 255);
+    marker_path->attributes().add(attributes);
+    marker_path->set_bounding_box(0, 0, 100, 20);
+    marker_cache::insert("text_labels_test.svg", boost::make_shared<marker>(boost::optional<path_ptr>(marker_path)));
+
+    shield_symbolizer sym(parse_expression("[name]"), "DejaVu Sans Mono Bold Oblique", 10, color(255, 255, 255),
+			  parse_path("text_labels_test.svg"));
+    insert_style("points", sym);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<symbol "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, "<use xlink:href=\"#m0\""), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, ">Main &amp; Co</text>\n"), 1u);
+    // the text is written over the shield.
+    BOOST_CHECK(output.find("<use ") < output.find("<text "));
+}
+
+/*
+ * The font family is written in a quoted attribute, so the
+ * characters that would end or break it are escaped.
+ */
+BOOST_AUTO_TEST_CASE(font_family_escape_test_case)
+{
+    svg::text_output_attributes attributes;
+    attributes.set_font_family("Fish & \"Chips\" <Sans>");
+
+    BOOST_CHECK_EQUAL(attributes.font_family(), "Fish &amp; &quot;Chips&quot; &lt;Sans>");
+}
+
+/*
+ * The fill of a polygon is written before its label, whatever the
+ * order of the rule's symbolizers, so that it does not cover the label.
+ */
+BOOST_FIXTURE_TEST_CASE(label_over_path_test_case, F)
+{
+    transcoder tr("utf-8");
+    boost::shared_ptr<memory_datasource> areas = boost::make_shared<memory_datasource>();
+    feature_ptr feature(feature_factory::create(2));
+    geometry_type* square = new geometry_type(Polygon);
+    square->move_to(64, 64);
+    square->line_to(192, 64);
+    square->line_to(192, 192);
+    square->line_to(64, 192);
+    square->line_to(64, 64);
+    feature->add_geometry(square);
+    (*feature)["name"] = tr.transcode("Park");
+    areas->push(feature);
+    add_layer("areas", areas);
+
+    feature_type_style style;
+    mapnik::rule r;
+    r.append(text_symbolizer(parse_expression("[name]"), "DejaVu Sans Mono Bold Oblique", 12, color(255, 0, 0)));
+    r.append(polygon_symbolizer(color(0, 128, 0)));
+    style.add_rule(r);
+    insert_style("areas", style);
+
+    std::string output = render();
+
+    BOOST_CHECK_EQUAL(occurrences(output, "<path "), 1u);
+    BOOST_CHECK_EQUAL(occurrences(output, ">Park</text>\n"), 1u);
+    BOOST_CHECK(output.find("<path ") < output.find("<text "));
+}
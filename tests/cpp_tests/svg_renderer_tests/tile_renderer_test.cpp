@@ -0,0 +1,250 @@
+#define BOOST_TEST_MODULE tile_renderer_test
+
+/*
+ * This test module contains test cases that verify
+ * that svg_tile_renderer splits the map into tiles
+ * in one pass, querying each layer only once.
+ */
+
+// boost.test
+#include <boost/test/included/unit_test.hpp>
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/raster.hpp>
+#include <mapnik/raster_symbolizer.hpp>
+#include <mapnik/svg_tile_renderer.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+// stl
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// test utilities
+#include "map_fixture.hpp"
+
+using namespace mapnik;
+
+/*
+ * Datasource that counts the queries it answers.
+ */
+struct counting_datasource : public memory_datasource
+{
+    counting_datasource() : queries(0) {}
+
+    featureset_ptr features(query const& q) const
+    {
+	++queries;
+	return memory_datasource::features(q);
+    }
+
+    mutable unsigned queries;
+};
+
+/*
+ * Datasource of a raster feature without geometries, as raster
+ * datasources return them.
+ */
+struct raster_datasource : public memory_datasource
+{
+    struct raster_featureset : public Featureset
+    {
+	raster_featureset(feature_ptr const& feature) : feature_(feature) {}
+
+	feature_ptr next()
+	{
+	    feature_ptr feature = feature_;
+	    feature_.reset();
+	    return feature;
+	}
+
+	feature_ptr feature_;
+    };
+
+    raster_datasource(feature_ptr const& feature) : feature_(feature) {}
+
+    featureset_ptr features(query const&) const
+    {
+	return boost::make_shared<raster_featureset>(feature_);
+    }
+
+    box2d<double> envelope() const
+    {
+	return feature_->get_raster()->ext_;
+    }
+
+    feature_ptr feature_;
+};
+
+/*
+ * The fixture map maps a 256x256 extent onto a 256x256 image. Its
+ * "lines" layer has a horizontal line across the top half of the
+ * image (at y = 56 in the image), drawn with a line symbolizer.
+ */
+struct F : map_fixture
+{
+    F() : lines(boost::make_shared<counting_datasource>())
+    {
+	feature_ptr feature(feature_factory::create(0));
+	geometry_type* line = new geometry_type(LineString);
+	line->move_to(10, 200);
+	line->line_to(250, 200);
+	feature->add_geometry(line);
+	lines->push(feature);
+
+	add_layer("lines", lines);
+	insert_style("lines", line_symbolizer(color(255, 0, 0)));
+	map.zoom_to_box(box2d<double>(0, 0, 256, 256));
+    }
+
+    ~F() {}
+
+    /*
+     * Render the map as 'columns' by 'rows' tiles, and return their documents row by row.
+     */
+    std::vector<std::string> render_tiles(unsigned columns, unsigned rows)
+    {
+	std::vector<boost::shared_ptr<svg::output_buffer> > buffers;
+	std::vector<svg::output_buffer_iterator> output_iterators;
+	for(unsigned i = 0; i < columns * rows; ++i)
+	{
+	    buffers.push_back(boost::make_shared<svg::output_buffer>());
+	    output_iterators.push_back(svg::output_buffer_iterator(*buffers.back()));
+	}
+
+	svg_tile_renderer<svg::output_buffer_iterator> renderer(map, columns, rows, output_iterators);
+	renderer.apply();
+
+	std::vector<std::string> documents;
+	for(unsigned i = 0; i < columns * rows; ++i)
+	{
+	    documents.push_back(buffers[i]->str());
+	}
+	return documents;
+    }
+
+    /*
+     * Render a window of the map on its own.
+     */
+    std::string render_window(unsigned x, unsigned y, unsigned width, unsigned height)
+    {
+	buffer_rendering rendering(map, x, y, width, height);
+	return rendering.apply();
+    }
+
+    boost::shared_ptr<counting_datasource> lines;
+};
+
+/*
+ * Each tile is clipped to its own extent, and its features are
+ * written in its own coordinates.
+ */
+BOOST_FIXTURE_TEST_CASE(tile_clipping_test_case, F)
+{
+    std::vector<std::string> documents = render_tiles(2, 2);
+
+    BOOST_REQUIRE_EQUAL(documents.size(), 4u);
+    BOOST_CHECK(documents[0].find("<svg width=\"128px\" height=\"128px\"") != std::string::npos);
+    BOOST_CHECK(documents[0].find("<path d=\"M10 56 L128 56\"") != std::string::npos);
+    BOOST_CHECK(documents[1].find("<path d=\"M0 56 L122 56\"") != std::string::npos);
+    // the line does not cross the bottom tiles.
+    BOOST_CHECK(documents[2].find("<path ") == std::string::npos);
+    BOOST_CHECK(documents[3].find("<path ") == std::string::npos);
+}
+
+/*
+ * The tiles are the same as the windows of the map rendered one by one,
+ * but the layer is queried once for all of them.
+ */
+BOOST_FIXTURE_TEST_CASE(single_pass_test_case, F)
+{
+    std::vector<std::string> documents = render_tiles(3, 2);
+
+    BOOST_CHECK_EQUAL(lines->queries, 1u);
+    BOOST_REQUIRE_EQUAL(documents.size(), 6u);
+    BOOST_CHECK_EQUAL(documents[0], render_window(0, 0, 85, 128));
+    BOOST_CHECK_EQUAL(documents[1], render_window(85, 0, 85, 128));
+    // the last column takes the remaining pixels.
+    BOOST_CHECK_EQUAL(documents[2], render_window(170, 0, 86, 128));
+    BOOST_CHECK_EQUAL(documents[5], render_window(170, 128, 86, 128));
+}
+
+/*
+ * Rasters have no geometries: they are rendered by the tiles that their
+ * extent intersects.
+ */
+BOOST_FIXTURE_TEST_CASE(raster_tiles_test_case, F)
+{
+    image_data_32 data(2, 2);
+    data.set(0xff0000ff);
+    feature_ptr feature(feature_factory::create(1));
+    feature->set_raster(boost::make_shared<raster>(box2d<double>(100, 20, 200, 100), data));
+    boost::shared_ptr<raster_datasource> rasters = boost::make_shared<raster_datasource>(feature);
+
+    layer lyr("raster", map.srs());
+    lyr.set_datasource(rasters);
+    lyr.add_style("raster");
+    map.addLayer(lyr);
+    feature_type_style style;
+    mapnik::rule r;
+    r.append(raster_symbolizer());
+    style.add_rule(r);
+    map.insert_style("raster", style);
+
+    std::vector<std::string> documents = render_tiles(2, 2);
+
+    BOOST_REQUIRE_EQUAL(documents.size(), 4u);
+    // the raster is in the bottom half of the image, across both columns.
+    BOOST_CHECK(documents[0].find("<image ") == std::string::npos);
+    BOOST_CHECK(documents[1].find("<image ") == std::string::npos);
+    BOOST_CHECK(documents[2].find("<image ") != std::string::npos);
+    BOOST_CHECK(documents[3].find("<image ") != std::string::npos);
+}
+
+/*
+ * A tile only embeds the part of a raster that it shows, with the
+ * few pixels around it that the scaling filters read.
+ */
+BOOST_FIXTURE_TEST_CASE(cropped_raster_test_case, F)
+{
+    image_data_32 data(256, 256);
+    data.set(0xff0000ff);
+    feature_ptr feature(feature_factory::create(1));
+    feature->set_raster(boost::make_shared<raster>(box2d<double>(0, 0, 256, 256), data));
+
+    layer lyr("raster", map.srs());
+    lyr.set_datasource(boost::make_shared<raster_datasource>(feature));
+    lyr.add_style("raster");
+    map.addLayer(lyr);
+    feature_type_style style;
+    mapnik::rule r;
+    r.append(raster_symbolizer());
+    style.add_rule(r);
+    map.insert_style("raster", style);
+
+    std::vector<std::string> documents = render_tiles(2, 2);
+
+    BOOST_REQUIRE_EQUAL(documents.size(), 4u);
+    // the filter of the default scaling reads up to 2 pixels
+    // around the tile's 128 pixels (none outside the raster).
+    BOOST_CHECK(documents[0].find("<image x=\"0\" y=\"0\" width=\"130\" height=\"130\"") != std::string::npos);
+    BOOST_CHECK(documents[3].find("<image x=\"-2\" y=\"-2\" width=\"130\" height=\"130\"") != std::string::npos);
+}
+
+/*
+ * There must be one output iterator per tile.
+ */
+BOOST_FIXTURE_TEST_CASE(output_iterators_test_case, F)
+{
+    svg::output_buffer buffer;
+    std::vector<svg::output_buffer_iterator> output_iterators(3, svg::output_buffer_iterator(buffer));
+
+    BOOST_CHECK_THROW(svg_tile_renderer<svg::output_buffer_iterator>(map, 2, 2, output_iterators), std::invalid_argument);
+}
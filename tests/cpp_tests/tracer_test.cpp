@@ -0,0 +1,153 @@
+#include <boost/config/warning_disable.hpp>
+
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/feature_style_processor.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/tracer.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
+using namespace mapnik;
+
+//  --------------------------------------------------------------------------//
+
+// processor that processes nothing.
+struct null_processor : public feature_style_processor<null_processor>
+{
+    explicit null_processor(Map const& m)
+        : feature_style_processor<null_processor>(m) {}
+
+    void start_map_processing(Map const&) {}
+    void end_map_processing(Map const&) {}
+    void start_layer_processing(layer const&) {}
+    void end_layer_processing(layer const&) {}
+
+    template <typename Symbolizer>
+    void process(Symbolizer const&, Feature const&, proj_transform const&) {}
+
+    bool process(rule::symbolizers const&, Feature const&, proj_transform const&)
+    {
+        return false;
+    }
+};
+
+// the phase, name and argument of the events of a trace, like "B layer roads".
+std::vector<std::string> events(std::string const& json)
+{
+    std::vector<std::string> result;
+    // each event is on a line of its own.
+    std::string const name_key = "\n{\"name\":\"";
+    for (std::string::size_type pos = json.find(name_key); pos != std::string::npos;
+         pos = json.find(name_key, pos + 1))
+    {
+        std::string::size_type name = pos + name_key.size();
+        std::string::size_type end = json.find('}', pos);
+        std::string::size_type phase = json.find("\"ph\":\"", pos) + 6;
+        std::string event = json.substr(phase, 1) + " " + json.substr(name, json.find('"', name) - name);
+        std::string::size_type args = json.find("\"args\":{\"name\":\"", pos);
+        if (args < end)
+        {
+            args += 16;
+            event += " " + json.substr(args, json.find("\"}", args) - args);
+        }
+        result.push_back(event);
+    }
+    return result;
+}
+
+void add_layer(Map & m, std::string const& name)
+{
+    boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+    feature_ptr feature(feature_factory::create(0));
+    geometry_type * point = new geometry_type(Point);
+    point->move_to(1, 1);
+    feature->add_geometry(point);
+    ds->push(feature);
+    layer lyr(name, m.srs());
+    lyr.set_datasource(ds);
+    lyr.add_style("points");
+    m.addLayer(lyr);
+}
+
+#ifdef MAPNIK_THREADSAFE
+void trace_phase(tracer * t)
+{
+    trace_scope scope(t, "phase");
+}
+#endif
+
+int main( int, char*[] )
+{
+  Map m(256, 256);
+  feature_type_style style;
+  rule r;
+  r.append(point_symbolizer());
+  style.add_rule(r);
+  m.insert_style("points", style);
+  add_layer(m, "water");
+  add_layer(m, "\"roads\"");
+  m.zoom_to_box(box2d<double>(0, 0, 2, 2));
+
+//  nothing is recorded by default  -------------------------------------------//
+
+  null_processor processor(m);
+  BOOST_TEST( processor.get_tracer() == 0 );
+  processor.apply();
+  {
+    trace_scope scope(0, "nothing");
+  }
+
+//  the phases of the map's processing are nested  ----------------------------//
+
+  tracer t;
+  processor.set_tracer(&t);
+  processor.apply();
+
+  char const* expected[] = {
+    "B map",
+    "B layer water", "B style points", "B query", "E query", "B features", "E features", "E style", "E layer",
+    "B layer \\\"roads\\\"", "B style points", "B query", "E query", "B features", "E features", "E style", "E layer",
+    "E map"
+  };
+  std::string json = t.to_json();
+  BOOST_TEST( json.find("{\"traceEvents\":[\n{\"name\":\"map\",\"cat\":\"render\",\"ph\":\"B\",\"ts\":") == 0 );
+  BOOST_TEST( json.find(",\"pid\":1,\"tid\":1}") != std::string::npos );
+  BOOST_TEST( events(json) == std::vector<std::string>(expected, expected + 18) );
+  BOOST_TEST( t.size() == 18 );
+
+//  images are encoded in an "encode" phase  ----------------------------------//
+
+  t.clear();
+  BOOST_TEST( t.size() == 0 );
+  image_32 image(16, 16);
+  std::string png = save_to_string(image, "png", &t);
+  BOOST_TEST( png == save_to_string(image, "png") );
+  std::vector<std::string> encode = events(t.to_json());
+  BOOST_TEST( encode.size() == 2 );
+  BOOST_TEST( encode.size() == 2 && encode[0] == "B encode png" && encode[1] == "E encode" );
+
+//  events are recorded in the threads that cause them  -----------------------//
+
+#ifdef MAPNIK_THREADSAFE
+  t.clear();
+  trace_phase(&t);
+  boost::thread other(boost::bind(&trace_phase, &t));
+  other.join();
+  json = t.to_json();
+  BOOST_TEST( t.size() == 4 );
+  BOOST_TEST( json.find("\"tid\":1}") != std::string::npos );
+  BOOST_TEST( json.find("\"tid\":2}") != std::string::npos );
+#endif
+
+  return ::boost::report_errors();
+}
@@ -15,6 +15,47 @@ def test_simplest_render():
 
     eq_(s, 256 * 256 * '\x00\x00\x00\x00')
 
+def test_render_with_stats():
+    ds = mapnik2.PointDatasource()
+    ds.add_point(0, 0, 'name', 'a')
+    ds.add_point(1, 1, 'name', 'b')
+    lyr = mapnik2.Layer('points')
+    lyr.datasource = ds
+    lyr.styles.append('points')
+    s = mapnik2.Style()
+    r = mapnik2.Rule()
+    r.filter = mapnik2.Expression("[name] = 'a'")
+    r.symbols.append(mapnik2.PointSymbolizer())
+    s.rules.append(r)
+    m = mapnik2.Map(256, 256)
+    m.append_style('points', s)
+    m.layers.append(lyr)
+    m.zoom_to_box(mapnik2.Box2d(-2, -2, 2, 2))
+
+    stats = mapnik2.render_with_stats(m, mapnik2.Image(m.width, m.height))
+
+    eq_([l.name for l in stats.layers], ['points'])
+    eq_(stats.layers[0].features_fetched, 2)
+    eq_(stats.layers[0].features_matched, 1)
+    eq_([(rule.style, rule.features) for rule in stats.layers[0].rules], [('points', 1)])
+    eq_(stats.symbolizers.keys(), ['point'])
+    eq_(stats.symbolizers['point'].calls, 1)
+    eq_(stats.symbolizers['point'].vertices, 1)
+    ok_(stats.to_json().startswith('{"time":'))
+
+def test_render_metatile():
+    m = mapnik2.Map(512, 512)
+    m.background = mapnik2.Color('white')
+    m.buffer_size = 32
+    meta = mapnik2.Metatile(m, 2, 2)
+    eq_((meta.columns, meta.rows, meta.margin), (2, 2, 32))
+
+    meta.render()
+
+    tile = meta.tile(1, 1)
+    eq_((tile.width(), tile.height()), (256, 256))
+    eq_(meta.encode(1, 1, 'png'), tile.tostring('png'))
+
 def test_render_image_to_string():
     i = mapnik2.Image(256, 256)
     